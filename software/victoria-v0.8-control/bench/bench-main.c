@@ -0,0 +1,330 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: bench-main.c (hot path cycle benchmarks) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+// Built by the bench environment in place of src/ and run under simavr by tools/bench-run.py.
+// Each benchmark calls a firmware hot path many times over a range of inputs. Timer1 counts the CPU cycles of
+// every call and the free RAM is painted before it to find its stack high-water mark, interrupts included.
+// The results go out on the USART, one line per benchmark:
+//   BENCH <name> <calls> <min cycles> <avg cycles> <max cycles> <stack bytes>
+// then a BENCH_END line, and the CPU sleeps with interrupts off, which ends the simulation.
+// Built with BENCH_SERIAL_ONLY=true it runs only the serial output benchmarks and sets up nothing but the USART
+// and Timer1, so that tools/bench-run.py --bench-ref can build it against older revisions for a before/after.
+
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#include "victoria-control.h"
+
+#ifndef BENCH_SERIAL_ONLY
+#define BENCH_SERIAL_ONLY false  // True: serial output benchmarks only (set by tools/bench-run.py --bench-ref)
+#endif  // BENCH_SERIAL_ONLY
+
+#define STACK_PAINT 0xC5   // Free RAM fill pattern
+#define STACK_GUARD 16     // Bytes kept unpainted below the stack pointer of the painting function
+#define BENCH_BUFFER 32    // ADC readouts of the averaging benchmarks
+
+// Result lines
+static const char __flash str_bench[] = {"BENCH "};
+static const char __flash str_bench_end[] = {"BENCH_END\n"};
+static const char __flash str_bench_empty[] = {"empty"};
+#if !(BENCH_SERIAL_ONLY)
+static const char __flash str_bench_ntc[] = {"ntc_temperature"};
+static const char __flash str_bench_average[] = {"average_adc"};
+static const char __flash str_bench_push[] = {"push_adc_buffer"};
+static const char __flash str_bench_digital[] = {"check_digital_sensors"};
+static const char __flash str_bench_modulate[] = {"modulate_heat"};
+#endif  // BENCH_SERIAL_ONLY
+static const char __flash str_bench_tx_num[] = {"serial_tx_num"};
+static const char __flash str_bench_tx_num_4[] = {"serial_tx_num_4"};
+static const char __flash str_bench_tx_temp[] = {"serial_tx_temp"};
+#if (SHOW_DASHBOARD && !(BENCH_SERIAL_ONLY))
+static const char __flash str_bench_dash_full[] = {"dashboard_full"};
+static const char __flash str_bench_dash_update[] = {"dashboard_update"};
+#endif  // SHOW_DASHBOARD && !BENCH_SERIAL_ONLY
+
+extern uint8_t __heap_start;  // First free RAM byte above .data, .bss and .noinit (avr-libc linker script)
+
+typedef void (*BenchRun)(uint16_t call);
+
+typedef struct bench_result {
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint32_t total_cycles;
+    uint16_t max_stack;
+} BenchResult;
+
+#if !(BENCH_SERIAL_ONLY)
+static SysInfo sys_info;
+static SysInfo *p_system = &sys_info;
+static AdcBuffers buffer_pack;
+static uint16_t adc_samples[BENCH_BUFFER];
+#endif  // BENCH_SERIAL_ONLY
+static uint32_t random_state = 1;
+static uint16_t call_overhead = 0;  // Cycles of an empty benchmark call, subtracted from each result
+static uint8_t *p_stack_top;        // Highest painted byte of the current call
+
+#if LOOP_PROFILER
+// The loop profiler owns Timer1, its cycle counter is the same one
+#define StartCycleCounter StartProfiler
+#define BenchCycles GetCycles
+#else
+static volatile uint16_t timer1_overflows = 0;  // High word of the CPU cycle counter
+
+// Function StartCycleCounter: Sets Timer1 up as a free-running CPU cycle counter
+static void StartCycleCounter(void) {
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);  // No prescaler: one count per CPU cycle
+    TCNT1 = 0;
+    TIFR1 = (1 << TOV1);
+    TIMSK1 |= (1 << TOIE1);
+}
+
+// Function BenchCycles: Returns the CPU cycles elapsed since StartCycleCounter
+static uint32_t BenchCycles(void) {
+    uint16_t high;
+    uint16_t low;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        low = TCNT1;
+        high = timer1_overflows;
+        if ((TIFR1 & (1 << TOV1)) && (low < 0x8000)) {
+            high++;
+        }
+    }
+    return ((uint32_t)high << 16) | low;
+}
+
+// Timer1 overflow interrupt service routine: High word of the cycle counter
+ISR(TIMER1_OVF_vect) {
+    timer1_overflows++;
+}
+#endif  // LOOP_PROFILER
+
+// Function RandomAdc: Returns a pseudo-random 10-bit ADC readout (32-bit LCG, repeatable)
+static uint16_t RandomAdc(void) {
+    random_state = (random_state * 1664525UL) + 1013904223UL;
+    return (uint16_t)(random_state >> 22);
+}
+
+// Function PaintStack: Fills the free RAM between the heap start and the caller's stack frame
+static void __attribute__((noinline)) PaintStack(void) {
+    p_stack_top = (uint8_t *)SP - STACK_GUARD;
+    for (uint8_t *p_byte = &__heap_start; p_byte < p_stack_top; p_byte++) {
+        *p_byte = STACK_PAINT;
+    }
+}
+
+// Function StackUsed: Returns the stack bytes used below the painted top since PaintStack
+static uint16_t __attribute__((noinline)) StackUsed(void) {
+    uint8_t *p_byte = &__heap_start;
+    while ((p_byte < p_stack_top) && (*p_byte == STACK_PAINT)) {
+        p_byte++;
+    }
+    return (uint16_t)(p_stack_top - p_byte);
+}
+
+// Function RunBench: Times a benchmark over a number of calls, sends its result line and returns its minimum cycles
+static uint32_t RunBench(const __flash char *p_name, BenchRun run, uint16_t calls) {
+    BenchResult result = {UINT32_MAX, 0, 0, 0};
+    for (uint16_t call = 0; call < calls; call++) {
+        while (UCSR0B & (1 << UDRIE0)) {
+            // Start each call with an empty transmission queue, so that no call waits for the serial line.
+            // The USART data register empty interrupt is turned off when the queue runs out, in every revision
+        }
+        PaintStack();
+        uint32_t start = BenchCycles();
+        run(call);
+        uint32_t cycles = BenchCycles() - start;
+        uint16_t stack = StackUsed();
+        cycles = (cycles > call_overhead) ? (cycles - call_overhead) : 0;
+        if (cycles < result.min_cycles) {
+            result.min_cycles = cycles;
+        }
+        if (cycles > result.max_cycles) {
+            result.max_cycles = cycles;
+        }
+        if (stack > result.max_stack) {
+            result.max_stack = stack;
+        }
+        result.total_cycles += cycles;
+    }
+    SerialTxStr(str_crlf);  // Ends the line of the characters sent by the benchmark itself
+    SerialTxStr(str_bench);
+    SerialTxStr(p_name);
+    SerialTxChr(' ');
+    SerialTxNum(calls, DIGITS_FREE);
+    SerialTxChr(' ');
+    SerialTxNum(result.min_cycles, DIGITS_FREE);
+    SerialTxChr(' ');
+    SerialTxNum(result.total_cycles / calls, DIGITS_FREE);
+    SerialTxChr(' ');
+    SerialTxNum(result.max_cycles, DIGITS_FREE);
+    SerialTxChr(' ');
+    SerialTxNum(result.max_stack, DIGITS_FREE);
+    SerialTxChr('\n');
+    return result.min_cycles;
+}
+
+//
+// Benchmarks
+//
+
+// Bench empty: Call and timing overhead, measured first and subtracted from the others
+static void BenchEmpty(uint16_t call) {
+}
+
+#if !(BENCH_SERIAL_ONLY)
+// Bench ntc_temperature: Every ADC code through the NTC lookup
+static void BenchNtcTemperature(uint16_t call) {
+    GetNtcTemperature(call & ADC_MAX, TO_CELSIUS, DT_CELSIUS);
+}
+
+// Bench average_adc: Mean of a full buffer of random readouts, from every start position
+static void BenchAverageAdc(uint16_t call) {
+    adc_samples[call % BENCH_BUFFER] = RandomAdc();
+    AverageAdc(adc_samples, BENCH_BUFFER, call % BENCH_BUFFER, MEAN);
+}
+
+// Bench push_adc_buffer: A new readout into a sensor ring buffer and its running sum average
+static void BenchPushAdcBuffer(uint16_t call) {
+    PushAdcBuffer(&buffer_pack.dhw_temp_adc_buffer, RandomAdc());
+    AverageAdcBuffer(&buffer_pack.dhw_temp_adc_buffer, MOVING);
+}
+
+// Bench check_digital_sensors: Input flags update from the debounced inputs
+static void BenchCheckDigitalSensors(uint16_t call) {
+    CheckDigitalSensors(p_system, false);
+}
+
+// Bench modulate_heat: Heat modulator steps through whole DHW cycles at every heat level
+static void BenchModulateHeat(uint16_t call) {
+    p_system->current_heat_level = (call / 8) % HEAT_LEVELS;
+    if ((call % 8) == 0) {
+        p_system->cycle_in_progress = false;
+    }
+    ModulateHeat(p_system, p_system->current_heat_level, DHW_CYCLE);
+}
+#endif  // BENCH_SERIAL_ONLY
+
+// Bench serial_tx_num: Unpadded 32-bit numbers of every length, as in the event log and statistics dumps
+static void BenchSerialTxNum(uint16_t call) {
+    SerialTxNum((uint32_t)RandomAdc() << (call % 23), DIGITS_FREE);
+}
+
+// Bench serial_tx_num_4: Zero-padded 4-digit readouts, as in the dashboard fields
+static void BenchSerialTxNum4(uint16_t call) {
+    SerialTxNum(call % 10000, DIGITS_4);
+}
+
+// Bench serial_tx_temp: Temperatures in tenths of a degree across the NTC range, negatives included
+static void BenchSerialTxTemp(uint16_t call) {
+    SerialTxTemp((int)(call % 1200) - 200);
+}
+
+#if !(BENCH_SERIAL_ONLY)
+#if SHOW_DASHBOARD
+// Bench dashboard_full: Forced whole dashboard redraw, the rows that fit in the transmission queue
+static void BenchDashboardFull(uint16_t call) {
+    Dashboard(p_system, true);
+}
+
+// Bench dashboard_update: Dashboard update with the temperatures and a flag changed
+static void BenchDashboardUpdate(uint16_t call) {
+    p_system->dhw_temperature = 300 + (call & 0x3F);
+    p_system->ch_temperature = 400 - (call & 0x3F);
+    p_system->input_flags ^= (1 << DHW_REQUEST_F);
+    Dashboard(p_system, false);
+}
+#endif  // SHOW_DASHBOARD
+
+// Function InitSystem: Sets the system state up like main does, with the burner on duty
+static void InitSystem(void) {
+    HeatModulator gas_modulator[] = {
+        {VALVE_1, VALVE_1_F, VALVE_1_KCAL_H, VALVE_1_GAS_LH, false},
+        {VALVE_2, VALVE_2_F, VALVE_2_KCAL_H, VALVE_2_GAS_LH, false},
+        {VALVE_3, VALVE_3_F, VALVE_3_KCAL_H, VALVE_3_GAS_LH, false}};
+    p_system->system_mode = 900;
+    p_system->system_state = DHW_ON_DUTY;
+    p_system->inner_step = DHW_ON_DUTY_1;
+    p_system->input_flags = (1 << DHW_REQUEST_F) | (1 << FLAME_F);
+    p_system->output_flags = 0;
+    p_system->last_displayed_iflags = 0;
+    p_system->last_displayed_oflags = 0;
+    p_system->dhw_temperature = 320;
+    p_system->ch_temperature = 400;
+    p_system->dhw_setting = 512;
+    p_system->ch_setting = 512;
+    p_system->error = ERROR_000;
+    p_system->error_retries = 0;
+    p_system->locked_out = false;
+    p_system->ignition_tries = 1;
+    p_system->ch_on_duty_step = CH_ON_DUTY_1;
+    p_system->cycle_in_progress = false;
+    p_system->current_heat_level = 0;
+    p_system->current_valve = 0;
+    p_system->pump_timer_memory = 0;
+    p_system->ch_water_overheat = false;
+    for (uint8_t valve = 0; valve < HEAT_MODULATOR_VALVES; valve++) {
+        p_system->heat_modulator[valve] = gas_modulator[valve];
+    }
+    InitAdcBuffers(&buffer_pack, BUFFER_LENGTH);
+    InitFlags(p_system, INPUT_FLAGS);
+    InitFlags(p_system, OUTPUT_FLAGS);
+    for (OutputFlag device = EXHAUST_FAN_F; device <= LED_UI_F; device++) {
+        InitActuator(p_system, device);
+    }
+    for (InputFlag digital_sensor = DHW_REQUEST_F; digital_sensor <= OVERHEAT_F; digital_sensor++) {
+        InitDigitalSensor(p_system, digital_sensor);
+    }
+    InitParams();
+}
+#endif  // BENCH_SERIAL_ONLY
+
+// Main function
+int main(void) {
+    SerialInit();
+#if BENCH_SERIAL_ONLY
+    sei();
+#else
+    InitSystem();
+    SetTimer(HEAT_TIMER_ID, HEAT_TIMER_DURATION, HEAT_TIMER_MODE);
+    sei();
+    SetTickTimer();
+    StartDebounceEngine();
+#endif  // BENCH_SERIAL_ONLY
+    StartCycleCounter();
+
+    call_overhead = (uint16_t)RunBench(str_bench_empty, BenchEmpty, 64);
+
+#if !(BENCH_SERIAL_ONLY)
+    RunBench(str_bench_ntc, BenchNtcTemperature, ADC_MAX + 1);
+    RunBench(str_bench_average, BenchAverageAdc, 1024);
+    RunBench(str_bench_push, BenchPushAdcBuffer, 1024);
+    RunBench(str_bench_digital, BenchCheckDigitalSensors, 256);
+    RunBench(str_bench_modulate, BenchModulateHeat, HEAT_LEVELS * 8);
+#endif  // BENCH_SERIAL_ONLY
+    RunBench(str_bench_tx_num, BenchSerialTxNum, 256);
+    RunBench(str_bench_tx_num_4, BenchSerialTxNum4, 256);
+    RunBench(str_bench_tx_temp, BenchSerialTxTemp, 256);
+#if (SHOW_DASHBOARD && !(BENCH_SERIAL_ONLY))
+    RunBench(str_bench_dash_full, BenchDashboardFull, 4);
+    RunBench(str_bench_dash_update, BenchDashboardUpdate, 64);
+#endif  // SHOW_DASHBOARD && !BENCH_SERIAL_ONLY
+
+    SerialTxStr(str_bench_end);
+    _delay_ms(200);  // Let the transmission queue drain
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();  // Sleeping with interrupts off ends the simavr run
+    for (;;) {
+    }
+    return 0;
+}
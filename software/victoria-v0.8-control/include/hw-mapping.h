@@ -17,6 +17,9 @@
 #define FLAME_PIN PIN2
 #define FLAME_PINP PIND
 #define FLAME_PORT PORTD
+#define FLAME_INT INT0        // External interrupt of the flame detector pin
+#define FLAME_ISC ISC00       // Sense control bit 0 of its interrupt: any logical change
+#define FLAME_vect INT0_vect  // External interrupt vector of the flame detector pin
 // Exhaust fan (mini-pro pin 3 - output)
 #define FAN_DDR DDRD
 #define FAN_PIN PIN3
@@ -57,6 +60,10 @@
 #define OVERHEAT_PIN PIN2
 #define OVERHEAT_PINP PINB
 #define OVERHEAT_PORT PORTB
+#define OVERHEAT_PCINT PCINT2      // Pin change interrupt of the overheat thermostat pin
+#define OVERHEAT_PCMSK PCMSK0      // Pin change mask register of its port
+#define OVERHEAT_PCIE PCIE0        // Pin change interrupt enable bit of its port
+#define OVERHEAT_vect PCINT0_vect  // Pin change interrupt vector of its port
 // Domestic Hot Water request (mini-pro pin 11 - input)
 #define DHW_RQ_DDR DDRB
 #define DHW_RQ_PIN PIN3
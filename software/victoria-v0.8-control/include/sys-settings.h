@@ -28,14 +28,44 @@
 #define DHW_HEAT_CYCLE_TIME 15000  // DHW heat modulator cycle time (milliseconds)
 #define CH_HEAT_CYCLE_TIME 20000   // CH heat modulator cycle time (milliseconds)
 
+// DHW closed-loop control (temperatures in tenths of a degree Celsius)
+#define DHW_CLOSED_LOOP true   // True: A PI controller holds the DHW temperature set by the DHW knob. False: The DHW knob selects the heat level directly
+#define DHW_TARGET_MIN 350     // DHW target temperature at the lowest DHW knob position
+#define DHW_TARGET_MAX 600     // DHW target temperature at the highest DHW knob position
+#define DHW_PI_KP 26           // DHW proportional gain (1/256 heat level steps per tenth of a degree, 26 ~ 1 step per degree)
+#define DHW_PI_KI 4            // DHW integral gain, integrated once per DHW heat cycle (1/256 heat level steps per tenth of a degree)
+#define DHW_PI_START_LEVEL 14  // Heat level preset in the integral term when the DHW service starts
+
+// CH closed-loop control (temperatures in tenths of a degree Celsius)
+#define CH_CLOSED_LOOP true     // True: A PI controller holds the CH flow temperature set by the CH knob. False: The CH knob selects the heat level and the burner cycles between CH_SETPOINT_HIGH and CH_SETPOINT_LOW
+#define CH_TARGET_MIN 350       // CH flow target temperature at the lowest CH knob position
+#define CH_TARGET_MAX 550       // CH flow target temperature at the highest CH knob position (plus CH_MAX_OVERSHOOT, it must stay below the Error 010 limit)
+#define CH_PI_KP 77             // CH proportional gain (1/256 heat level steps per tenth of a degree, 77 ~ 3 steps per degree)
+#define CH_PI_KI 20             // CH integral gain, integrated once per CH heat cycle (1/256 heat level steps per tenth of a degree)
+#define CH_PI_START_LEVEL 14    // Heat level preset in the CH integral term at start-up, then it follows the CH load
+#define CH_OFF_HYSTERESIS 30    // The burner stops this far above the CH target, once it has run for CH_MIN_ON_TIME
+#define CH_ON_HYSTERESIS 50     // The burner restarts this far below the CH target, once it has been off for CH_MIN_OFF_TIME
+#define CH_MAX_OVERSHOOT 80     // The burner stops this far above the CH target even before CH_MIN_ON_TIME
+#define CH_MIN_ON_TIME 180000   // Anti-cycling: minimum CH burner run (milliseconds)
+#define CH_MIN_OFF_TIME 300000  // Anti-cycling: minimum CH burner pause (milliseconds)
+
 #define MAX_IGNITION_TRIES 3  // Number of ignition retries when no flame is detected
 
 #define DHW_SETTING_STEPS 12  // DHW setting potentiometer steps
 #define CH_SETTING_STEPS 12   // CH setting potentiometer steps
 #define SYSTEM_MODE_STEPS 4   // System mode potentiometer steps
 
-#define SYSTEM_TIMERS 6          // Number of system timers
+// ADC input filters: FILTER_NONE, FILTER_MEAN, FILTER_ROBUST, FILTER_FIR, FILTER_IIR or FILTER_MEDIAN
+#define DHW_TEMP_FILTER FILTER_FIR    // DHW NTC thermistor readout filter
+#define CH_TEMP_FILTER FILTER_FIR     // CH NTC thermistor readout filter
+#define DHW_SET_FILTER FILTER_IIR     // DHW setting potentiometer readout filter
+#define CH_SET_FILTER FILTER_IIR      // CH setting potentiometer readout filter
+#define SYS_MOD_FILTER FILTER_MEDIAN  // System mode potentiometer readout filter
+
+#define SYSTEM_TIMERS 5          // Number of system timers
+#define SYSTEM_TASKS 7           // Number of cooperative system tasks
 #define HEAT_MODULATOR_VALVES 3  // Number of heat modulator valves
+#define HEAT_CYCLES 2            // Heat cycle types: DHW and CH
 
 #define OVERHEAT_OVERRIDE false    // True: Overheating thermostat override
 #define AIRFLOW_OVERRIDE true      // True: Flue airflow sensor override
@@ -43,15 +73,25 @@
 #define LED_UI_FOR_FLAME true      // True: Activates onboard LED when the flame detector is on
 #define SHOW_DASHBOARD true        // True: Displays the system dashboard on a serial terminal
 #define SHOW_PUMP_TIMER true       // True: Shows the CH water pump auto-shutdown timer
+#define SERIAL_TELEMETRY false     // True: Sends binary telemetry frames (COBS + CRC-16) on the serial port, needs SHOW_DASHBOARD false
+#define SERIAL_SHELL false         // True: Accepts commands on the serial port (parameters, event log, statistics, dashboard frames), needs SERIAL_TELEMETRY and SHOW_DASHBOARD false
+#define SHELL_SENSOR_SIM false     // True: ONLY FOR TEST BUILDS!!! The shell sim command forces the digital inputs seen by the FSM
+#define LOOP_PROFILER false        // True: Measures the task loop with Timer1 (run times per task, pass time histogram) for the dashboard and telemetry
 #define SERIAL_DEBUG false         // True: Shows current heat level and valve timing instead of the dashboard
-#define LED_DEBUG false            // True: ONLY FOR DEBUG!!! Toggles SPARK_IGNITER_F on each heat-cycle start and keeps it on to show cycle's valve-time errors
+#define LED_DEBUG false            // True: ONLY FOR DEBUG!!! Toggles SPARK_IGNITER_F at the end of each heat cycle
 #define HEAT_MODULATOR_DEMO false  // True: ONLY FOR DEBUG!!! loops through all heat levels, from lower to higher. False: NORMAL OPERATION -> Heat modulator code reads DHW potentiometer to determine current heat level
-#define TIMER_INDEX_OVF_STOP true  // True: halt system if the system doesn't have enough timer slots (index overflow)!
 
-#if SHOW_DASHBOARD
+#define DASHBOARD_FRAMES (SHOW_DASHBOARD || SERIAL_SHELL)  // Dashboard renderer built: the periodic dashboard, or the shell dash command frames
+
+#if DASHBOARD_FRAMES
 #define DASHBOARD_LANG _ES_        // Dashboard language: _EN_=English, _ES_=Spanish
+#endif                             // DASHBOARD_FRAMES
+#if SHOW_DASHBOARD
 #define AUTO_DHW_DSP_REFRESH true  // True: Force a dashboard refresh when in a DHW_ON_DUTY loop every DLY_DHW_ON_DUTY_LOOP ms
 #define AUTO_CH_DSP_REFRESH true   // True: Force a dashboard refresh when in a CH_ON_DUTY loop every DLY_CH_ON_DUTY_LOOP ms
+#define DASHBOARD_DIFF true        // True: Draws the dashboard layout once, then updates only the fields that changed
+#else
+#define DASHBOARD_DIFF false       // The shell dash command frames are whole redraws, the shell owns the cursor
 #endif                             // SHOW_DASHBOARD
 
 #define FSM_TIMER_ID 1                    // Main finite state machine timer id
@@ -71,17 +111,49 @@
 #define PUMP_TIMER_DURATION 600000         // Water pump timer time-lapse (milliseconds)
 #define PUMP_TIMER_MODE RUN_ONCE_AND_HOLD  // Water pump timer mode
 
-#define DEB_FLAME_TIMER_ID 4                    // Flame detector debounce timer id
-#define DEB_FLAME_TIMER_DURATION 500            // Flame detector debounce timer time-lapse
-#define DEB_FLAME_TIMER_MODE RUN_ONCE_AND_HOLD  // Flame detector debounce timer mode
-
-#define DEB_CH_SWITCH_TIMER_ID 5                    // Central heating thermostat switch debounce timer id
-#define DEB_CH_SWITCH_TIMER_DURATION 250            // Central heating thermostat switch debounce timer time-lapse
-#define DEB_CH_SWITCH_TIMER_MODE RUN_ONCE_AND_HOLD  // Central heating thermostat switch debounce timer mode
-
-#define DEB_AIRFLOW_TIMER_ID 6                    // Airflow sensor switch debounce timer id
-#define DEB_AIRFLOW_TIMER_DURATION 125            // Airflow sensor switch debounce timer time-lapse
-#define DEB_AIRFLOW_TIMER_MODE RUN_ONCE_AND_HOLD  // Airflow sensor switch debounce timer mode
+#define GAS_OFF_TIMER_ID 4    // Staged gas shutdown timer id (runs only while the heat valves and fan are being turned off)
+#define GAS_OFF_STEP_DELAY 5  // Time between the staged gas shutdown steps (milliseconds)
+
+#define ERROR_TIMER_ID 5  // Error automatic retry backoff timer id
+
+// Digital input debouncing: an input changes after 4 consecutive samples that differ from its stable value, sampled every time / 4 ms
+#define DEB_DHW_REQUEST_TIME 20  // DHW request switch debounce time (milliseconds)
+#define DEB_CH_REQUEST_TIME 250  // Central heating thermostat switch debounce time (milliseconds)
+#define DEB_AIRFLOW_TIME 125     // Airflow sensor switch debounce time (milliseconds)
+#define DEB_FLAME_TIME 500       // Flame detector debounce time (milliseconds)
+#define DEB_OVERHEAT_TIME 20     // Overheat thermostat debounce time (milliseconds)
+
+// Safety fast path: flame loss (INT0) and overheat (PCINT) edges close the security valve from interrupt context
+#define SAFETY_FAST_PATH true       // True: Enables the interrupt-driven security valve shutdown
+#define SAFETY_FLAME_LOSS_TIME 250  // Flame loss confirmation time while the burner is lit (1.024 ms system ticks, up to DEB_FLAME_TIME)
+#define SAFETY_OVERHEAT_TIME 10     // Overheat confirmation time (1.024 ms system ticks, up to DEB_OVERHEAT_TIME)
+
+// Cooperative tasks, run in id order when due (periods in milliseconds)
+#define SENSORS_TASK_ID 1         // Sensor sampling and safety checks task id
+#define SENSORS_TASK_PERIOD 5     // Sensor sampling period (the ADC engine refreshes each channel every ~5 ms)
+#define FSM_TASK_ID 2             // Finite state machine step task id
+#define FSM_TASK_PERIOD 5         // Finite state machine step period (shortest FSM delay is 10 ms)
+#define HEAT_TASK_ID 3            // Heat modulator task id
+#define HEAT_TASK_PERIOD 10       // Heat modulator period
+#define DASHBOARD_TASK_ID 4       // Serial dashboard task id
+#define DASHBOARD_TASK_PERIOD 50  // Serial dashboard period
+#define WATCHDOG_TASK_ID 5        // Watchdog service task id
+#define WATCHDOG_TASK_PERIOD 100  // Watchdog service period (the WDT timeout is 8 s)
+#define TELEMETRY_TASK_ID 6       // Binary telemetry task id
+#define TELEMETRY_TASK_PERIOD 50  // Telemetry frame period (20 frames per second)
+#define SHELL_TASK_ID 7           // Serial command shell task id
+#define SHELL_TASK_PERIOD 2       // Serial command shell period (one received character per run)
+#define ENABLE_IDLE_SLEEP true    // True: The MCU sleeps in idle mode until the next system tick when no task is due
+
+// EEPROM layout (ATmega328: 1024 bytes)
+#define EVENT_LOG_ADDRESS 0           // Event log ring start address
+#define EVENT_LOG_RECORDS 48          // Event log ring length (16-byte records, 768 bytes)
+#define EVENT_LOG_DUMP_AT_START true  // True: Sends the event log over serial at start-up
+#define STATS_ADDRESS 768             // Burner statistics start address (after the event log)
+#define STATS_SAVE_PERIOD 3600000     // Minimum time between burner statistics saves, only when they changed (milliseconds)
+#define STATS_SHORT_CYCLE 180         // Burner runs shorter than this count as short cycles (seconds)
+#define STATS_DUMP_AT_START true      // True: Sends the burner statistics over serial at start-up
+#define PARAMS_ADDRESS 928            // Runtime parameters start address (after the burner statistics)
 
 // FSM non-blocking delay times (milliseconds)
 #define DLY_OFF_2 10                                      // Off_2: Time before turning the fan for the flue exhaust test
@@ -93,16 +165,29 @@
 #define DLY_IGNITING_3 250                                // Igniting_3: Time before opening the security valve after the fan is running
 #define DLY_IGNITING_4 125                                // Igniting_4: Time before opening the valve 1 (or 2) after opening the security valve
 #define DLY_IGNITING_5 25                                 // Igniting_5: Time before turning the spark igniter on while the valve 1 (or 2) is open
-#define DLY_IGNITING_6 (DEB_FLAME_TIMER_DURATION + 2500)  // Igniting_6: Waiting time for flame lit with gas open and spark igniter on before retrying
+#define DLY_IGNITING_6 (DEB_FLAME_TIME + 2500)            // Igniting_6: Waiting time for flame lit with gas open and spark igniter on before retrying
 
 #if SHOW_DASHBOARD
 #define DLY_DHW_ON_DUTY_LOOP 3000  // DHW_on_Duty: Dashboard refreshing time when looping through DHW on-duty mode
 #define DLY_CH_ON_DUTY_LOOP 3000   // CH_on_Duty: Dashboard refreshing time when looping through CH on-duty mode
 #endif
 
+// ERROR state presenter and lockout
+#define ERROR_BLINK_TIME 250    // LED_UI on and off time of each error code blink (milliseconds)
+#define ERROR_PAUSE_TIME 2000   // LED_UI off time between error code repetitions (milliseconds)
+#define ERROR_RETRY_DELAY 1000  // Time before the first automatic retry after an error, doubled on each consecutive error (milliseconds)
+#define ERROR_MAX_RETRIES 3     // Consecutive automatic retries before a lockout, only the SYS_RESET knob position releases it
+
 #define BLINKS_AT_START 5    // Number of LED_UI blinks to show firmware execution start
 #define BLINK_AT_ST_DLY 250  // Delay between start indication blinks
 
+// OFF and RESET mode indication, shown while the system mode knob is in one of those positions
+#define OFF_BLINK_TOGGLES 6     // LED_UI toggles of each OFF mode indication, one '.' sent on each
+#define OFF_BLINK_TIME 100      // Time between OFF mode indication toggles (milliseconds)
+#define RESET_BLINK_TOGGLES 14  // LED_UI toggles of each RESET mode indication, one '*' sent on each
+#define RESET_BLINK_TIME 50     // Time between RESET mode indication toggles (milliseconds)
+#define MODE_PAUSE_TIME 125     // Pause between mode indication repetitions (milliseconds)
+
 // System types
 
 typedef enum system_modes {
@@ -169,7 +254,8 @@ typedef enum inner_steps {
     DHW_ON_DUTY_2 = 32,
     DHW_ON_DUTY_3 = 33,
     CH_ON_DUTY_1 = 41,
-    CH_ON_DUTY_2 = 42
+    CH_ON_DUTY_2 = 42,
+    ERROR_1 = 101
 } InnerStep;
 
 typedef enum heat_valves {
@@ -178,20 +264,48 @@ typedef enum heat_valves {
     VALVE_3 = 2
 } HeatValve;
 
+typedef enum heat_cycles {
+    DHW_CYCLE = 0,
+    CH_CYCLE = 1
+} HeatCycle;
+
 typedef struct heat_level {
-    uint8_t valve_open_time[HEAT_MODULATOR_VALVES];
-    uint16_t kcal_h;
-    float gas_usage;
+    uint16_t valve_time[HEAT_CYCLES][HEAT_MODULATOR_VALVES];  // Valve open time on each heat cycle type (milliseconds)
+    uint16_t kcal_h;                                          // Heat output (kcal/h)
+    uint16_t gas_lh;                                          // G20 gas usage (litres/h)
 } HeatLevel;
 
 typedef struct heat_modulator {
     HeatValve heat_valve;  // Heat valve ID
     InputFlag valve_flag;  // Valve flag id number
     uint16_t kcal_h;       // Kcal per hour
-    float gas_usage;       // Gas usage per hour
+    uint16_t gas_lh;       // G20 gas usage (litres per hour)
     bool status;           // Valve status
 } HeatModulator;
 
+// Runtime tuning parameters: lib/params loads them from EEPROM at start-up, the defines above are their defaults
+typedef struct sys_params {
+    uint32_t pump_timer_duration;            // PUMP_TIMER_DURATION
+    uint16_t dhw_heat_cycle_time;            // DHW_HEAT_CYCLE_TIME
+    uint16_t ch_heat_cycle_time;             // CH_HEAT_CYCLE_TIME
+    uint16_t ch_setpoint_high;               // CH_SETPOINT_HIGH
+    uint16_t ch_setpoint_low;                // CH_SETPOINT_LOW
+    uint16_t dly_off_2;                      // DLY_OFF_2
+    uint16_t dly_off_3;                      // DLY_OFF_3
+    uint16_t dly_off_4;                      // DLY_OFF_4
+    uint16_t dly_ready_1;                    // DLY_READY_1
+    uint16_t dly_igniting_1;                 // DLY_IGNITING_1
+    uint16_t dly_igniting_2;                 // DLY_IGNITING_2
+    uint16_t dly_igniting_3;                 // DLY_IGNITING_3
+    uint16_t dly_igniting_4;                 // DLY_IGNITING_4
+    uint16_t dly_igniting_5;                 // DLY_IGNITING_5
+    uint16_t dly_igniting_6;                 // DLY_IGNITING_6
+    uint16_t debounce_time[OVERHEAT_F + 1];  // DEB_*_TIME, in InputFlag order
+    uint8_t max_ignition_tries;              // MAX_IGNITION_TRIES
+} SysParams;
+
+extern SysParams sys_params;  // Runtime tuning parameters, plain RAM reads on the hot paths
+
 typedef struct sys_info {
     State system_state;                                   // System FSM running state
     InnerStep inner_step;                                 // System FSM state inner step (sub-states)
@@ -206,6 +320,8 @@ typedef struct sys_info {
     uint8_t last_displayed_oflags;                        // Hardware activation flags last shown status
     uint8_t ignition_tries;                               // Burner ignition attempts counter
     uint8_t error;                                        // System error code
+    uint8_t error_retries;                                // Consecutive automatic retries after errors, cleared when a service starts
+    bool locked_out;                                      // Too many consecutive errors, the ERROR state holds until a manual reset
     uint32_t pump_timer_memory;                           // CH water pump auto-shutdown timer memory
     bool ch_water_overheat;                               // Unexpected central heating water overtemperature flag
     InnerStep ch_on_duty_step;                            // CH inner step before handing over control to DHW
@@ -14,13 +14,39 @@
 
 #include <avr/io.h>
 #include <avr/pgmspace.h>
+#include <burner-stats.h>
+#include <event-log.h>
+#include <fsm.h>
 #include <hal.h>
+#include <heat-control.h>
+#include <params.h>
+#include <profiler.h>
 #include <serial-ui.h>
+#include <shell.h>
 #include <stdbool.h>
+#include <tasks.h>
+#include <telemetry.h>
 #include <timers.h>
 #include <util/delay.h>
 
 #include "errors.h"
 #include "sys-settings.h"
 
+// Types
+
+typedef struct task_data {
+    SysInfo *p_system;
+    AdcBuffers *p_buffer_pack;
+} TaskData;
+
+// Prototypes
+
+void SensorsTask(void *p_data);
+void FsmTask(void *p_data);
+void HeatTask(void *p_data);
+void DashboardTask(void *p_data);
+void WatchdogTask(void *p_data);
+void TelemetryTask(void *p_data);
+void ShellTask(void *p_data);
+
 #endif  // VICTORIA_CONTROL_H
@@ -0,0 +1,147 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: burner-stats.c (burner runtime statistics library) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "burner-stats.h"
+
+_Static_assert(sizeof(BurnerStats) == STATS_RECORD_SIZE, "STATS_RECORD_SIZE doesn't match the BurnerStats layout");
+
+static BurnerStats burner_stats;          // Running totals
+static BurnerStats stats_snapshot;        // Copy being written to EEPROM, the totals keep changing meanwhile
+static volatile bool stats_saved = true;  // The snapshot has been written
+static uint32_t last_save = 0;            // Time of the last save (milliseconds)
+static bool stats_dirty = false;          // The totals changed since the last save
+
+static uint32_t last_update = 0;          // Time of the last UpdateBurnerStats run (milliseconds)
+static uint32_t flame_start = 0;          // Time when the flame was lit (milliseconds)
+static bool flame_on = false;             // Flame status in the last update
+static uint16_t flame_ms = 0;             // Flame time not yet added to flame_seconds (milliseconds)
+static uint32_t kcal_acc = 0;             // Heat not yet added to kcal (kcal/h x milliseconds)
+static uint32_t gas_acc = 0;              // Gas not yet added to gas_litres (litres/h x milliseconds)
+
+// Function StatsCrc: Returns the CRC-8 of a statistics block, excluding its crc field
+static uint8_t StatsCrc(const BurnerStats *p_stats) {
+    const uint8_t *p_byte = (const uint8_t *)p_stats;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < offsetof(BurnerStats, crc); i++) {
+        crc = _crc8_ccitt_update(crc, p_byte[i]);
+    }
+    return crc;
+}
+
+// Function SaveBurnerStats: Queues a snapshot of the totals to be written to EEPROM in the background
+static void SaveBurnerStats(void) {
+    stats_snapshot = burner_stats;
+    stats_snapshot.crc = StatsCrc(&stats_snapshot);
+    if (QueueEepromWrite(STATS_ADDRESS, &stats_snapshot, sizeof(BurnerStats), &stats_saved)) {
+        last_save = GetMilliseconds();
+        stats_dirty = false;
+    }
+}
+
+// Function InitBurnerStats: Loads the totals from EEPROM, starting from zero if they are missing or corrupted
+void InitBurnerStats(void) {
+    ReadEeprom(&burner_stats, STATS_ADDRESS, sizeof(BurnerStats));
+    if (burner_stats.crc != StatsCrc(&burner_stats)) {
+        uint8_t *p_byte = (uint8_t *)&burner_stats;
+        for (uint8_t i = 0; i < sizeof(BurnerStats); i++) {
+            p_byte[i] = 0;
+        }
+    }
+    stats_dirty = false;
+    last_update = GetMilliseconds();
+    last_save = last_update;
+}
+
+// Function UpdateBurnerStats: Integrates the flame time and the open heat valve figures since the last update
+void UpdateBurnerStats(SysInfo *p_system) {
+    uint32_t now = GetMilliseconds();
+    uint16_t elapsed = (uint16_t)(now - last_update);
+    last_update = now;
+
+    bool flame = GetFlag(p_system, INPUT_FLAGS, FLAME_F);
+    if (flame != flame_on) {
+        if (flame) {
+            flame_start = now;
+        } else if (((now - flame_start) < ((uint32_t)STATS_SHORT_CYCLE * 1000)) && (burner_stats.short_cycles < UINT16_MAX)) {
+            burner_stats.short_cycles++;
+            stats_dirty = true;
+        }
+        flame_on = flame;
+    }
+
+    if (flame) {
+        flame_ms += elapsed;
+        while (flame_ms >= 1000) {
+            flame_ms -= 1000;
+            burner_stats.flame_seconds++;
+            stats_dirty = true;
+            if (p_system->current_heat_level < HEAT_LEVELS) {
+                burner_stats.level_seconds[p_system->current_heat_level]++;
+            }
+        }
+        // Heat and gas from the valves ModulateHeat keeps open, in kcal/h and litres/h times milliseconds
+        for (uint8_t valve = 0; valve < HEAT_MODULATOR_VALVES; valve++) {
+            if (GetFlag(p_system, OUTPUT_FLAGS, p_system->heat_modulator[valve].valve_flag)) {
+                kcal_acc += (uint32_t)p_system->heat_modulator[valve].kcal_h * elapsed;
+                gas_acc += (uint32_t)p_system->heat_modulator[valve].gas_lh * elapsed;
+            }
+        }
+        while (kcal_acc >= STATS_HOUR_MS) {
+            kcal_acc -= STATS_HOUR_MS;
+            burner_stats.kcal++;
+            stats_dirty = true;
+        }
+        while (gas_acc >= STATS_HOUR_MS) {
+            gas_acc -= STATS_HOUR_MS;
+            burner_stats.gas_litres++;
+            stats_dirty = true;
+        }
+    }
+
+    if (stats_saved && stats_dirty && ((now - last_save) >= STATS_SAVE_PERIOD)) {
+        SaveBurnerStats();
+    }
+}
+
+// Function CountIgnition: Counts an ignition attempt, successful or not
+void CountIgnition(bool flame_lit) {
+    if (flame_lit) {
+        burner_stats.ignitions++;
+        stats_dirty = true;
+    } else if (burner_stats.ignition_failures < UINT16_MAX) {
+        burner_stats.ignition_failures++;
+        stats_dirty = true;
+    }
+}
+
+// Function GetBurnerStats: Returns the running totals
+const BurnerStats *GetBurnerStats(void) {
+    return &burner_stats;
+}
+
+// Function SendBurnerStats: Sends the running totals over serial
+void SendBurnerStats(void) {
+    SerialTxStr(str_stats_flame);
+    SerialTxStr(str_crlf);
+    const uint32_t fields[] = {burner_stats.flame_seconds, burner_stats.ignitions, burner_stats.ignition_failures,
+                               burner_stats.short_cycles, burner_stats.kcal, burner_stats.gas_litres};
+    for (uint8_t field = 0; field < (sizeof(fields) / sizeof(fields[0])); field++) {
+        SerialTxNum(fields[field], DIGITS_FREE);
+        SerialTxChr(' ');
+    }
+    SerialTxStr(str_crlf);
+    SerialTxStr(str_stats_levels);
+    for (uint8_t level = 0; level < HEAT_LEVELS; level++) {
+        SerialTxChr(' ');
+        SerialTxNum(burner_stats.level_seconds[level], DIGITS_FREE);
+    }
+    SerialTxStr(str_crlf);
+}
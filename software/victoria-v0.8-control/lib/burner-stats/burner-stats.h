@@ -0,0 +1,58 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: burner-stats.h (burner runtime statistics headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef BURNER_STATS_H
+#define BURNER_STATS_H
+
+#include <eeprom-queue.h>
+#include <hal.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <timers.h>
+#include <util/crc16.h>
+
+#include "../../include/sys-settings.h"
+
+#define STATS_HOUR_MS 3600000                        // Milliseconds per hour, converts the per-hour valve figures
+#define STATS_RECORD_SIZE (21 + (HEAT_LEVELS * 4))  // EEPROM bytes taken by BurnerStats
+
+#if ((STATS_ADDRESS < (EVENT_LOG_ADDRESS + (EVENT_LOG_RECORDS * 16))) || ((STATS_ADDRESS + STATS_RECORD_SIZE) > 1024))
+#error "The burner statistics overlap the event log or don't fit in the ATmega328 EEPROM"
+#endif
+
+// Types
+
+typedef struct burner_stats {
+    uint32_t flame_seconds;               // Time with the flame lit
+    uint32_t level_seconds[HEAT_LEVELS];  // Time with the flame lit at each heat level
+    uint32_t kcal;                        // Heat delivered estimate, from the valve open times
+    uint32_t gas_litres;                  // G20 gas burned estimate, from the valve open times
+    uint32_t ignitions;                   // Ignitions that lit the flame
+    uint16_t ignition_failures;           // Ignition attempts without flame
+    uint16_t short_cycles;                // Burner runs shorter than STATS_SHORT_CYCLE
+    uint8_t crc;                          // CRC-8/CCITT of the bytes above
+} __attribute__((packed)) BurnerStats;  // Packed: the same EEPROM layout on the ATmega328 and on the host tests
+
+// Prototypes
+
+void InitBurnerStats(void);
+void UpdateBurnerStats(SysInfo *p_system);
+void CountIgnition(bool flame_lit);
+const BurnerStats *GetBurnerStats(void);
+void SendBurnerStats(void);
+
+// Burner statistics literals
+
+static const char __flash str_stats_flame[] = {"Burner: flame-s ignitions failures short-cycles kcal gas-l"};
+static const char __flash str_stats_levels[] = {"Heat level seconds:"};
+
+#endif  // BURNER_STATS_H
@@ -0,0 +1,79 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: eeprom-queue.c (background EEPROM writer library) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "eeprom-queue.h"
+
+static EepromJob eeprom_queue[EEPROM_QUEUE_LENGTH];
+static volatile uint8_t queue_head = 0;   // Next free queue slot
+static volatile uint8_t queue_tail = 0;   // Job being written
+static volatile uint8_t write_index = 0;  // Next byte of the job being written
+
+// Function QueueEepromWrite: Queues a block to be written to EEPROM in the background, returns false if the queue is full
+bool QueueEepromWrite(uint16_t address, const void *p_data, uint8_t length, volatile bool *p_done) {
+    uint8_t head = queue_head;
+    if (((head + 1) & (EEPROM_QUEUE_LENGTH - 1)) == queue_tail) {
+        return false;
+    }
+    if (p_done != NULL) {
+        *p_done = false;
+    }
+    eeprom_queue[head].address = address;
+    eeprom_queue[head].p_data = (const uint8_t *)p_data;
+    eeprom_queue[head].length = length;
+    eeprom_queue[head].p_done = p_done;
+    queue_head = (head + 1) & (EEPROM_QUEUE_LENGTH - 1);
+    EECR |= (1 << EERIE);  // The EEPROM-ready interrupt writes the queued jobs
+    return true;
+}
+
+// Function ReadEeprom: Reads a block from EEPROM, waiting for the byte being written in the background
+void ReadEeprom(void *p_data, uint16_t address, uint8_t length) {
+    bool block_read = false;
+    while (block_read == false) {
+        // The EEPROM can't be read while the EEPROM-ready interrupt is writing a byte
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (eeprom_is_ready()) {
+                eeprom_read_block(p_data, (const void *)address, length);
+                block_read = true;
+            }
+        }
+    }
+}
+
+// EEPROM-ready interrupt: writes the next changed byte of the queued jobs (one byte per ~3.4 ms)
+ISR(EE_READY_vect) {
+    uint8_t tail = queue_tail;
+    uint8_t index = write_index;
+    while (tail != queue_head) {
+        EepromJob *p_job = &eeprom_queue[tail];
+        while (index < p_job->length) {
+            uint8_t data = p_job->p_data[index];
+            EEAR = p_job->address + index++;
+            EECR |= (1 << EERE);
+            if (EEDR != data) {
+                // Only the bytes that change are written, it saves time and EEPROM wear
+                EEDR = data;
+                EECR |= (1 << EEMPE);
+                EECR |= (1 << EEPE);  // Must follow EEMPE within 4 clock cycles, interrupts are off in the ISR
+                write_index = index;
+                return;
+            }
+        }
+        if (p_job->p_done != NULL) {
+            *p_job->p_done = true;
+        }
+        index = 0;
+        tail = (tail + 1) & (EEPROM_QUEUE_LENGTH - 1);
+        queue_tail = tail;
+    }
+    write_index = 0;
+    EECR &= ~(1 << EERIE);  // Queue empty
+}
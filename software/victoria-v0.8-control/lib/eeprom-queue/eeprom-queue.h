@@ -0,0 +1,42 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: eeprom-queue.h (background EEPROM writer headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef EEPROM_QUEUE_H
+#define EEPROM_QUEUE_H
+
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <util/atomic.h>
+
+#define EEPROM_QUEUE_LENGTH 8  // Write jobs waiting for the EEPROM-ready interrupt (power of two)
+
+#if (EEPROM_QUEUE_LENGTH & (EEPROM_QUEUE_LENGTH - 1))
+#error "EEPROM_QUEUE_LENGTH must be a power of two"
+#endif
+
+// Types
+
+typedef struct eeprom_job {
+    uint16_t address;       // EEPROM destination address
+    const uint8_t *p_data;  // Source block, it must stay unchanged until the job is done
+    uint8_t length;         // Block length (bytes)
+    volatile bool *p_done;  // Set to true when the block is written, NULL if not needed
+} EepromJob;
+
+// Prototypes
+
+bool QueueEepromWrite(uint16_t address, const void *p_data, uint8_t length, volatile bool *p_done);
+void ReadEeprom(void *p_data, uint16_t address, uint8_t length);
+
+#endif  // EEPROM_QUEUE_H
@@ -0,0 +1,130 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: event-log.c (EEPROM event log library) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "event-log.h"
+
+// Records waiting for the background EEPROM writer, a buffer is reused once its record is written
+static EventRecord event_queue[EVENT_QUEUE_LENGTH];
+static volatile bool event_written[EVENT_QUEUE_LENGTH];
+static uint8_t record_head = 0;  // Next record buffer
+static uint8_t event_drops = 0;  // Records lost because the queue was full
+
+static uint8_t next_slot = 0;       // Ring slot of the next record
+static uint16_t next_sequence = 0;  // Sequence number of the next record
+static uint8_t boot_reset_cause = 0;
+
+// Function GetSlotAddress: Returns the EEPROM address of a ring slot
+static uint16_t GetSlotAddress(uint8_t slot) {
+    return EVENT_LOG_ADDRESS + ((uint16_t)slot * sizeof(EventRecord));
+}
+
+// Function NextSequence: Returns the sequence number that follows another, skipping the erased value
+static uint16_t NextSequence(uint16_t sequence) {
+    sequence++;
+    return (sequence == EVENT_SEQ_EMPTY) ? 0 : sequence;
+}
+
+// Function RecordCrc: Returns the CRC-8 of a record, excluding its crc field
+static uint8_t RecordCrc(const EventRecord *p_record) {
+    const uint8_t *p_byte = (const uint8_t *)p_record;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < offsetof(EventRecord, crc); i++) {
+        crc = _crc8_ccitt_update(crc, p_byte[i]);
+    }
+    return crc;
+}
+
+// Function InitEventLog: Finds the end of the log ring in EEPROM, then logs the system start
+void InitEventLog(SysInfo *p_system, uint8_t reset_cause) {
+    // The newest record is the last one of the run of consecutive sequence numbers
+    uint16_t sequence = eeprom_read_word((const uint16_t *)(GetSlotAddress(0) + offsetof(EventRecord, sequence)));
+    next_slot = 0;
+    next_sequence = 0;
+    if (sequence != EVENT_SEQ_EMPTY) {
+        next_slot = 1;
+        for (; next_slot < EVENT_LOG_RECORDS; next_slot++) {
+            uint16_t slot_sequence = eeprom_read_word((const uint16_t *)(GetSlotAddress(next_slot) + offsetof(EventRecord, sequence)));
+            if (slot_sequence != NextSequence(sequence)) {
+                break;
+            }
+            sequence = slot_sequence;
+        }
+        next_sequence = NextSequence(sequence);
+        if (next_slot == EVENT_LOG_RECORDS) {
+            next_slot = 0;
+        }
+    }
+    for (uint8_t i = 0; i < EVENT_QUEUE_LENGTH; i++) {
+        event_written[i] = true;
+    }
+    boot_reset_cause = reset_cause;
+    LogEvent(p_system, EVENT_RESET);
+}
+
+// Function LogEvent: Queues a record of the current system status, it is written to EEPROM in the background
+bool LogEvent(SysInfo *p_system, EventType event) {
+    uint8_t head = record_head;
+    EventRecord *p_record = &event_queue[head];
+    if (event_written[head]) {
+        p_record->sequence = next_sequence;
+        p_record->uptime = GetMilliseconds();
+        p_record->event = event;
+        p_record->error = p_system->error;
+        p_record->system_state = p_system->system_state;
+        p_record->inner_step = p_system->inner_step;
+        p_record->dhw_temperature = p_system->dhw_temperature;
+        p_record->ch_temperature = p_system->ch_temperature;
+        p_record->reset_cause = boot_reset_cause;
+        p_record->crc = RecordCrc(p_record);
+        if (QueueEepromWrite(GetSlotAddress(next_slot), p_record, sizeof(EventRecord), &event_written[head])) {
+            next_sequence = NextSequence(next_sequence);
+            if (++next_slot == EVENT_LOG_RECORDS) {
+                next_slot = 0;
+            }
+            record_head = (head + 1) & (EVENT_QUEUE_LENGTH - 1);
+            return true;
+        }
+    }
+    // The record buffer is still waiting to be written, or the EEPROM writer queue is full
+    if (event_drops < UINT8_MAX) {
+        event_drops++;
+    }
+    return false;
+}
+
+// Function GetEventLogDrops: Returns the number of records lost because the write queue was full
+uint8_t GetEventLogDrops(void) {
+    return event_drops;
+}
+
+// Function SendEventLog: Sends the records stored in EEPROM over serial, oldest first
+void SendEventLog(void) {
+    SerialTxStr(str_event_log);
+    SerialTxStr(str_crlf);
+    uint8_t slot = next_slot;
+    for (uint8_t i = 0; i < EVENT_LOG_RECORDS; i++) {
+        EventRecord record;
+        ReadEeprom(&record, GetSlotAddress(slot), sizeof(EventRecord));
+        if (++slot == EVENT_LOG_RECORDS) {
+            slot = 0;
+        }
+        if ((record.sequence == EVENT_SEQ_EMPTY) || (record.crc != RecordCrc(&record))) {
+            continue;  // Erased slot, or a record cut short by a power loss
+        }
+        const uint32_t fields[] = {record.sequence, record.uptime, record.event, record.error, record.system_state,
+                                   record.inner_step, record.dhw_temperature, record.ch_temperature, record.reset_cause};
+        for (uint8_t field = 0; field < (sizeof(fields) / sizeof(fields[0])); field++) {
+            SerialTxNum(fields[field], DIGITS_FREE);
+            SerialTxChr(' ');
+        }
+        SerialTxStr(str_crlf);
+    }
+}
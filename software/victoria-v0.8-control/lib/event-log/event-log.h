@@ -0,0 +1,68 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: event-log.h (EEPROM event log headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <avr/eeprom.h>
+#include <eeprom-queue.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <timers.h>
+#include <util/crc16.h>
+
+#include "../../include/sys-settings.h"
+
+#define EVENT_SEQ_EMPTY 0xFFFF  // Sequence number read from an erased EEPROM slot, never written
+#define EVENT_QUEUE_LENGTH 4    // Record buffers waiting to be written to EEPROM (power of two)
+
+#if ((EVENT_LOG_ADDRESS + (EVENT_LOG_RECORDS * 16)) > 1024)
+#error "The event log doesn't fit in the ATmega328 EEPROM"
+#endif
+
+#if (EVENT_QUEUE_LENGTH & (EVENT_QUEUE_LENGTH - 1))
+#error "EVENT_QUEUE_LENGTH must be a power of two"
+#endif
+
+// Types
+
+typedef enum event_type {
+    EVENT_RESET = 1,   // System start, reset_cause holds the MCUSR flags
+    EVENT_ERROR = 2,   // The FSM entered the ERROR state
+    EVENT_LOCKOUT = 3  // Too many consecutive errors, the system is locked out
+} EventType;
+
+typedef struct event_record {
+    uint32_t uptime;           // Milliseconds since the system start
+    uint16_t sequence;         // Record sequence number, consecutive along the ring
+    uint16_t dhw_temperature;  // DHW NTC thermistor ADC readout
+    uint16_t ch_temperature;   // CH NTC thermistor ADC readout
+    uint8_t event;             // EventType
+    uint8_t error;             // System error code
+    uint8_t system_state;      // FSM state
+    uint8_t inner_step;        // FSM step
+    uint8_t reset_cause;       // MCUSR flags of the last system start
+    uint8_t crc;               // CRC-8/CCITT of the bytes above
+} EventRecord;
+
+// Prototypes
+
+void InitEventLog(SysInfo *p_system, uint8_t reset_cause);
+bool LogEvent(SysInfo *p_system, EventType event);
+uint8_t GetEventLogDrops(void);
+void SendEventLog(void);
+
+// Event log literals
+
+static const char __flash str_event_log[] = {"Event log: seq uptime-ms event error state step dhw-adc ch-adc reset"};
+
+#endif  // EVENT_LOG_H
@@ -0,0 +1,446 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: fsm.c (table-driven system state machine)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "fsm.h"
+
+// On-duty steps loop back to themselves to refresh the dashboard periodically
+#if (SHOW_DASHBOARD && AUTO_DHW_DSP_REFRESH)
+static const uint16_t dly_dhw_refresh = DLY_DHW_ON_DUTY_LOOP;
+#define DLY_DHW_REFRESH (&dly_dhw_refresh)
+#else
+#define DLY_DHW_REFRESH FSM_NO_TIMEOUT
+#endif  // SHOW_DASHBOARD && AUTO_DHW_DSP_REFRESH
+#if (SHOW_DASHBOARD && AUTO_CH_DSP_REFRESH)
+static const uint16_t dly_ch_refresh = DLY_CH_ON_DUTY_LOOP;
+#define DLY_CH_REFRESH (&dly_ch_refresh)
+#else
+#define DLY_CH_REFRESH FSM_NO_TIMEOUT
+#endif  // SHOW_DASHBOARD && AUTO_CH_DSP_REFRESH
+
+// The flue exhaust fan test is skipped when the airflow sensor or the test itself are overridden
+#if (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
+#define FAN_TEST_STEP OFF_3
+#else
+#define FAN_TEST_STEP OFF_4
+#endif  // AIRFLOW_OVERRIDE && FAN_TEST_OVERRIDE
+
+static uint8_t error_blinks = 0;  // LED_UI on and off phases shown of the current error code repetition
+
+// Function Fail: Sets the error code and returns the guard result that takes the FSM to the ERROR state
+static uint8_t Fail(SysInfo *p_system, uint8_t error) {
+    p_system->error = error;
+    return FSM_FAIL;
+}
+
+// Function RefreshDashboard: Forces a whole dashboard redraw on its next update
+static void RefreshDashboard(SysInfo *p_system) {
+#if SHOW_DASHBOARD
+    p_system->last_displayed_iflags = DASHBOARD_REFRESH;
+#endif  // SHOW_DASHBOARD
+}
+
+// Function ResumePump: If the CH water pump is off, but it still has pending running time, turns it on
+static void ResumePump(SysInfo *p_system) {
+    if ((GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) && (p_system->pump_timer_memory != 0)) {
+        ResetTimerLapse(PUMP_TIMER_ID, p_system->pump_timer_memory);
+        SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
+        p_system->pump_timer_memory = 0;
+    }
+}
+
+// Function BurnerChecks: Verifies that the flame and airflow are still present while the burner is on duty
+static uint8_t BurnerChecks(SysInfo *p_system) {
+    // Flame lost: turn all heat valves off except the valve 1 and retry the ignition
+    if (GetFlag(p_system, INPUT_FLAGS, FLAME_F) == false) {
+        OpenHeatValve(p_system, VALVE_1);
+        return IGNITING_1;
+    }
+#if !(AIRFLOW_OVERRIDE)
+    // No pressure in the flue exhaust duct with the flame lit
+    if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F) == false) {
+        return Fail(p_system, ERROR_007);
+    }
+#endif  // AIRFLOW_OVERRIDE
+    return FSM_STAY;
+}
+
+//
+// Step entry actions
+//
+
+// Function TurnFanOn: Turns the exhaust fan on
+static void TurnFanOn(SysInfo *p_system) {
+    SetFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
+}
+
+// Function TurnFanOff: Turns the exhaust fan off
+static void TurnFanOff(SysInfo *p_system) {
+    ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
+}
+
+// Function EnterReady: Closes the gas and stops the heat cycle, the burner waits for a DHW or CH request
+static void EnterReady(SysInfo *p_system) {
+    GasOff(p_system);
+    ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
+    p_system->ignition_tries = 1;
+}
+
+// Function OpenSecurityValve: Opens the gas security valve
+static void OpenSecurityValve(SysInfo *p_system) {
+    SetFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);
+}
+
+// Function OpenIgnitionValve: Opens the gas valve 1 on the first ignition try, then alternates valves 1 and 2
+static void OpenIgnitionValve(SysInfo *p_system) {
+    if ((GetFlag(p_system, OUTPUT_FLAGS, VALVE_1_F) == false) || (p_system->ignition_tries == 1)) {
+        OpenHeatValve(p_system, VALVE_1);
+    } else {
+        OpenHeatValve(p_system, VALVE_2);
+    }
+}
+
+// Function TurnSparkOn: Turns the spark igniter on
+static void TurnSparkOn(SysInfo *p_system) {
+    SetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
+}
+
+// Function StartHeatCycle: Restarts the heat modulator timer and presets the heat controller when a service takes control of the burner
+static void StartHeatCycle(SysInfo *p_system) {
+    ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
+    p_system->cycle_in_progress = false;  // A cycle cut short when the burner last stopped starts over from its first valve
+    ResetHeatControl(p_system);
+    p_system->error_retries = 0;  // The burner is running again, earlier errors no longer count towards a lockout
+}
+
+// Function StopChBurner: Closes the gas while the CH service pauses, starting its minimum off-time
+static void StopChBurner(SysInfo *p_system) {
+    GasOff(p_system);
+    ChBurnerStopped();
+}
+
+//
+// Step guards
+//
+
+// Function CheckOff: Verifies that the flame and airflow sensors are off while the burner is off
+static uint8_t CheckOff(SysInfo *p_system) {
+    if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
+        return Fail(p_system, ERROR_002);
+    }
+#if !(AIRFLOW_OVERRIDE)
+    // The airflow sensor is expected on during the fan test
+    if ((p_system->inner_step < OFF_3) && (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F))) {
+        return Fail(p_system, ERROR_003);
+    }
+#endif  // AIRFLOW_OVERRIDE
+    return FSM_STAY;
+}
+
+// Function GuardOff1: All devices were turned off on entry, move on to the fan test
+static uint8_t GuardOff1(SysInfo *p_system) {
+    uint8_t next_step = CheckOff(p_system);
+    return (next_step == FSM_STAY) ? OFF_2 : next_step;
+}
+
+// Function GuardOff3: Fan test in progress, the airflow sensor activation ends it successfully
+static uint8_t GuardOff3(SysInfo *p_system) {
+    uint8_t next_step = CheckOff(p_system);
+    if ((next_step == FSM_STAY) && GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
+        return OFF_4;
+    }
+    return next_step;
+}
+
+// Function GuardOff4: Fan revving down after the test, the airflow sensor must be off when the time is up
+static uint8_t GuardOff4(SysInfo *p_system) {
+    uint8_t next_step = CheckOff(p_system);
+#if (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
+    if ((next_step == FSM_STAY) && TimerFinished(FSM_TIMER_ID) && GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
+        return Fail(p_system, ERROR_006);
+    }
+#endif  // AIRFLOW_OVERRIDE && FAN_TEST_OVERRIDE
+    return next_step;
+}
+
+// Function GuardReady: Waits for a DHW or CH request, the sensors are checked every DLY_READY_1 ms
+static uint8_t GuardReady(SysInfo *p_system) {
+    // Give the flame and airflow sensors time to switch off after the gas is closed and the fan is turned off
+    if (TimerFinished(FSM_TIMER_ID)) {
+        if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
+            return Fail(p_system, ERROR_002);
+        }
+#if !(AIRFLOW_OVERRIDE)
+        if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
+            return Fail(p_system, ERROR_003);
+        }
+#endif  // AIRFLOW_OVERRIDE
+    }
+    ResumePump(p_system);
+    // If both services are requested, DHW will have higher priority after ignition
+    if ((GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) || (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F))) {
+        return IGNITING_1;
+    }
+    return FSM_STAY;
+}
+
+// Function CheckIgniting: Cancels the ignition sequence when the DHW and CH requests are over
+static uint8_t CheckIgniting(SysInfo *p_system) {
+    if ((GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F) == false) &&
+        (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false)) {
+        return READY_1;
+    }
+    return FSM_STAY;
+}
+
+// Function GuardIgniting2: The airflow sensor activation lets the ignition sequence continue
+static uint8_t GuardIgniting2(SysInfo *p_system) {
+    uint8_t next_step = CheckIgniting(p_system);
+#if !(AIRFLOW_OVERRIDE)
+    if ((next_step == FSM_STAY) && GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
+        return IGNITING_3;
+    }
+    return next_step;
+#else
+    return (next_step == FSM_STAY) ? IGNITING_3 : next_step;
+#endif  // AIRFLOW_OVERRIDE
+}
+
+// Function GuardIgniting6: Hands the burner over to the requested service when the flame is lit, otherwise retries
+static uint8_t GuardIgniting6(SysInfo *p_system) {
+    uint8_t next_step = CheckIgniting(p_system);
+    if (next_step != FSM_STAY) {
+        return next_step;
+    }
+    if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
+        ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
+        CountIgnition(true);
+        p_system->ignition_tries = 1;
+        // DHW has higher priority
+        return GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F) ? DHW_ON_DUTY_1 : CH_ON_DUTY_1;
+    }
+    // DLY_IGNITING_6 elapsed without detecting the flame
+    if (TimerFinished(FSM_TIMER_ID)) {
+        ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
+        CountIgnition(false);
+        if (p_system->ignition_tries++ >= sys_params.max_ignition_tries) {
+            p_system->ignition_tries = 1;
+            return Fail(p_system, ERROR_005);
+        }
+        return IGNITING_4;
+    }
+    return FSM_STAY;
+}
+
+// Function GuardDhw: Keeps the burner on while there is a DHW request
+static uint8_t GuardDhw(SysInfo *p_system) {
+    uint8_t next_step = BurnerChecks(p_system);
+    if (next_step != FSM_STAY) {
+        return next_step;
+    }
+    // If a CH water overtemperature is not detected, but the CH water pump is on, store the running time remaining and halt it
+    if ((p_system->ch_water_overheat == false) && (p_system->pump_timer_memory == 0) &&
+        GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F)) {
+        p_system->pump_timer_memory = GetTimeLeft(PUMP_TIMER_ID);
+        ResetTimerLapse(PUMP_TIMER_ID, 0);
+        ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
+    }
+    // DHW request over: hand the burner back to the CH service if it is requested
+    if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F) == false) {
+        return GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) ? p_system->ch_on_duty_step : READY_1;
+    }
+    return FSM_STAY;
+}
+
+// Function GuardCh1: Heats the CH water until the CH controller can't hold the target with the burner on
+static uint8_t GuardCh1(SysInfo *p_system) {
+    uint8_t next_step = BurnerChecks(p_system);
+    if (next_step != FSM_STAY) {
+        return next_step;
+    }
+    // Keep the CH water pump on and its timer at its full time-lapse
+    if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
+        SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
+    }
+    ResetTimerLapse(PUMP_TIMER_ID, sys_params.pump_timer_duration);
+    p_system->pump_timer_memory = 0;
+    p_system->ch_water_overheat = false;
+    if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
+        p_system->ch_on_duty_step = CH_ON_DUTY_1;  // Preserve current CH service step
+        return DHW_ON_DUTY_1;
+    }
+    if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false) {
+        return READY_1;
+    }
+    if (ChTargetReached(p_system)) {
+        return CH_ON_DUTY_2;
+    }
+    return FSM_STAY;
+}
+
+// Function GuardCh2: Recirculates the CH water with the burner off until the CH controller asks for heat
+static uint8_t GuardCh2(SysInfo *p_system) {
+    ResumePump(p_system);
+    if (ChHeatNeeded(p_system)) {
+        return IGNITING_1;
+    }
+    if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
+        p_system->ch_on_duty_step = CH_ON_DUTY_2;  // Preserve current CH service step
+        return IGNITING_1;
+    }
+    if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false) {
+        return READY_1;
+    }
+    return FSM_STAY;
+}
+
+// FSM step table, indexed by InnerStep. Unlisted rows have no guard and reset the FSM
+static const FsmStep __flash fsm_table[FSM_STEPS] = {
+    //                 state        entry              guard           timeout                     timeout target error
+    [OFF_1] =         {OFF,         GasOff,            GuardOff1,      FSM_NO_TIMEOUT,             FSM_STAY,      ERROR_000},
+    [OFF_2] =         {OFF,         NULL,              CheckOff,       &sys_params.dly_off_2,      FAN_TEST_STEP, ERROR_000},
+    [OFF_3] =         {OFF,         TurnFanOn,         GuardOff3,      &sys_params.dly_off_3,      FSM_FAIL,      ERROR_004},
+    [OFF_4] =         {OFF,         TurnFanOff,        GuardOff4,      &sys_params.dly_off_4,      READY_1,       ERROR_000},
+    [READY_1] =       {READY,       EnterReady,        GuardReady,     &sys_params.dly_ready_1,    READY_1,       ERROR_000},
+    [IGNITING_1] =    {IGNITING,    NULL,              CheckIgniting,  &sys_params.dly_igniting_1, IGNITING_2,    ERROR_000},
+    [IGNITING_2] =    {IGNITING,    TurnFanOn,         GuardIgniting2, &sys_params.dly_igniting_2, FSM_FAIL,      ERROR_004},
+    [IGNITING_3] =    {IGNITING,    NULL,              CheckIgniting,  &sys_params.dly_igniting_3, IGNITING_4,    ERROR_000},
+    [IGNITING_4] =    {IGNITING,    OpenSecurityValve, CheckIgniting,  &sys_params.dly_igniting_4, IGNITING_5,    ERROR_000},
+    [IGNITING_5] =    {IGNITING,    OpenIgnitionValve, CheckIgniting,  &sys_params.dly_igniting_5, IGNITING_6,    ERROR_000},
+    [IGNITING_6] =    {IGNITING,    TurnSparkOn,       GuardIgniting6, &sys_params.dly_igniting_6, FSM_STAY,      ERROR_000},
+    [DHW_ON_DUTY_1] = {DHW_ON_DUTY, StartHeatCycle,    GuardDhw,       DLY_DHW_REFRESH,            DHW_ON_DUTY_1, ERROR_000},
+    [CH_ON_DUTY_1] =  {CH_ON_DUTY,  StartHeatCycle,    GuardCh1,       DLY_CH_REFRESH,             CH_ON_DUTY_1,  ERROR_000},
+    [CH_ON_DUTY_2] =  {CH_ON_DUTY,  StopChBurner,      GuardCh2,       DLY_CH_REFRESH,             CH_ON_DUTY_2,  ERROR_000},
+};
+
+// Function EnterStep: Moves the FSM to a new step, arming its timeout and running its entry action
+static void EnterStep(SysInfo *p_system, InnerStep step) {
+    const __flash FsmStep *p_step = &fsm_table[step];
+    if (p_system->system_state != p_step->state) {
+        RefreshDashboard(p_system);
+    }
+    p_system->inner_step = step;
+    p_system->system_state = p_step->state;
+    if (p_step->p_timeout != FSM_NO_TIMEOUT) {
+        ResetTimerLapse(FSM_TIMER_ID, *p_step->p_timeout);
+    }
+    if (p_step->entry != NULL) {
+        p_step->entry(p_system);
+    }
+}
+
+// Function EnterError: Closes the gas and starts the error presenter, then schedules a retry or locks out
+static void EnterError(SysInfo *p_system) {
+    GasOff(p_system);
+    // If there are not enough slots for the required system timers, the system must be halted!
+    if (p_system->error == ERROR_012) {
+        for (;;) {  // Halt, the WDT resets the system
+        }
+    }
+    LogEvent(p_system, EVENT_ERROR);
+    p_system->inner_step = ERROR_1;
+    if (p_system->error_retries < ERROR_MAX_RETRIES) {
+        SetTimer(ERROR_TIMER_ID, (uint32_t)ERROR_RETRY_DELAY << p_system->error_retries, RUN_ONCE_AND_HOLD);
+        p_system->error_retries++;
+    } else {
+        p_system->locked_out = true;
+        LogEvent(p_system, EVENT_LOCKOUT);
+    }
+    error_blinks = 0;
+    ResetTimerLapse(FSM_TIMER_ID, 0);
+}
+
+// Function ErrorState: Blinks the error code on LED_UI and shows it on the dashboard until the retry backoff is over
+static void ErrorState(SysInfo *p_system) {
+    if (p_system->inner_step != ERROR_1) {
+        EnterError(p_system);
+    }
+    // Next state -> OFF (reset error and try to resume service)
+    if ((p_system->locked_out == false) && TimerFinished(ERROR_TIMER_ID)) {
+        ClearFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        p_system->error = ERROR_000;
+        EnterStep(p_system, OFF_1);
+        return;
+    }
+    if (TimerFinished(FSM_TIMER_ID) == false) {
+        return;
+    }
+    if (error_blinks == 0) {
+#if SHOW_DASHBOARD
+        // Display updated status on system dashboard once per error code repetition, the error code goes under it
+        Dashboard(p_system, true);
+#endif  // SHOW_DASHBOARD
+    }
+    // One blink per error code unit, then a pause
+    if (error_blinks < (p_system->error * 2)) {
+        if (error_blinks++ & 1) {
+            ClearFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        } else {
+            SetFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        }
+        ResetTimerLapse(FSM_TIMER_ID, ERROR_BLINK_TIME);
+    } else {
+        ClearFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        error_blinks = 0;
+        ResetTimerLapse(FSM_TIMER_ID, ERROR_PAUSE_TIME);
+    }
+}
+
+// Function RunFsm: Runs a step of the system finite state machine
+void RunFsm(SysInfo *p_system) {
+    if (p_system->system_state == ERROR) {
+        ErrorState(p_system);
+        return;
+    }
+    InnerStep step = p_system->inner_step;
+    // A step out of the table, or out of sync with the system state, restarts the FSM
+    if ((step >= FSM_STEPS) || (fsm_table[step].guard == NULL) || (fsm_table[step].state != p_system->system_state)) {
+        EnterStep(p_system, OFF_1);
+        return;
+    }
+    const __flash FsmStep *p_step = &fsm_table[step];
+    uint8_t next_step = p_step->guard(p_system);
+    if ((next_step == FSM_STAY) && (p_step->p_timeout != FSM_NO_TIMEOUT) && (p_step->timeout_target != FSM_STAY) &&
+        TimerFinished(FSM_TIMER_ID)) {
+        next_step = p_step->timeout_target;
+        if (next_step == FSM_FAIL) {
+            p_system->error = p_step->error;
+        }
+    }
+    if (next_step == FSM_STAY) {
+        return;
+    }
+    if (next_step == FSM_FAIL) {
+        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+    } else if (next_step == step) {
+        // Timeout back to the same step: restart its time-lapse without repeating the entry action
+        ResetTimerLapse(FSM_TIMER_ID, *p_step->p_timeout);
+        RefreshDashboard(p_system);
+    } else {
+        EnterStep(p_system, next_step);
+    }
+}
+
+// Function ResetFsm: Closes the gas and takes the FSM back to its first step, unless it is locked out
+void ResetFsm(SysInfo *p_system) {
+    GasOff(p_system);
+    if (p_system->locked_out) {
+        return;
+    }
+    p_system->error = ERROR_000;
+    p_system->system_state = OFF;
+    p_system->inner_step = OFF_1;
+}
+
+// Function ReleaseLockout: Clears an error lockout and the consecutive retries count (manual reset)
+void ReleaseLockout(SysInfo *p_system) {
+    p_system->locked_out = false;
+    p_system->error_retries = 0;
+}
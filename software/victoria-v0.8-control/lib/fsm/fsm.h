@@ -0,0 +1,52 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: fsm.h (table-driven system state machine headers)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef FSM_H
+#define FSM_H
+
+#include <burner-stats.h>
+#include <event-log.h>
+#include <hal.h>
+#include <heat-control.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+#include <timers.h>
+#include <util/delay.h>
+
+#include "../../include/errors.h"
+#include "../../include/sys-settings.h"
+
+#define FSM_STEPS (CH_ON_DUTY_2 + 1)  // Step table rows, indexed directly by InnerStep
+#define FSM_STAY 0xFF                 // Guard result: remain in the current step
+#define FSM_FAIL 0                    // Guard result or timeout target: go to the ERROR state
+#define FSM_NO_TIMEOUT NULL           // The step doesn't arm the FSM timer
+
+// Types
+
+typedef void (*StepAction)(SysInfo *p_system);
+typedef uint8_t (*StepGuard)(SysInfo *p_system);
+
+typedef struct fsm_step {
+    State state;                // System state the step belongs to
+    StepAction entry;           // Run once when the step is entered from another step, NULL if none
+    StepGuard guard;            // Run on every FSM pass, returns the next step, FSM_STAY or FSM_FAIL
+    const uint16_t *p_timeout;  // FSM timer time-lapse armed on entry (runtime parameter, milliseconds), FSM_NO_TIMEOUT if none
+    uint8_t timeout_target;     // Next step when the timeout expires, FSM_STAY when the guard handles it
+    uint8_t error;              // Error code set when timeout_target is FSM_FAIL
+} FsmStep;
+
+// Prototypes
+
+void RunFsm(SysInfo *p_system);
+void ResetFsm(SysInfo *p_system);
+void ReleaseLockout(SysInfo *p_system);
+
+#endif  // FSM_H
@@ -11,6 +11,10 @@
 
 #include "hal.h"
 
+// Staged gas shutdown: devices still waiting to be turned off, and the system they belong to
+static uint8_t gas_off_pending = 0;
+static SysInfo *p_gas_off_system = NULL;
+
 // Function SystemRestart: Restarts the system by activating the watchdog timer
 void SystemRestart(void) {
     wdt_enable(WDTO_15MS);
@@ -44,6 +48,7 @@ void SetFlag(SysInfo *p_system, FlagsType flags_type, uint8_t flag_position) {
         }
         case OUTPUT_FLAGS: {
             // WARNING !!! HARDWARE ACTIVATION !!!
+            gas_off_pending &= ~(1 << flag_position);  // A device turned back on leaves the staged gas shutdown
             p_system->output_flags |= (1 << flag_position);
             ControlActuator(p_system, flag_position, TURN_ON, false);
             break;
@@ -144,90 +149,229 @@ void InitDigitalSensor(SysInfo *p_system, InputFlag digital_sensor) {
     ClearFlag(p_system, INPUT_FLAGS, digital_sensor);
 }
 
-// Function CheckDigitalSensor: Returns the binary value of a given digital sensor and updates its associated flag
-bool CheckDigitalSensor(SysInfo *p_system, InputFlag digital_sensor, bool show_dashboard) {
-    switch (digital_sensor) {
-        case DHW_REQUEST_F: {  // DHW request pin: Active = low, Inactive = high
-            if ((DHW_RQ_PINP >> DHW_RQ_PIN) & true) {
-                //if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
-                ClearFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F);
-            } else {
-                SetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F);
-            }
-            return ((p_system->input_flags >> DHW_REQUEST_F) & true);
-        }
-        case CH_REQUEST_F: {  // CH request pin: Active = low, Inactive = high (bimetallic room thermostat)
-            if (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS) == SYS_COMBI) {
-                // CH request switch debouncing
-                if (((GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F)) == ((CH_RQ_PINP >> CH_RQ_PIN) & true)) || TimerExists(DEB_CH_SWITCH_TIMER_ID)) {
-                    if (TimerExists(DEB_CH_SWITCH_TIMER_ID)) {
-                        if (TimerFinished(DEB_CH_SWITCH_TIMER_ID)) {
-                            if ((GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F)) == ((CH_RQ_PINP >> CH_RQ_PIN) & true)) {
-                                ToggleFlag(p_system, INPUT_FLAGS, CH_REQUEST_F);
-                            }
-                            DeleteTimer(DEB_CH_SWITCH_TIMER_ID);
-                        }
-                    } else {
-                        SetTimer(DEB_CH_SWITCH_TIMER_ID, DEB_CH_SWITCH_TIMER_DURATION, DEB_CH_SWITCH_TIMER_MODE);
-                    }
-                }
-                return (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F));
-            } else {
-                ClearFlag(p_system, INPUT_FLAGS, CH_REQUEST_F);
-            }
-        }
-        case AIRFLOW_F: {  // Flue air flow sensor pin: Active = low, Inactive = high (flue air pressure switch)
-            // Airflow sensor switch debouncing
-            if (((GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) == ((AIRFLOW_PINP >> AIRFLOW_PIN) & true)) || TimerExists(DEB_AIRFLOW_TIMER_ID)) {
-                if (TimerExists(DEB_AIRFLOW_TIMER_ID)) {
-                    if (TimerFinished(DEB_AIRFLOW_TIMER_ID)) {
-                        if ((GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) == ((AIRFLOW_PINP >> AIRFLOW_PIN) & true)) {
-                            ToggleFlag(p_system, INPUT_FLAGS, AIRFLOW_F);
-                        }
-                        DeleteTimer(DEB_AIRFLOW_TIMER_ID);
-                    }
-                } else {
-                    SetTimer(DEB_AIRFLOW_TIMER_ID, DEB_AIRFLOW_TIMER_DURATION, DEB_AIRFLOW_TIMER_MODE);
-                }
-            }
-            return (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F));
-        }
-        case FLAME_F: {  // Flame sensor pin: Active = high, Inactive = low. IT NEEDS EXTERNAL PULL-DOWN RESISTOR !!!
-            // Flame sensor debouncing
-            if (((GetFlag(p_system, INPUT_FLAGS, FLAME_F)) != ((FLAME_PINP >> FLAME_PIN) & true)) || TimerExists(DEB_FLAME_TIMER_ID)) {
-                if (TimerExists(DEB_FLAME_TIMER_ID)) {
-                    if (TimerFinished(DEB_FLAME_TIMER_ID)) {
-                        if ((GetFlag(p_system, INPUT_FLAGS, FLAME_F)) != ((FLAME_PINP >> FLAME_PIN) & true)) {
-                            ToggleFlag(p_system, INPUT_FLAGS, FLAME_F);
+// Debounce engine globals
+static volatile uint8_t debounced_inputs = 0;       // Stable digital inputs, one bit per InputFlag (1 = active)
+static uint8_t debounce_count_0 = 0xFF;             // Vertical counters bit 0, one bit per input
+static uint8_t debounce_count_1 = 0xFF;             // Vertical counters bit 1, one bit per input
+static uint8_t debounce_countdown[DIGITAL_INPUTS];  // System ticks left until the next sample of each input
+#if SHELL_SENSOR_SIM
+static uint8_t simulated_mask = 0;                  // Inputs forced from the serial shell, one bit per InputFlag
+static uint8_t simulated_inputs = 0;                // Values of the forced inputs (1 = active)
+#endif  // SHELL_SENSOR_SIM
+
+// Function ReadDigitalInputs: Returns the raw digital input pins, one bit per InputFlag (1 = active)
+static uint8_t ReadDigitalInputs(void) {
+    uint8_t inputs = 0;
+    if (!((DHW_RQ_PINP >> DHW_RQ_PIN) & true)) {  // DHW request pin: Active = low, Inactive = high
+        inputs |= (1 << DHW_REQUEST_F);
+    }
+    if (!((CH_RQ_PINP >> CH_RQ_PIN) & true)) {  // CH request pin: Active = low, Inactive = high (bimetallic room thermostat)
+        inputs |= (1 << CH_REQUEST_F);
+    }
+    if (!((AIRFLOW_PINP >> AIRFLOW_PIN) & true)) {  // Flue air flow sensor pin: Active = low, Inactive = high (flue air pressure switch)
+        inputs |= (1 << AIRFLOW_F);
+    }
+    if ((FLAME_PINP >> FLAME_PIN) & true) {  // Flame sensor pin: Active = high, Inactive = low. IT NEEDS EXTERNAL PULL-DOWN RESISTOR !!!
+        inputs |= (1 << FLAME_F);
+    }
+    if (!((OVERHEAT_PINP >> OVERHEAT_PIN) & true)) {  // Overheat thermostat pin: Low sets the overheat flag
+        inputs |= (1 << OVERHEAT_F);
+    }
+    return inputs;
+}
+
+// Function CheckDigitalSensors: Updates the input flags from the stable inputs published by the debounce engine
+uint8_t CheckDigitalSensors(SysInfo *p_system, bool show_dashboard) {
+    uint8_t inputs = debounced_inputs;  // Single byte read, the debounce engine publishes it atomically
+#if SHELL_SENSOR_SIM
+    inputs = (inputs & ~simulated_mask) | (simulated_inputs & simulated_mask);
+#endif  // SHELL_SENSOR_SIM
+    // CH request thermostat: only taken into account in combi mode
+    if (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS) != SYS_COMBI) {
+        inputs &= ~(1 << CH_REQUEST_F);
+    }
 #if LED_UI_FOR_FLAME
-                            ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-#endif  // LED_UI_FOR_FLAME
-                        }
-                        DeleteTimer(DEB_FLAME_TIMER_ID);
-                    }
-                } else {
-                    SetTimer(DEB_FLAME_TIMER_ID, DEB_FLAME_TIMER_DURATION, DEB_FLAME_TIMER_MODE);
-                }
-            }
-            return (GetFlag(p_system, INPUT_FLAGS, FLAME_F));
-        }
-        case OVERHEAT_F: {  // Overheat thermostat pin: Active = high, Inactive = low. ACTIVE INDICATES OVERTEMPERATURE !!!
-            if ((OVERHEAT_PINP >> OVERHEAT_PIN) & true) {
-                //if (GetFlag(p_system, INPUT_FLAGS, OVERHEAT_F)) {
-                ClearFlag(p_system, INPUT_FLAGS, OVERHEAT_F);
-            } else {
-                SetFlag(p_system, INPUT_FLAGS, OVERHEAT_F);
-                p_system->input_flags |= (1 << OVERHEAT_F);
-            }
-            return ((p_system->input_flags >> OVERHEAT_F) & true);
-        }
+    if ((inputs ^ p_system->input_flags) & (1 << FLAME_F)) {
+        ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
     }
+#endif  // LED_UI_FOR_FLAME
+    p_system->input_flags = inputs;
 #if SHOW_DASHBOARD
     if (show_dashboard == true) {
         Dashboard(p_system, false);
     }
 #endif  // SHOW_DASHBOARD
-    return 0;
+    return inputs;
+}
+
+// Function StartDebounceEngine: Starts the interrupt-driven digital input debouncing, one pass on each Timer0 compare match (system tick)
+void StartDebounceEngine(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t input = 0; input < DIGITAL_INPUTS; input++) {
+            debounce_countdown[input] = sys_params.debounce_time[input] / DEBOUNCE_SAMPLES;
+        }
+        debounce_count_0 = 0xFF;
+        debounce_count_1 = 0xFF;
+        debounced_inputs = ReadDigitalInputs();  // Start from the current pin levels
+        OCR0A = 0x80;                            // Compare match halfway between Timer0 overflows, away from the ADC trigger
+        TIFR0 = (1 << OCF0A);                    // Clear any pending compare match flag
+        TIMSK0 |= (1 << OCIE0A);                 // Enable the Timer0 compare match A interrupt
+    }
+}
+
+#if SHELL_SENSOR_SIM
+// Function SimulateDigitalInput: Forces the value of a digital input seen by the FSM, or releases it back to its pin.
+// The safety fast path keeps reading the pins
+void SimulateDigitalInput(InputFlag input, bool forced, bool active) {
+    if (forced) {
+        simulated_mask |= (1 << input);
+    } else {
+        simulated_mask &= ~(1 << input);
+    }
+    if (active) {
+        simulated_inputs |= (1 << input);
+    } else {
+        simulated_inputs &= ~(1 << input);
+    }
+}
+#endif  // SHELL_SENSOR_SIM
+
+#if SAFETY_FAST_PATH
+// Safety fast path globals
+static volatile uint16_t flame_loss_countdown = 0;  // System ticks left to confirm a flame loss, 0 = not armed
+static volatile uint16_t overheat_countdown = 0;    // System ticks left to confirm an overheat, 0 = not armed
+static volatile uint8_t safety_trips = 0;           // Inputs that closed the security valve from interrupt context, one bit per InputFlag
+
+// Function CutGas: Closes the security valve and turns the spark igniter off at pin level (interrupt context)
+static void CutGas(void) {
+    // WARNING !!! HARDWARE DEACTIVATION !!!
+    VALVE_S_PORT &= ~(1 << VALVE_S_PIN);  // Set security valve pin low (inactive)
+    SPARK_PORT |= (1 << SPARK_PIN);       // Set spark igniter pin high (inactive)
+}
+
+// Function FlameLost: Returns true when the flame detector is off while the gas security valve is open
+static bool FlameLost(void) {
+    return (!((FLAME_PINP >> FLAME_PIN) & true) && ((VALVE_S_PINP >> VALVE_S_PIN) & true));
+}
+
+// Function Overheated: Returns true when the overheat thermostat pin signals overtemperature
+static bool Overheated(void) {
+    return !((OVERHEAT_PINP >> OVERHEAT_PIN) & true);
+}
+
+// Function StartSafetyPath: Enables the flame detector and overheat thermostat pin interrupts that arm the safety checks
+void StartSafetyPath(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        flame_loss_countdown = 0;
+        overheat_countdown = 0;
+        safety_trips = 0;
+        EICRA = (EICRA & ~(0x03 << FLAME_ISC)) | (1 << FLAME_ISC);  // Sense any logical change
+        EIFR = (1 << FLAME_INT);                                   // Clear any pending edge
+        EIMSK |= (1 << FLAME_INT);
+#if !(OVERHEAT_OVERRIDE)
+        OVERHEAT_PCMSK |= (1 << OVERHEAT_PCINT);
+        PCIFR = (1 << OVERHEAT_PCIE);  // Clear any pending pin change
+        PCICR |= (1 << OVERHEAT_PCIE);
+        if (Overheated()) {
+            overheat_countdown = SAFETY_OVERHEAT_TIME;  // Already open at start, no edge will arm it
+        }
+#endif  // OVERHEAT_OVERRIDE
+    }
+}
+
+// Function CheckSafetyTrips: Returns the inputs that closed the security valve from interrupt context since the last
+//                            call, and brings the output flags in line with the pins the interrupt turned off
+uint8_t CheckSafetyTrips(SysInfo *p_system) {
+    uint8_t trips;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        trips = safety_trips;
+        safety_trips = 0;
+    }
+    if (trips) {
+        ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
+        ClearFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);
+        if (trips & (1 << OVERHEAT_F)) {
+            GasOff(p_system);
+        }
+    }
+    return trips;
+}
+
+// Function RunSafetyPath: Counts the armed safety checks down, closing the gas when one is confirmed (Timer0 compare ISR).
+// The pin change ISR arms a check within its own latency of the edge, the first count comes on the next tick and the
+// last one closes the valve. The gas is off at most confirmation ticks x 1.024 ms + ISR latency after the edge: 256 ms
+// on a flame loss and 10.24 ms on an overheat with the default settings, the latency being a few microseconds.
+static void RunSafetyPath(void) {
+    if (flame_loss_countdown) {
+        if (FlameLost() == false) {
+            flame_loss_countdown = 0;  // Flame back, or the gas was closed meanwhile
+        } else if (--flame_loss_countdown == 0) {
+            CutGas();
+            safety_trips |= (1 << FLAME_F);
+        }
+    }
+    if (overheat_countdown) {
+        if (Overheated() == false) {
+            overheat_countdown = 0;
+        } else if (--overheat_countdown == 0) {
+            CutGas();
+            safety_trips |= (1 << OVERHEAT_F);
+        }
+    }
+}
+
+// Flame detector pin change interrupt service routine: Arms the flame loss check
+ISR(FLAME_vect) {
+    if (FlameLost() && (debounced_inputs & (1 << FLAME_F))) {  // Only a stable flame can be lost, not an ignition attempt
+        if (flame_loss_countdown == 0) {
+            flame_loss_countdown = SAFETY_FLAME_LOSS_TIME;
+        }
+    } else {
+        flame_loss_countdown = 0;
+    }
+}
+
+#if !(OVERHEAT_OVERRIDE)
+// Overheat thermostat pin change interrupt service routine: Arms the overheat check
+ISR(OVERHEAT_vect) {
+    if (Overheated()) {
+        if (overheat_countdown == 0) {
+            overheat_countdown = SAFETY_OVERHEAT_TIME;
+        }
+    } else {
+        overheat_countdown = 0;
+    }
+}
+#endif  // OVERHEAT_OVERRIDE
+#endif  // SAFETY_FAST_PATH
+
+// Timer0 compare match A interrupt service routine: Safety fast path and debounce engine
+ISR(TIMER0_COMPA_vect) {
+#if SAFETY_FAST_PATH
+    RunSafetyPath();
+#endif  // SAFETY_FAST_PATH
+    // Inputs due for a sample on this tick
+    uint8_t strobe = 0;
+    for (uint8_t input = 0; input < DIGITAL_INPUTS; input++) {
+        if (--debounce_countdown[input] == 0) {
+            debounce_countdown[input] = sys_params.debounce_time[input] / DEBOUNCE_SAMPLES;
+            strobe |= (1 << input);
+        }
+    }
+    if (strobe == 0) {
+        return;
+    }
+    // 2-bit vertical counters: each sample that differs from the stable value counts, a matching one resets
+    // the counter, and the input toggles on the DEBOUNCE_SAMPLES-th consecutive differing sample
+    uint8_t stable = debounced_inputs;
+    uint8_t changed = ReadDigitalInputs() ^ stable;
+    uint8_t count_0 = ~(debounce_count_0 & changed);
+    uint8_t count_1 = count_0 ^ (debounce_count_1 & changed);
+    uint8_t toggle = changed & count_0 & count_1 & strobe;
+    // Only the sampled inputs advance their counters
+    debounce_count_0 = (debounce_count_0 & ~strobe) | (count_0 & strobe);
+    debounce_count_1 = (debounce_count_1 & ~strobe) | (count_1 & strobe);
+    debounced_inputs = stable ^ toggle;
 }
 
 //Function InitAnalogSensor: Sets the ADC hardware up and initializes the given sensor readout
@@ -266,50 +410,70 @@ void InitAnalogSensor(SysInfo *p_system, AnalogInput analog_sensor) {
     }
 }
 
-// Function CheckAnalogSensor: Returns the ADC readout of a given analog sensor
+// Function GetAdcBuffer: Returns the ring buffer that holds the readouts of a given analog sensor
+static RingBuffer *GetAdcBuffer(AdcBuffers *p_buffer_pack, AnalogInput analog_sensor) {
+    switch (analog_sensor) {
+        case DHW_TEMPERATURE: {
+            return &p_buffer_pack->dhw_temp_adc_buffer;
+        }
+        case CH_TEMPERATURE: {
+            return &p_buffer_pack->ch_temp_adc_buffer;
+        }
+        case DHW_SETTING: {
+            return &p_buffer_pack->dhw_set_adc_buffer;
+        }
+        case CH_SETTING: {
+            return &p_buffer_pack->ch_set_adc_buffer;
+        }
+        case SYSTEM_MODE: {
+            return &p_buffer_pack->sys_mod_adc_buffer;
+        }
+        default: {
+            return 0;
+        }
+    }
+}
+
+// Function StoreAdcReadout: Stores a new ADC readout in its buffer and updates the filters that run on each readout
+static void StoreAdcReadout(RingBuffer *p_ring, uint16_t adc_value) {
+    PushAdcBuffer(p_ring, adc_value);
+    if (p_ring->filter == FILTER_IIR) {
+        FilterIir(&p_ring->iir_value, adc_value);
+    }
+}
+
+// Function CheckAnalogSensor: Updates a given analog sensor readout from its ADC buffer and returns the last ADC sample
 uint16_t CheckAnalogSensor(SysInfo *p_system, AdcBuffers *p_buffer_pack, AnalogInput analog_sensor, bool show_dashboard) {
-    ADMUX = (0xF0 & ADMUX) | analog_sensor;
-    ADCSRA |= (1 << ADSC);
-    loop_until_bit_is_clear(ADCSRA, ADSC);
+    RingBuffer *p_ring = GetAdcBuffer(p_buffer_pack, analog_sensor);
+    uint16_t adc_filtered = 0;
+    uint16_t adc_sample = 0;
+    if (p_ring == 0) {
+        return 0;
+    }
+    // The ADC engine writes the buffers from its ISR, keep it out while reading them
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        adc_filtered = FilterAdcBuffer(p_ring);
+        adc_sample = p_ring->data[(p_ring->ix - 1) & (BUFFER_LENGTH - 1)];
+    }
     switch (analog_sensor) {
         case DHW_TEMPERATURE: {
-            p_buffer_pack->dhw_temp_adc_buffer.data[p_buffer_pack->dhw_temp_adc_buffer.ix++] = (ADC & 0x3FF);
-            if (p_buffer_pack->dhw_temp_adc_buffer.ix >= BUFFER_LENGTH) {
-                p_buffer_pack->dhw_temp_adc_buffer.ix = 0;
-            }
-            p_system->dhw_temperature = AverageAdc(p_buffer_pack->dhw_temp_adc_buffer.data, BUFFER_LENGTH, 0, MEAN);
+            p_system->dhw_temperature = adc_filtered;
             break;
         }
         case CH_TEMPERATURE: {
-            p_buffer_pack->ch_temp_adc_buffer.data[p_buffer_pack->ch_temp_adc_buffer.ix++] = (ADC & 0x3FF);
-            if (p_buffer_pack->ch_temp_adc_buffer.ix >= BUFFER_LENGTH) {
-                p_buffer_pack->ch_temp_adc_buffer.ix = 0;
-            }
-            p_system->ch_temperature = AverageAdc(p_buffer_pack->ch_temp_adc_buffer.data, BUFFER_LENGTH, 0, MEAN);
+            p_system->ch_temperature = adc_filtered;
             break;
         }
         case DHW_SETTING: {
-            p_buffer_pack->dhw_set_adc_buffer.data[p_buffer_pack->dhw_set_adc_buffer.ix++] = (ADC & 0x3FF);
-            if (p_buffer_pack->dhw_set_adc_buffer.ix >= BUFFER_LENGTH) {
-                p_buffer_pack->dhw_set_adc_buffer.ix = 0;
-            }
-            p_system->dhw_setting = AverageAdc(p_buffer_pack->dhw_set_adc_buffer.data, BUFFER_LENGTH, 0, MEAN);
+            p_system->dhw_setting = adc_filtered;
             break;
         }
         case CH_SETTING: {
-            p_buffer_pack->ch_set_adc_buffer.data[p_buffer_pack->ch_set_adc_buffer.ix++] = (ADC & 0x3FF);
-            if (p_buffer_pack->ch_set_adc_buffer.ix >= BUFFER_LENGTH) {
-                p_buffer_pack->ch_set_adc_buffer.ix = 0;
-            }
-            p_system->ch_setting = AverageAdc(p_buffer_pack->ch_set_adc_buffer.data, BUFFER_LENGTH, 0, MEAN);
+            p_system->ch_setting = adc_filtered;
             break;
         }
         case SYSTEM_MODE: {
-            p_buffer_pack->sys_mod_adc_buffer.data[p_buffer_pack->sys_mod_adc_buffer.ix++] = (ADC & 0x3FF);
-            if (p_buffer_pack->sys_mod_adc_buffer.ix >= BUFFER_LENGTH) {
-                p_buffer_pack->sys_mod_adc_buffer.ix = 0;
-            }
-            p_system->system_mode = AverageAdc(p_buffer_pack->sys_mod_adc_buffer.data, BUFFER_LENGTH, 0, MEAN);
+            p_system->system_mode = adc_filtered;
             break;
         }
         default: {
@@ -321,7 +485,46 @@ uint16_t CheckAnalogSensor(SysInfo *p_system, AdcBuffers *p_buffer_pack, AnalogI
         Dashboard(p_system, false);
     }
 #endif  // SHOW_DASHBOARD
-    return (ADC & 0x3FF);
+    return adc_sample;
+}
+
+// Function PreloadAnalogSensor: Runs a blocking ADC conversion of a given analog sensor and stores it in its buffer (setup only)
+void PreloadAnalogSensor(AdcBuffers *p_buffer_pack, AnalogInput analog_sensor) {
+    RingBuffer *p_ring = GetAdcBuffer(p_buffer_pack, analog_sensor);
+    if (p_ring == 0) {
+        return;
+    }
+    ADMUX = (0xF0 & ADMUX) | analog_sensor;
+    ADCSRA |= (1 << ADSC);
+    loop_until_bit_is_clear(ADCSRA, ADSC);
+    StoreAdcReadout(p_ring, (ADC & 0x3FF));
+}
+
+// ADC engine globals
+static AdcBuffers *p_adc_engine_buffers = 0;  // ADC buffers written by the ADC ISR
+static uint8_t adc_channel_ix = 0;            // Index in adc_channels of the conversion in progress
+
+// Function StartAdcEngine: Starts the interrupt-driven ADC acquisition, one conversion on each Timer0 overflow (system tick)
+void StartAdcEngine(AdcBuffers *p_buffer_pack) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        p_adc_engine_buffers = p_buffer_pack;
+        adc_channel_ix = 0;
+        ADMUX = (0xF0 & ADMUX) | adc_channels[adc_channel_ix];
+        ADCSRB = (1 << ADTS2);                 // Auto-trigger source: Timer/Counter0 overflow
+        ADCSRA |= (1 << ADIF);                 // Clear any pending ADC interrupt flag
+        ADCSRA |= (1 << ADATE) | (1 << ADIE);  // Enable auto-triggering and the conversion complete interrupt
+    }
+}
+
+// ADC conversion complete interrupt service routine
+ISR(ADC_vect) {
+    uint16_t adc_value = (ADC & 0x3FF);
+    StoreAdcReadout(GetAdcBuffer(p_adc_engine_buffers, adc_channels[adc_channel_ix]), adc_value);
+    // Select the next channel, its conversion will be triggered by the next system tick
+    if (++adc_channel_ix >= ADC_CHANNELS) {
+        adc_channel_ix = 0;
+    }
+    ADMUX = (0xF0 & ADMUX) | adc_channels[adc_channel_ix];
 }
 
 // Function InitActuator: Initializes a device actuator's output pin
@@ -469,6 +672,21 @@ void InitAdcBuffers(AdcBuffers *p_buffer_pack, uint8_t buffer_length) {
     p_buffer_pack->dhw_set_adc_buffer.ix = 0;
     p_buffer_pack->ch_set_adc_buffer.ix = 0;
     p_buffer_pack->sys_mod_adc_buffer.ix = 0;
+    p_buffer_pack->dhw_temp_adc_buffer.sum = 0;
+    p_buffer_pack->ch_temp_adc_buffer.sum = 0;
+    p_buffer_pack->dhw_set_adc_buffer.sum = 0;
+    p_buffer_pack->ch_set_adc_buffer.sum = 0;
+    p_buffer_pack->sys_mod_adc_buffer.sum = 0;
+    p_buffer_pack->dhw_temp_adc_buffer.iir_value = 0;
+    p_buffer_pack->ch_temp_adc_buffer.iir_value = 0;
+    p_buffer_pack->dhw_set_adc_buffer.iir_value = 0;
+    p_buffer_pack->ch_set_adc_buffer.iir_value = 0;
+    p_buffer_pack->sys_mod_adc_buffer.iir_value = 0;
+    p_buffer_pack->dhw_temp_adc_buffer.filter = DHW_TEMP_FILTER;
+    p_buffer_pack->ch_temp_adc_buffer.filter = CH_TEMP_FILTER;
+    p_buffer_pack->dhw_set_adc_buffer.filter = DHW_SET_FILTER;
+    p_buffer_pack->ch_set_adc_buffer.filter = CH_SET_FILTER;
+    p_buffer_pack->sys_mod_adc_buffer.filter = SYS_MOD_FILTER;
     for (uint8_t i = 0; i < buffer_length; i++) {
         p_buffer_pack->dhw_temp_adc_buffer.data[i] = 0;
         p_buffer_pack->ch_temp_adc_buffer.data[i] = 0;
@@ -482,6 +700,7 @@ void InitAdcBuffers(AdcBuffers *p_buffer_pack, uint8_t buffer_length) {
 uint16_t AverageAdc(uint16_t adc_buffer[], uint8_t buffer_len, uint8_t start, AverageType average_type) {
     uint16_t avg_value = 0;
     switch (average_type) {
+        case MOVING:  // A bare array has no running sum (see AverageAdcBuffer), fall back to the mean
         case MEAN: {
             for (uint8_t i = 0; i < buffer_len; i++) {
                 avg_value += adc_buffer[i];
@@ -506,15 +725,6 @@ uint16_t AverageAdc(uint16_t adc_buffer[], uint8_t buffer_len, uint8_t start, Av
             avg_value = avg_value / (buffer_len - 2);
             break;
         }
-        case MOVING: {
-            avg_value += adc_buffer[start];
-            if (start == (buffer_len - 1)) {
-                avg_value -= adc_buffer[0];
-            } else {
-                avg_value -= adc_buffer[start + 1];
-            }
-            break;
-        }
         default: {
             break;
         }
@@ -522,6 +732,47 @@ uint16_t AverageAdc(uint16_t adc_buffer[], uint8_t buffer_len, uint8_t start, Av
     return avg_value;
 }
 
+// Function PushAdcBuffer: Stores a new ADC readout in a ring buffer, overwriting the oldest one and updating the running sum
+void PushAdcBuffer(RingBuffer *p_ring, uint16_t adc_value) {
+    p_ring->sum -= p_ring->data[p_ring->ix];
+    p_ring->sum += adc_value;
+    p_ring->data[p_ring->ix] = adc_value;
+    p_ring->ix = (p_ring->ix + 1) & (BUFFER_LENGTH - 1);
+}
+
+// Function AverageAdcBuffer: Returns the average of a ring buffer, MOVING takes constant time from its running sum
+uint16_t AverageAdcBuffer(RingBuffer *p_ring, AverageType average_type) {
+    if (average_type == MOVING) {
+        return (p_ring->sum >> BUFFER_SHIFT);
+    }
+    return AverageAdc(p_ring->data, BUFFER_LENGTH, p_ring->ix, average_type);
+}
+
+// Function FilterAdcBuffer: Returns the readout of a ring buffer passed through its configured filter
+uint16_t FilterAdcBuffer(RingBuffer *p_ring) {
+    switch (p_ring->filter) {
+        case FILTER_MEAN: {
+            return AverageAdcBuffer(p_ring, MOVING);
+        }
+        case FILTER_ROBUST: {
+            return AverageAdcBuffer(p_ring, ROBUST);
+        }
+        case FILTER_FIR: {
+            return FilterFir(p_ring->data, BUFFER_LENGTH, (p_ring->ix - FIR_LEN) & (BUFFER_LENGTH - 1));
+        }
+        case FILTER_IIR: {
+            return p_ring->iir_value;
+        }
+        case FILTER_MEDIAN: {
+            return FilterMedian(p_ring->data, BUFFER_LENGTH, p_ring->ix);
+        }
+        case FILTER_NONE:
+        default: {
+            return p_ring->data[(p_ring->ix - 1) & (BUFFER_LENGTH - 1)];
+        }
+    }
+}
+
 // Function GetKnobPosition: Returns a knob position from a given potentiometer readout and range-intervals number
 uint8_t GetKnobPosition(int16_t pot_adc_value, uint8_t knob_steps) {
     uint8_t heat_level = 0;
@@ -549,39 +800,35 @@ void OpenHeatValve(SysInfo *p_system, HeatValve valve_to_open) {
     }
 }
 
+// Function ValveTime: Returns a heat level valve open time, scaled from the table cycle time to the heat cycle time parameter
+static uint16_t ValveTime(uint8_t heat_level_ix, HeatCycle heat_cycle, uint8_t valve) {
+    uint16_t valve_time = heat_level[heat_level_ix].valve_time[heat_cycle][valve];
+    uint16_t table_cycle = (heat_cycle == DHW_CYCLE) ? HEAT_TABLE_DHW_CYCLE : HEAT_TABLE_CH_CYCLE;
+    uint16_t cycle = (heat_cycle == DHW_CYCLE) ? sys_params.dhw_heat_cycle_time : sys_params.ch_heat_cycle_time;
+    if (cycle == table_cycle) {
+        return valve_time;
+    }
+    return (uint16_t)(((uint32_t)valve_time * cycle) / table_cycle);
+}
+
 // Function Modulate Heat: Modulates heat by toggling system valves according to the selected heat level index
-void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, uint32_t heat_cycle_time) {
+void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, HeatCycle heat_cycle) {
     //
     // [ # # # ] Heat modulation code  [ # # # ]
     //
+    // NOTE: The heat level table is validated when it is generated, every level's valve times add up to the cycle time
+    // (scaled to a non-default cycle time parameter, the rounding may shorten the cycle by a few milliseconds)
     if (p_system->cycle_in_progress == false) {
-        uint8_t heat_level_time_usage = 0;
-        // Check heat level integrity
-        for (uint8_t valve_time_check = 0; valve_time_check < HEAT_MODULATOR_VALVES; valve_time_check++) {
-            heat_level_time_usage += heat_level[p_system->current_heat_level].valve_open_time[valve_time_check];
-        }
-        if (heat_level_time_usage != 100) {
-#if LED_DEBUG
-            SetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);  // Heat level setting error, the sum of the opening time of all valves must be 100!
-            _delay_ms(5000);                                   // 5-second blocking delay to indicate heat level setting errors
-            ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
-#endif
-            // FAIL-SAFE: Auto cool down in case of heat cycle error
-            p_system->current_heat_level = 0;
-            p_system->cycle_in_progress = false;
-            // return 1; // At his point, it should jump to the error state
-        } else {
-            // Set cycle in progress
-            p_system->cycle_in_progress = true;
-            p_system->current_valve = 0;
-            ResetTimerLapse(HEAT_TIMER_ID, ((uint32_t)(heat_level[p_system->current_heat_level].valve_open_time[p_system->current_valve] * heat_cycle_time / 100)));
-        }
+        // Set cycle in progress
+        p_system->cycle_in_progress = true;
+        p_system->current_valve = 0;
+        ResetTimerLapse(HEAT_TIMER_ID, ValveTime(p_system->current_heat_level, heat_cycle, p_system->current_valve));
     } else {
         if (TimerFinished(HEAT_TIMER_ID)) {
             // Prepare timing for next valve
-            p_system->current_valve++;
-            ResetTimerLapse(HEAT_TIMER_ID, ((uint32_t)heat_level[p_system->current_heat_level].valve_open_time[p_system->current_valve] * heat_cycle_time / 100));
-            if (p_system->current_valve >= HEAT_MODULATOR_VALVES) {
+            if (++p_system->current_valve < HEAT_MODULATOR_VALVES) {
+                ResetTimerLapse(HEAT_TIMER_ID, ValveTime(p_system->current_heat_level, heat_cycle, p_system->current_valve));
+            } else {
                 // Cycle end: Reset to first valve
 #if LED_DEBUG
                 if (GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F)) {  // Toggle SPARK_IGNITER_F on each heat-cycle start
@@ -593,11 +840,11 @@ void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, uint32_t heat_cycle_
                 p_system->cycle_in_progress = false;
 #if HEAT_MODULATOR_DEMO
                 // DEMO MODE: loops through all heat levels, from lower to higher
-                if (p_system->current_heat_level++ >= (sizeof(heat_level) / sizeof(heat_level[0])) - 1) {
+                if (p_system->current_heat_level++ >= HEAT_LEVELS - 1) {
                     p_system->current_heat_level = 0;
                 }
 #else
-                // Read the DHW potentiometer to determine current heat level
+                // Apply the heat level chosen by the DHW or CH controller for the next cycle
                 p_system->current_heat_level = heat_level_ix;
 #endif
             }
@@ -619,18 +866,37 @@ void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, uint32_t heat_cycle_
     //
 }
 
-// Function GasOff: Closes all heat valves and the security valve, turns the spark igniter and exhaust fan off
+// Function GasOffStep: Turns off the next device of the staged gas shutdown, stops the timer after the last one
+static void GasOffStep(TimerId timer_id) {
+    for (uint8_t step = 0; step < GAS_OFF_STEPS; step++) {
+        uint8_t device_flag = gas_off_order[step];
+        if (gas_off_pending & (1 << device_flag)) {
+            gas_off_pending &= ~(1 << device_flag);
+            ClearFlag(p_gas_off_system, OUTPUT_FLAGS, device_flag);
+            break;
+        }
+    }
+    if (gas_off_pending == 0) {
+        DeleteTimer(timer_id);
+    }
+}
+
+// Function GasOff: Closes the security valve and turns the spark igniter off at once, then closes all heat
+//                  valves and turns the exhaust fan off, one every GAS_OFF_STEP_DELAY ms without blocking
 void GasOff(SysInfo *p_system) {
-    ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);  // Turn spark igniter off
-    _delay_ms(5);                                        // Blocking delay
-    ClearFlag(p_system, OUTPUT_FLAGS, VALVE_3_F);        // Close gas valve 3
-    _delay_ms(5);                                        // Blocking delay
-    ClearFlag(p_system, OUTPUT_FLAGS, VALVE_2_F);        // Close gas valve 2
-    _delay_ms(5);                                        // Blocking delay
-    ClearFlag(p_system, OUTPUT_FLAGS, VALVE_1_F);        // Close gas valve 1
-    _delay_ms(5);                                        // Blocking delay
-    ClearFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);        // Close gas security valve
-    _delay_ms(5);                                        // Blocking delay
-    ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);    // Turn exhaust fan off
-    _delay_ms(5);                                        // Blocking delay
+    // The security valve cuts the gas to all heat valves
+    if (p_system->output_flags & ((1 << SPARK_IGNITER_F) | (1 << VALVE_S_F))) {
+        ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);  // Turn spark igniter off
+        ClearFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);        // Close gas security valve
+    }
+    uint8_t devices_on = p_system->output_flags & GAS_OFF_MASK;
+    if ((devices_on & ~gas_off_pending) == 0) {
+        return;  // Nothing left to turn off, or its shutdown is already in progress
+    }
+    if (gas_off_pending == 0) {
+        SetTimer(GAS_OFF_TIMER_ID, GAS_OFF_STEP_DELAY, RUN_CONTINUOUSLY);
+        SetTimerCallback(GAS_OFF_TIMER_ID, GasOffStep);
+    }
+    gas_off_pending |= devices_on;
+    p_gas_off_system = p_system;
 }
@@ -12,17 +12,29 @@
 #ifndef HAL_H
 #define HAL_H
 
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <avr/wdt.h>
 #include <serial-ui.h>
 #include <stdbool.h>
 #include <temp-calc.h>
 #include <timers.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 
 #include "../../include/errors.h"
 #include "../../include/hw-mapping.h"
 #include "../../include/sys-settings.h"
+#include "heat-table.h"
+
+#if (HEAT_TABLE_VALVES != HEAT_MODULATOR_VALVES)
+#error "heat-table.h was generated for another number of heat valves, rebuild it with tools/heat-table-gen.py"
+#endif
+
+// The heat cycle times are runtime parameters, ModulateHeat scales the table valve times to them
+#if ((HEAT_TABLE_DHW_CYCLE != DHW_HEAT_CYCLE_TIME) || (HEAT_TABLE_CH_CYCLE != CH_HEAT_CYCLE_TIME))
+#error "heat-table.h was generated for other default heat cycle times, rebuild it with tools/heat-table-gen.py"
+#endif
 
 #define ADC_MIN 0     // System 10-bit ADC device minimum value
 #define ADC_MAX 1023  // System 10-bit ADC device maximum value
@@ -30,6 +42,34 @@
 #define ADC_MIN_THRESHOLD (ADC_MIN + (ADC_MAX / 200))  // Safety threshold to consider an ADC readout as the range lowest value
 #define ADC_MAX_THRESHOLD (ADC_MAX - (ADC_MAX / 200))  // Safety threshold to consider an ADC readout as the range highest value
 
+#if ((BUFFER_LENGTH * ADC_MAX) > UINT16_MAX)
+#error "RingBuffer running sum overflows, reduce BUFFER_LENGTH"
+#endif
+
+#define ADC_CHANNELS 5  // Number of analog inputs sampled by the ADC engine (one conversion per system tick, each channel every ~5 ms)
+
+#define DIGITAL_INPUTS (OVERHEAT_F + 1)  // Number of digital inputs sampled by the debounce engine, one bit each in input_flags
+#define DEBOUNCE_SAMPLES 4               // Consecutive samples needed to change an input (2-bit vertical counters)
+
+#if ((DEB_DHW_REQUEST_TIME < DEBOUNCE_SAMPLES) || (DEB_CH_REQUEST_TIME < DEBOUNCE_SAMPLES) || (DEB_AIRFLOW_TIME < DEBOUNCE_SAMPLES) || \
+     (DEB_FLAME_TIME < DEBOUNCE_SAMPLES) || (DEB_OVERHEAT_TIME < DEBOUNCE_SAMPLES))
+#error "Debounce times must be at least DEBOUNCE_SAMPLES milliseconds"
+#endif
+
+#if ((DEB_DHW_REQUEST_TIME / DEBOUNCE_SAMPLES > 255) || (DEB_CH_REQUEST_TIME / DEBOUNCE_SAMPLES > 255) || (DEB_AIRFLOW_TIME / DEBOUNCE_SAMPLES > 255) || \
+     (DEB_FLAME_TIME / DEBOUNCE_SAMPLES > 255) || (DEB_OVERHEAT_TIME / DEBOUNCE_SAMPLES > 255))
+#error "Debounce times must be at most 255 * DEBOUNCE_SAMPLES milliseconds"
+#endif
+
+// Safety fast path: an unsafe edge is confirmed when the pin holds its level for the confirmation time, counted
+// in system ticks (1.024 ms). The security valve closes at most confirmation time x 1.024 ms after the edge.
+#if SAFETY_FAST_PATH
+#if ((SAFETY_FLAME_LOSS_TIME < 1) || (SAFETY_FLAME_LOSS_TIME > DEB_FLAME_TIME) || \
+     (SAFETY_OVERHEAT_TIME < 1) || (SAFETY_OVERHEAT_TIME > DEB_OVERHEAT_TIME))
+#error "Safety confirmation times must be 1 ms or longer and not exceed the debounce time of their input"
+#endif
+#endif  // SAFETY_FAST_PATH
+
 // Types
 
 typedef enum hw_switch {
@@ -43,9 +83,21 @@ typedef enum average_type {
     MOVING = 2
 } AverageType;
 
+typedef enum adc_filter {
+    FILTER_NONE = 0,    // Latest readout
+    FILTER_MEAN = 1,    // Mean of the whole buffer (running sum)
+    FILTER_ROBUST = 2,  // Mean of the whole buffer without its highest and lowest readouts
+    FILTER_FIR = 3,     // Low-pass FIR over the latest FIR_LEN readouts
+    FILTER_IIR = 4,     // First-order low-pass IIR, updated on each readout
+    FILTER_MEDIAN = 5   // Median of the latest MEDIAN_LEN readouts
+} AdcFilter;
+
 typedef struct ring_buffer {
-    uint16_t data[BUFFER_LENGTH];
-    uint8_t ix;
+    uint16_t data[BUFFER_LENGTH];  // ADC readouts
+    uint16_t sum;                  // Running sum of all readouts in data (BUFFER_LENGTH * ADC_MAX fits in 16 bits)
+    uint16_t iir_value;            // IIR filter state
+    uint8_t ix;                    // Next write position (oldest readout)
+    AdcFilter filter;              // Filter applied to the readouts of this input
 } RingBuffer;
 
 typedef struct adc_buffers {
@@ -65,54 +117,43 @@ void ClearFlag(SysInfo *p_system, FlagsType flags_type, uint8_t flag_position);
 void ToggleFlag(SysInfo *p_system, FlagsType flags_type, uint8_t flag_position);
 bool GetFlag(SysInfo *p_system, FlagsType flags_type, uint8_t flag_position);
 void InitDigitalSensor(SysInfo *p_system, InputFlag digital_sensor);
-bool CheckDigitalSensor(SysInfo *p_system, InputFlag digital_sensor, bool show_dashboard);
+uint8_t CheckDigitalSensors(SysInfo *p_system, bool show_dashboard);
+void StartDebounceEngine(void);
+#if SHELL_SENSOR_SIM
+void SimulateDigitalInput(InputFlag input, bool forced, bool active);
+#endif  // SHELL_SENSOR_SIM
+#if SAFETY_FAST_PATH
+void StartSafetyPath(void);
+uint8_t CheckSafetyTrips(SysInfo *p_system);
+#endif  // SAFETY_FAST_PATH
 void InitAnalogSensor(SysInfo *p_system, AnalogInput analog_sensor);
 uint16_t CheckAnalogSensor(SysInfo *p_system, AdcBuffers *p_buffer_pack, AnalogInput analog_sensor, bool show_dashboard);
+void PreloadAnalogSensor(AdcBuffers *p_buffer_pack, AnalogInput analog_sensor);
+void StartAdcEngine(AdcBuffers *p_buffer_pack);
 void InitActuator(SysInfo *p_system, OutputFlag device_flag);
 void ControlActuator(SysInfo *p_system, OutputFlag device_flag, HwSwitch command, bool show_dashboard);
 void InitAdcBuffers(AdcBuffers *p_buffer_pack, uint8_t buffer_length);
 uint16_t AverageAdc(uint16_t adc_buffer[], uint8_t buffer_len, uint8_t start, AverageType average_type);
+void PushAdcBuffer(RingBuffer *p_ring, uint16_t adc_value);
+uint16_t AverageAdcBuffer(RingBuffer *p_ring, AverageType average_type);
+uint16_t FilterAdcBuffer(RingBuffer *p_ring);
 uint8_t GetKnobPosition(int16_t pot_adc_value, uint8_t knob_steps);
 void OpenHeatValve(SysInfo *p_system, HeatValve valve_to_open);
 //void ModulateHeat(SysInfo *p_system, uint16_t potentiometer_readout, uint8_t potentiometer_steps, uint32_t heat_cycle_time);
-void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, uint32_t heat_cycle_time);
+void ModulateHeat(SysInfo *p_system, uint8_t heat_level_ix, HeatCycle heat_cycle);
 void GasOff(SysInfo *p_system);
 
 // Globals
 
-// Heat levels valve settings
-// ....................................................
-// { { %valve-1, %valve-3, %valve-3 }, Kcal/h, G20_m3 }
-// ....................................................
-static const HeatLevel __flash heat_level[] = {
-    {{100, 0, 0}, 7000, 0.870},    // Heat level 0 = 7000 Kcal/h
-    {{83, 17, 0}, 7833, 0.968},    // Heat level 1 = 7833 Kcal/h
-    {{67, 33, 0}, 8667, 1.067},    // Heat level 2 = 8667 Kcal/h
-    {{83, 0, 17}, 9167, 1.123},    // Heat level 3 = 9167 Kcal/h
-    {{50, 50, 0}, 9500, 1.165},    // Heat level 4 = 9500 Kcal/h
-    {{67, 17, 16}, 10000, 1.222},  // Heat level 5 = 10000 Kcal/h
-    {{33, 67, 0}, 10333, 1.263},   // Heat level 6 = 10333 Kcal/h
-    {{50, 33, 17}, 10833, 1.320},  // Heat level 7 = 10833 Kcal/h
-    {{17, 83, 0}, 11167, 1.362},   // Heat level 8 = 11167 Kcal/h
-    {{67, 0, 33}, 11333, 1.377},   // Heat level 9 = 11333 Kcal/h
-    {{33, 50, 17}, 11667, 1.418},  // Heat level 10 = 11667 Kcal/h
-    {{0, 100, 0}, 12000, 1.460},   // Heat level 11 = 12000 Kcal/h
-    {{50, 17, 33}, 12167, 1.475},  // Heat level 12 = 12167 Kcal/h
-    {{17, 67, 16}, 12500, 1.517},  // Heat level 13 = 12500 Kcal/h
-    {{34, 33, 33}, 13000, 1.573},  // Heat level 14 = 13000 Kcal/h
-    {{0, 83, 17}, 13333, 1.615},   // Heat level 15 = 13333 Kcal/h
-    {{50, 0, 50}, 13500, 1.630},   // Heat level 16 = 13500 Kcal/h
-    {{17, 50, 33}, 13833, 1.672},  // Heat level 17 = 13833 Kcal/h
-    {{33, 17, 50}, 14333, 1.728},  // Heat level 18 = 14333 Kcal/h
-    {{0, 67, 33}, 14667, 1.770},   // Heat level 19 = 14667 Kcal/h
-    {{17, 33, 50}, 15167, 1.827},  // Heat level 20 = 15167 Kcal/h
-    {{33, 0, 67}, 15667, 1.883},   // Heat level 21 = 15667 Kcal/h
-    {{0, 50, 50}, 16000, 1.925},   // Heat level 22 = 16000 Kcal/h
-    {{17, 17, 66}, 16500, 1.982},  // Heat level 23 = 16500 Kcal/h
-    {{0, 33, 67}, 17333, 2.080},   // Heat level 24 = 17333 Kcal/h
-    {{17, 0, 83}, 17833, 2.137},   // Heat level 25 = 17833 Kcal/h
-    {{0, 17, 83}, 18667, 2.235},   // Heat level 26 = 18667 Kcal/h
-    {{0, 0, 100}, 20000, 2.390}    // Heat level 27 = 20000 Kcal/h
-};
+// Staged gas shutdown order, after the security valve and the spark igniter
+#define GAS_OFF_STEPS 4
+#define GAS_OFF_MASK ((1 << VALVE_3_F) | (1 << VALVE_2_F) | (1 << VALVE_1_F) | (1 << EXHAUST_FAN_F))
+static const OutputFlag __flash gas_off_order[GAS_OFF_STEPS] = {VALVE_3_F, VALVE_2_F, VALVE_1_F, EXHAUST_FAN_F};
+
+// Analog inputs sampled by the ADC engine, in conversion order
+static const AnalogInput __flash adc_channels[ADC_CHANNELS] = {
+    DHW_TEMPERATURE, CH_TEMPERATURE, DHW_SETTING, CH_SETTING, SYSTEM_MODE};
+
+// Heat levels valve settings: generated into heat-table.h by tools/heat-table-gen.py
 
 #endif  // HAL_H
@@ -0,0 +1,66 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: heat-table.h (heat modulator level table)
+ *  ........................................................
+ *  GENERATED BY tools/heat-table-gen.py - DO NOT EDIT
+ *  ........................................................
+ */
+
+#ifndef HEAT_TABLE_H
+#define HEAT_TABLE_H
+
+#include <avr/io.h>
+
+// Parameters used to build the table
+#define HEAT_TABLE_VALVES 3         // Heat modulator valves
+#define HEAT_TABLE_RESOLUTION 6     // Heat cycle slots shared among the valves
+#define HEAT_TABLE_DHW_CYCLE 15000  // DHW heat cycle time (milliseconds)
+#define HEAT_TABLE_CH_CYCLE 20000   // CH heat cycle time (milliseconds)
+
+// Heat valve ratings: heat output (kcal/h) and G20 gas usage (litres/h)
+#define VALVE_1_KCAL_H 7000   // Valve 1 heat output
+#define VALVE_1_GAS_LH 870    // Valve 1 gas usage
+#define VALVE_2_KCAL_H 12000  // Valve 2 heat output
+#define VALVE_2_GAS_LH 1460   // Valve 2 gas usage
+#define VALVE_3_KCAL_H 20000  // Valve 3 heat output
+#define VALVE_3_GAS_LH 2390   // Valve 3 gas usage
+
+#define HEAT_LEVELS 28  // Heat levels, from lower to higher
+
+// ..........................................................................
+// { { DHW cycle valve ms }, { CH cycle valve ms } }, Kcal/h, G20 l/h
+// ..........................................................................
+static const HeatLevel __flash heat_level[HEAT_LEVELS] = {
+    {{{15000, 0, 0}, {20000, 0, 0}}, 7000, 870},                // Heat level 0 = 7000 Kcal/h (6/0/0 slots)
+    {{{12500, 2500, 0}, {16666, 3334, 0}}, 7833, 968},          // Heat level 1 = 7833 Kcal/h (5/1/0 slots)
+    {{{10000, 5000, 0}, {13333, 6667, 0}}, 8667, 1067},         // Heat level 2 = 8667 Kcal/h (4/2/0 slots)
+    {{{12500, 0, 2500}, {16666, 0, 3334}}, 9167, 1123},         // Heat level 3 = 9167 Kcal/h (5/0/1 slots)
+    {{{7500, 7500, 0}, {10000, 10000, 0}}, 9500, 1165},         // Heat level 4 = 9500 Kcal/h (3/3/0 slots)
+    {{{10000, 2500, 2500}, {13333, 3333, 3334}}, 10000, 1222},  // Heat level 5 = 10000 Kcal/h (4/1/1 slots)
+    {{{5000, 10000, 0}, {6666, 13334, 0}}, 10333, 1263},        // Heat level 6 = 10333 Kcal/h (2/4/0 slots)
+    {{{7500, 5000, 2500}, {10000, 6666, 3334}}, 10833, 1320},   // Heat level 7 = 10833 Kcal/h (3/2/1 slots)
+    {{{2500, 12500, 0}, {3333, 16667, 0}}, 11167, 1362},        // Heat level 8 = 11167 Kcal/h (1/5/0 slots)
+    {{{10000, 0, 5000}, {13333, 0, 6667}}, 11333, 1377},        // Heat level 9 = 11333 Kcal/h (4/0/2 slots)
+    {{{5000, 7500, 2500}, {6666, 10000, 3334}}, 11667, 1418},   // Heat level 10 = 11667 Kcal/h (2/3/1 slots)
+    {{{0, 15000, 0}, {0, 20000, 0}}, 12000, 1460},              // Heat level 11 = 12000 Kcal/h (0/6/0 slots)
+    {{{7500, 2500, 5000}, {10000, 3333, 6667}}, 12167, 1475},   // Heat level 12 = 12167 Kcal/h (3/1/2 slots)
+    {{{2500, 10000, 2500}, {3333, 13333, 3334}}, 12500, 1517},  // Heat level 13 = 12500 Kcal/h (1/4/1 slots)
+    {{{5000, 5000, 5000}, {6666, 6666, 6668}}, 13000, 1573},    // Heat level 14 = 13000 Kcal/h (2/2/2 slots)
+    {{{0, 12500, 2500}, {0, 16666, 3334}}, 13333, 1615},        // Heat level 15 = 13333 Kcal/h (0/5/1 slots)
+    {{{7500, 0, 7500}, {10000, 0, 10000}}, 13500, 1630},        // Heat level 16 = 13500 Kcal/h (3/0/3 slots)
+    {{{2500, 7500, 5000}, {3333, 10000, 6667}}, 13833, 1672},   // Heat level 17 = 13833 Kcal/h (1/3/2 slots)
+    {{{5000, 2500, 7500}, {6666, 3333, 10001}}, 14333, 1728},   // Heat level 18 = 14333 Kcal/h (2/1/3 slots)
+    {{{0, 10000, 5000}, {0, 13333, 6667}}, 14667, 1770},        // Heat level 19 = 14667 Kcal/h (0/4/2 slots)
+    {{{2500, 5000, 7500}, {3333, 6666, 10001}}, 15167, 1827},   // Heat level 20 = 15167 Kcal/h (1/2/3 slots)
+    {{{5000, 0, 10000}, {6666, 0, 13334}}, 15667, 1883},        // Heat level 21 = 15667 Kcal/h (2/0/4 slots)
+    {{{0, 7500, 7500}, {0, 10000, 10000}}, 16000, 1925},        // Heat level 22 = 16000 Kcal/h (0/3/3 slots)
+    {{{2500, 2500, 10000}, {3333, 3333, 13334}}, 16500, 1982},  // Heat level 23 = 16500 Kcal/h (1/1/4 slots)
+    {{{0, 5000, 10000}, {0, 6666, 13334}}, 17333, 2080},        // Heat level 24 = 17333 Kcal/h (0/2/4 slots)
+    {{{2500, 0, 12500}, {3333, 0, 16667}}, 17833, 2137},        // Heat level 25 = 17833 Kcal/h (1/0/5 slots)
+    {{{0, 2500, 12500}, {0, 3333, 16667}}, 18667, 2235},        // Heat level 26 = 18667 Kcal/h (0/1/5 slots)
+    {{{0, 0, 15000}, {0, 0, 20000}}, 20000, 2390}               // Heat level 27 = 20000 Kcal/h (0/0/6 slots)
+};
+
+#endif  // HEAT_TABLE_H
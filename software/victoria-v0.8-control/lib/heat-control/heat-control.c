@@ -0,0 +1,131 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: heat-control.c (closed-loop heat control library)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "heat-control.h"
+
+static PiControl dhw_pi = {DHW_PI_KP, DHW_PI_KI, (int32_t)DHW_PI_START_LEVEL << PI_SHIFT};
+#if CH_CLOSED_LOOP
+static PiControl ch_pi = {CH_PI_KP, CH_PI_KI, (int32_t)CH_PI_START_LEVEL << PI_SHIFT};
+#endif  // CH_CLOSED_LOOP
+static uint32_t ch_burner_time = 0;  // Time of the last CH burner start or stop (milliseconds)
+
+// Function GetTarget: Maps a knob readout to a target temperature between two limits (tenths of a degree Celsius)
+static int16_t GetTarget(uint16_t knob_readout, uint8_t knob_steps, int16_t target_min, int16_t target_max) {
+    uint8_t knob = GetKnobPosition(knob_readout, knob_steps);
+    return target_min + (int16_t)(((int32_t)(target_max - target_min) * knob) / (knob_steps - 1));
+}
+
+#if CH_CLOSED_LOOP
+// Function GetChError: Returns the CH target minus the CH temperature (tenths of a degree), 0 if the readout is invalid
+static int16_t GetChError(SysInfo *p_system) {
+    int16_t temperature = GetNtcTemperature(p_system->ch_temperature, TO_CELSIUS, DT_CELSIUS);
+    if (temperature == INVALID_TEMP_D) {
+        return 0;  // The sensor range checks stop the burner
+    }
+    return GetChTarget(p_system) - temperature;
+}
+#endif  // CH_CLOSED_LOOP
+
+// Function StepPi: Runs a PI controller step with an error in tenths of a degree, returns the heat level index
+uint8_t StepPi(PiControl *p_pi, int16_t error) {
+    int32_t integral = p_pi->integral + ((int32_t)p_pi->ki * error);
+    if (integral > PI_OUTPUT_MAX) {
+        integral = PI_OUTPUT_MAX;
+    } else if (integral < 0) {
+        integral = 0;
+    }
+    int32_t output = ((int32_t)p_pi->kp * error) + integral;
+    // Anti-windup: the integral term only moves while the output isn't saturated in the direction of the error
+    if (output > PI_OUTPUT_MAX) {
+        output = PI_OUTPUT_MAX;
+        if (error < 0) {
+            p_pi->integral = integral;
+        }
+    } else if (output < 0) {
+        output = 0;
+        if (error > 0) {
+            p_pi->integral = integral;
+        }
+    } else {
+        p_pi->integral = integral;
+    }
+    return (uint8_t)((output + (1 << (PI_SHIFT - 1))) >> PI_SHIFT);
+}
+
+// Function ResetHeatControl: Presets the controller of the service that takes control of the burner
+void ResetHeatControl(SysInfo *p_system) {
+    if (p_system->system_state == DHW_ON_DUTY) {
+        dhw_pi.integral = (int32_t)DHW_PI_START_LEVEL << PI_SHIFT;
+    } else if (p_system->system_state == CH_ON_DUTY) {
+        // The CH integral term is kept across burner restarts: it holds the heat level the CH load needs
+        ch_burner_time = GetMilliseconds();
+    }
+}
+
+// Function GetDhwTarget: Returns the DHW target temperature set by the DHW knob (tenths of a degree Celsius)
+int16_t GetDhwTarget(SysInfo *p_system) {
+    return GetTarget(p_system->dhw_setting, DHW_SETTING_STEPS, DHW_TARGET_MIN, DHW_TARGET_MAX);
+}
+
+// Function GetDhwHeatLevel: Returns the heat level for the next DHW heat cycle
+uint8_t GetDhwHeatLevel(SysInfo *p_system) {
+#if DHW_CLOSED_LOOP
+    int16_t temperature = GetNtcTemperature(p_system->dhw_temperature, TO_CELSIUS, DT_CELSIUS);
+    if (temperature == INVALID_TEMP_D) {
+        return 0;  // The sensor range checks stop the burner, meanwhile use the lowest heat level
+    }
+    return StepPi(&dhw_pi, GetDhwTarget(p_system) - temperature);
+#else
+    return GetKnobPosition(p_system->dhw_setting, DHW_SETTING_STEPS);
+#endif  // DHW_CLOSED_LOOP
+}
+
+// Function ChBurnerStopped: Starts the CH minimum off-time count
+void ChBurnerStopped(void) {
+    ch_burner_time = GetMilliseconds();
+}
+
+// Function GetChTarget: Returns the CH flow target temperature set by the CH knob (tenths of a degree Celsius)
+int16_t GetChTarget(SysInfo *p_system) {
+    return GetTarget(p_system->ch_setting, CH_SETTING_STEPS, CH_TARGET_MIN, CH_TARGET_MAX);
+}
+
+// Function GetChHeatLevel: Returns the heat level for the next CH heat cycle
+uint8_t GetChHeatLevel(SysInfo *p_system) {
+#if CH_CLOSED_LOOP
+    return StepPi(&ch_pi, GetChError(p_system));
+#else
+    return GetKnobPosition(p_system->ch_setting, CH_SETTING_STEPS);
+#endif  // CH_CLOSED_LOOP
+}
+
+// Function ChTargetReached: Tells if the CH burner should stop, the lowest heat level still overshoots the target
+bool ChTargetReached(SysInfo *p_system) {
+#if CH_CLOSED_LOOP
+    int16_t error = GetChError(p_system);
+    if (error <= -CH_MAX_OVERSHOOT) {
+        return true;
+    }
+    return ((error <= -CH_OFF_HYSTERESIS) && ((GetMilliseconds() - ch_burner_time) >= CH_MIN_ON_TIME));
+#else
+    // NOTE: The temperature reading last bit is masked out to avoid oscillations (lower readouts are hotter)
+    return ((p_system->ch_temperature & CH_TEMP_MASK) < sys_params.ch_setpoint_high);
+#endif  // CH_CLOSED_LOOP
+}
+
+// Function ChHeatNeeded: Tells if the CH burner should restart after a pause
+bool ChHeatNeeded(SysInfo *p_system) {
+#if CH_CLOSED_LOOP
+    return ((GetChError(p_system) >= CH_ON_HYSTERESIS) && ((GetMilliseconds() - ch_burner_time) >= CH_MIN_OFF_TIME));
+#else
+    return ((p_system->ch_temperature & CH_TEMP_MASK) >= sys_params.ch_setpoint_low);
+#endif  // CH_CLOSED_LOOP
+}
@@ -0,0 +1,53 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: heat-control.h (closed-loop heat control headers)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef HEAT_CONTROL_H
+#define HEAT_CONTROL_H
+
+#include <hal.h>
+#include <stdbool.h>
+#include <temp-calc.h>
+#include <timers.h>
+
+#include "../../include/sys-settings.h"
+
+#define PI_SHIFT 8                                            // PI output fraction bits: the output is in 1/256 heat level steps
+#define PI_OUTPUT_MAX ((int32_t)(HEAT_LEVELS - 1) << PI_SHIFT)  // PI output for the highest heat level
+
+#if ((DHW_TARGET_MIN >= DHW_TARGET_MAX) || (DHW_PI_START_LEVEL >= HEAT_LEVELS))
+#error "Check the DHW closed-loop control settings"
+#endif
+
+#if ((CH_TARGET_MIN >= CH_TARGET_MAX) || (CH_PI_START_LEVEL >= HEAT_LEVELS) || (CH_OFF_HYSTERESIS > CH_MAX_OVERSHOOT))
+#error "Check the CH closed-loop control settings"
+#endif
+
+// Types
+
+typedef struct pi_control {
+    int16_t kp;        // Proportional gain (1/256 heat level steps per tenth of a degree)
+    int16_t ki;        // Integral gain (1/256 heat level steps per tenth of a degree, added on each step)
+    int32_t integral;  // Integral term, kept inside the output range (1/256 heat level steps)
+} PiControl;
+
+// Prototypes
+
+uint8_t StepPi(PiControl *p_pi, int16_t error);
+void ResetHeatControl(SysInfo *p_system);
+int16_t GetDhwTarget(SysInfo *p_system);
+uint8_t GetDhwHeatLevel(SysInfo *p_system);
+void ChBurnerStopped(void);
+int16_t GetChTarget(SysInfo *p_system);
+uint8_t GetChHeatLevel(SysInfo *p_system);
+bool ChTargetReached(SysInfo *p_system);
+bool ChHeatNeeded(SysInfo *p_system);
+
+#endif  // HEAT_CONTROL_H
@@ -0,0 +1,81 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: num-format.c (printf-free number formatting library)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "num-format.h"
+
+// Function DivMod10: Divides by 10 with shifts and adds (no division routine), returns the quotient and stores the remainder
+uint32_t DivMod10(uint32_t number, uint8_t *p_remainder) {
+    uint32_t quotient;
+    if (number <= UINT16_MAX) {
+        // 16-bit path, most dashboard numbers fit here
+        uint16_t n = (uint16_t)number;
+        uint16_t q = (n >> 1) + (n >> 2);
+        q += q >> 4;
+        q += q >> 8;
+        q >>= 3;
+        uint8_t r = (uint8_t)(n - ((q << 3) + (q << 1)));
+        if (r > 9) {
+            q++;
+            r -= 10;
+        }
+        *p_remainder = r;
+        return q;
+    }
+    quotient = (number >> 1) + (number >> 2);  // number * 0.75 ...
+    quotient += quotient >> 4;                 // ... * 0.8 in binary, then / 8
+    quotient += quotient >> 8;
+    quotient += quotient >> 16;
+    quotient >>= 3;
+    uint8_t remainder = (uint8_t)(number - ((quotient << 3) + (quotient << 1)));
+    if (remainder > 9) {  // The estimate is at most one short
+        quotient++;
+        remainder -= 10;
+    }
+    *p_remainder = remainder;
+    return quotient;
+}
+
+// Function FormatUnsigned: Writes a number in decimal, zero-padded to min_digits, returns its length (without the NUL)
+uint8_t FormatUnsigned(char *p_str, uint32_t number, uint8_t min_digits) {
+    char digits[NUM_STR_LENGTH];
+    uint8_t length = 0;
+    do {
+        uint8_t remainder;
+        number = DivMod10(number, &remainder);
+        digits[length++] = '0' + remainder;
+    } while (number != 0);
+    while ((length < min_digits) && (length < (NUM_STR_LENGTH - 2))) {
+        digits[length++] = '0';
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        p_str[i] = digits[length - 1 - i];
+    }
+    p_str[length] = 0;
+    return length;
+}
+
+// Function FormatSigned: Writes a signed number in decimal, zero-padded to min_digits after the sign, returns its length
+uint8_t FormatSigned(char *p_str, int32_t number, uint8_t min_digits) {
+    if (number < 0) {
+        *p_str = '-';
+        return FormatUnsigned(p_str + 1, -(uint32_t)number, min_digits) + 1;
+    }
+    return FormatUnsigned(p_str, (uint32_t)number, min_digits);
+}
+
+// Function FormatTenths: Writes a fixed-point number in tenths (e.g. 453 -> "45.3", -5 -> "-0.5"), returns its length
+uint8_t FormatTenths(char *p_str, int16_t tenths, char separator) {
+    uint8_t length = FormatSigned(p_str, tenths, 2);  // At least one integer digit and the decimal
+    p_str[length] = p_str[length - 1];
+    p_str[length - 1] = separator;
+    p_str[++length] = 0;
+    return length;
+}
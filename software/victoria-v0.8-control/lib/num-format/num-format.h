@@ -0,0 +1,26 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: num-format.h (printf-free number formatting headers)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef NUM_FORMAT_H
+#define NUM_FORMAT_H
+
+#include <avr/io.h>
+
+#define NUM_STR_LENGTH 12  // Longest formatted number: sign + 10 digits + NUL (also fits sign + 5 digits + separator + NUL)
+
+// Prototypes
+
+uint32_t DivMod10(uint32_t number, uint8_t *p_remainder);
+uint8_t FormatUnsigned(char *p_str, uint32_t number, uint8_t min_digits);
+uint8_t FormatSigned(char *p_str, int32_t number, uint8_t min_digits);
+uint8_t FormatTenths(char *p_str, int16_t tenths, char separator);
+
+#endif  // NUM_FORMAT_H
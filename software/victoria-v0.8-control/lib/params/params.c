@@ -0,0 +1,234 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: params.c (runtime parameters store) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "params.h"
+
+// Only on the ATmega328: the host test builds pad SysParams, which can't be packed (the FSM table points into it)
+#ifdef __AVR__
+_Static_assert(sizeof(ParamsRecord) == PARAMS_RECORD_SIZE, "PARAMS_RECORD_SIZE doesn't match the ParamsRecord layout");
+#endif  // __AVR__
+
+// The safety fast path confirmation must end before the debounced input changes
+#if SAFETY_FAST_PATH
+#define DEB_FLAME_MIN SAFETY_FLAME_LOSS_TIME
+#define DEB_OVERHEAT_MIN SAFETY_OVERHEAT_TIME
+#else
+#define DEB_FLAME_MIN DEBOUNCE_SAMPLES
+#define DEB_OVERHEAT_MIN DEBOUNCE_SAMPLES
+#endif  // SAFETY_FAST_PATH
+#define DEB_MAX (255 * DEBOUNCE_SAMPLES)
+
+SysParams sys_params;  // Runtime tuning parameters
+
+static ParamsRecord params_record;         // Copy being written to EEPROM, the parameters may change meanwhile
+static volatile bool params_saved = true;  // The record has been written
+
+// Defaults: the compile-time settings
+static const SysParams __flash default_params = {
+    .pump_timer_duration = PUMP_TIMER_DURATION,
+    .dhw_heat_cycle_time = DHW_HEAT_CYCLE_TIME,
+    .ch_heat_cycle_time = CH_HEAT_CYCLE_TIME,
+    .ch_setpoint_high = CH_SETPOINT_HIGH,
+    .ch_setpoint_low = CH_SETPOINT_LOW,
+    .dly_off_2 = DLY_OFF_2,
+    .dly_off_3 = DLY_OFF_3,
+    .dly_off_4 = DLY_OFF_4,
+    .dly_ready_1 = DLY_READY_1,
+    .dly_igniting_1 = DLY_IGNITING_1,
+    .dly_igniting_2 = DLY_IGNITING_2,
+    .dly_igniting_3 = DLY_IGNITING_3,
+    .dly_igniting_4 = DLY_IGNITING_4,
+    .dly_igniting_5 = DLY_IGNITING_5,
+    .dly_igniting_6 = DLY_IGNITING_6,
+    .debounce_time = {DEB_DHW_REQUEST_TIME, DEB_CH_REQUEST_TIME, DEB_AIRFLOW_TIME, DEB_FLAME_TIME, DEB_OVERHEAT_TIME},
+    .max_ignition_tries = MAX_IGNITION_TRIES};
+
+// Parameter names
+static const char __flash str_param_pump[] = {"pump-time"};
+static const char __flash str_param_dhw_cycle[] = {"dhw-cycle"};
+static const char __flash str_param_ch_cycle[] = {"ch-cycle"};
+static const char __flash str_param_ch_high[] = {"ch-high"};
+static const char __flash str_param_ch_low[] = {"ch-low"};
+static const char __flash str_param_off_2[] = {"off-2"};
+static const char __flash str_param_off_3[] = {"off-3"};
+static const char __flash str_param_off_4[] = {"off-4"};
+static const char __flash str_param_ready_1[] = {"ready-1"};
+static const char __flash str_param_igniting_1[] = {"igniting-1"};
+static const char __flash str_param_igniting_2[] = {"igniting-2"};
+static const char __flash str_param_igniting_3[] = {"igniting-3"};
+static const char __flash str_param_igniting_4[] = {"igniting-4"};
+static const char __flash str_param_igniting_5[] = {"igniting-5"};
+static const char __flash str_param_igniting_6[] = {"igniting-6"};
+static const char __flash str_param_deb_dhw[] = {"deb-dhw"};
+static const char __flash str_param_deb_ch[] = {"deb-ch"};
+static const char __flash str_param_deb_airflow[] = {"deb-airflow"};
+static const char __flash str_param_deb_flame[] = {"deb-flame"};
+static const char __flash str_param_deb_overheat[] = {"deb-overheat"};
+static const char __flash str_param_tries[] = {"ignition-tries"};
+
+#define PARAM(name, field, min, max) {name, offsetof(SysParams, field), sizeof(((SysParams *)0)->field), min, max}
+
+// Parameter descriptors, indexed by ParamId
+static const ParamInfo __flash param_info[PARAMS_COUNT] = {
+    //    name                    field                         min               max
+    PARAM(str_param_pump,         pump_timer_duration,          60000,            3600000),
+    PARAM(str_param_dhw_cycle,    dhw_heat_cycle_time,          5000,             60000),
+    PARAM(str_param_ch_cycle,     ch_heat_cycle_time,           5000,             60000),
+    PARAM(str_param_ch_high,      ch_setpoint_high,             100,              900),
+    PARAM(str_param_ch_low,       ch_setpoint_low,              100,              900),
+    PARAM(str_param_off_2,        dly_off_2,                    1,                60000),
+    PARAM(str_param_off_3,        dly_off_3,                    1,                60000),
+    PARAM(str_param_off_4,        dly_off_4,                    1,                60000),
+    PARAM(str_param_ready_1,      dly_ready_1,                  1,                60000),
+    PARAM(str_param_igniting_1,   dly_igniting_1,               1,                60000),
+    PARAM(str_param_igniting_2,   dly_igniting_2,               1,                60000),
+    PARAM(str_param_igniting_3,   dly_igniting_3,               1,                60000),
+    PARAM(str_param_igniting_4,   dly_igniting_4,               1,                60000),
+    PARAM(str_param_igniting_5,   dly_igniting_5,               1,                60000),
+    PARAM(str_param_igniting_6,   dly_igniting_6,               1,                60000),
+    PARAM(str_param_deb_dhw,      debounce_time[DHW_REQUEST_F], DEBOUNCE_SAMPLES, DEB_MAX),
+    PARAM(str_param_deb_ch,       debounce_time[CH_REQUEST_F],  DEBOUNCE_SAMPLES, DEB_MAX),
+    PARAM(str_param_deb_airflow,  debounce_time[AIRFLOW_F],     DEBOUNCE_SAMPLES, DEB_MAX),
+    PARAM(str_param_deb_flame,    debounce_time[FLAME_F],       DEB_FLAME_MIN,    DEB_MAX),
+    PARAM(str_param_deb_overheat, debounce_time[OVERHEAT_F],    DEB_OVERHEAT_MIN, DEB_MAX),
+    PARAM(str_param_tries,        max_ignition_tries,           1,                10),
+};
+
+// Function ParamsCrc: Returns the CRC-8 of a parameters record, excluding its crc field
+static uint8_t ParamsCrc(const ParamsRecord *p_record) {
+    const uint8_t *p_byte = (const uint8_t *)p_record;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < offsetof(ParamsRecord, crc); i++) {
+        crc = _crc8_ccitt_update(crc, p_byte[i]);
+    }
+    return crc;
+}
+
+// Function ReadField: Returns a parameter value from a parameters block
+static uint32_t ReadField(const SysParams *p_params, ParamId param) {
+    const uint8_t *p_field = (const uint8_t *)p_params + param_info[param].offset;
+    uint32_t value = 0;
+    for (uint8_t i = param_info[param].size; i > 0; i--) {
+        value = (value << 8) | p_field[i - 1];  // Little-endian
+    }
+    return value;
+}
+
+// Function WriteField: Stores a parameter value into a parameters block
+static void WriteField(SysParams *p_params, ParamId param, uint32_t value) {
+    uint8_t *p_field = (uint8_t *)p_params + param_info[param].offset;
+    for (uint8_t i = 0; i < param_info[param].size; i++) {
+        p_field[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+// Function ParamInRange: Tells if a value is accepted by a parameter
+static bool ParamInRange(ParamId param, uint32_t value) {
+    return ((value >= param_info[param].min) && (value <= param_info[param].max));
+}
+
+// Function ParamsConsistent: Checks the rules that tie parameters together
+static bool ParamsConsistent(const SysParams *p_params) {
+    // The CH high setpoint is the hotter one (lower NTC readout), and the flame must settle before an ignition retry
+    return ((p_params->ch_setpoint_high < p_params->ch_setpoint_low) &&
+            (p_params->dly_igniting_6 > p_params->debounce_time[FLAME_F]));
+}
+
+// Function InitParams: Loads the parameters from EEPROM, falling back to the defaults if they are missing, corrupted or out of range
+void InitParams(void) {
+    ReadEeprom(&params_record, PARAMS_ADDRESS, sizeof(ParamsRecord));
+    if ((params_record.version != PARAMS_VERSION) || (params_record.length != sizeof(SysParams)) ||
+        (params_record.crc != ParamsCrc(&params_record))) {
+        ResetParams();
+        return;
+    }
+    SysParams defaults = default_params;
+    sys_params = params_record.params;
+    for (uint8_t param = 0; param < PARAMS_COUNT; param++) {
+        if (ParamInRange(param, ReadField(&sys_params, param)) == false) {
+            WriteField(&sys_params, param, ReadField(&defaults, param));
+        }
+    }
+    if (ParamsConsistent(&sys_params) == false) {
+        ResetParams();
+    }
+}
+
+// Function SetParam: Changes a parameter in RAM, returns false if the value is rejected. SaveParams makes it permanent
+bool SetParam(ParamId param, uint32_t value) {
+    if ((param >= PARAMS_COUNT) || (ParamInRange(param, value) == false)) {
+        return false;
+    }
+    SysParams new_params = sys_params;
+    WriteField(&new_params, param, value);
+    if (ParamsConsistent(&new_params) == false) {
+        return false;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        WriteField(&sys_params, param, value);  // The debounce engine reads its times from interrupt context
+    }
+    return true;
+}
+
+// Function GetParam: Returns a parameter value
+uint32_t GetParam(ParamId param) {
+    if (param >= PARAMS_COUNT) {
+        return 0;
+    }
+    return ReadField(&sys_params, param);
+}
+
+// Function FindParam: Returns the id of a parameter given its name, PARAMS_COUNT if there is none
+ParamId FindParam(const char *name) {
+    for (uint8_t param = 0; param < PARAMS_COUNT; param++) {
+        const __flash char *p_name = param_info[param].name;
+        uint8_t i = 0;
+        while ((p_name[i] != '\0') && (p_name[i] == name[i])) {
+            i++;
+        }
+        if ((p_name[i] == '\0') && (name[i] == '\0')) {
+            return param;
+        }
+    }
+    return PARAMS_COUNT;
+}
+
+// Function SaveParams: Queues the current parameters to be written to EEPROM in the background
+bool SaveParams(void) {
+    if (params_saved == false) {
+        return false;  // The previous record is still being written
+    }
+    params_record.version = PARAMS_VERSION;
+    params_record.length = sizeof(SysParams);
+    params_record.params = sys_params;
+    params_record.crc = ParamsCrc(&params_record);
+    return QueueEepromWrite(PARAMS_ADDRESS, &params_record, sizeof(ParamsRecord), &params_saved);
+}
+
+// Function ResetParams: Restores the default parameters in RAM, SaveParams makes it permanent
+void ResetParams(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        sys_params = default_params;
+    }
+}
+
+// Function SendParams: Sends the parameter names and values over serial
+void SendParams(void) {
+    SerialTxStr(str_params_header);
+    SerialTxStr(str_crlf);
+    for (uint8_t param = 0; param < PARAMS_COUNT; param++) {
+        SerialTxStr(param_info[param].name);
+        SerialTxChr(' ');
+        SerialTxNum(ReadField(&sys_params, param), DIGITS_FREE);
+        SerialTxStr(str_crlf);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: params.h (runtime parameters store headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <burner-stats.h>
+#include <eeprom-queue.h>
+#include <hal.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+
+#include "../../include/sys-settings.h"
+
+#define PARAMS_VERSION 1                                     // Parameters record layout version, bump it when SysParams changes
+#define PARAMS_RECORD_SIZE (3 + 4 + (14 * 2) + (5 * 2) + 1)  // EEPROM bytes taken by ParamsRecord
+
+#if ((PARAMS_ADDRESS < (STATS_ADDRESS + STATS_RECORD_SIZE)) || ((PARAMS_ADDRESS + PARAMS_RECORD_SIZE) > 1024))
+#error "The runtime parameters overlap the burner statistics or don't fit in the ATmega328 EEPROM"
+#endif
+
+// Types
+
+typedef enum param_id {
+    PARAM_PUMP_TIMER = 0,
+    PARAM_DHW_CYCLE = 1,
+    PARAM_CH_CYCLE = 2,
+    PARAM_CH_HIGH = 3,
+    PARAM_CH_LOW = 4,
+    PARAM_OFF_2 = 5,
+    PARAM_OFF_3 = 6,
+    PARAM_OFF_4 = 7,
+    PARAM_READY_1 = 8,
+    PARAM_IGNITING_1 = 9,
+    PARAM_IGNITING_2 = 10,
+    PARAM_IGNITING_3 = 11,
+    PARAM_IGNITING_4 = 12,
+    PARAM_IGNITING_5 = 13,
+    PARAM_IGNITING_6 = 14,
+    PARAM_DEB_DHW = 15,
+    PARAM_DEB_CH = 16,
+    PARAM_DEB_AIRFLOW = 17,
+    PARAM_DEB_FLAME = 18,
+    PARAM_DEB_OVERHEAT = 19,
+    PARAM_IGNITION_TRIES = 20,
+    PARAMS_COUNT = 21
+} ParamId;
+
+typedef struct param_info {
+    const __flash char *name;  // Name shown on the serial console
+    uint8_t offset;            // Field offset in SysParams
+    uint8_t size;              // Field size (1, 2 or 4 bytes)
+    uint32_t min;              // Lowest accepted value
+    uint32_t max;              // Highest accepted value
+} ParamInfo;
+
+typedef struct params_record {
+    uint8_t version;   // PARAMS_VERSION when the record was written
+    uint8_t length;    // sizeof(SysParams) when the record was written
+    SysParams params;  // Parameter values
+    uint8_t crc;       // CRC-8/CCITT of the bytes above
+} ParamsRecord;
+
+// Prototypes
+
+void InitParams(void);
+bool SetParam(ParamId param, uint32_t value);
+uint32_t GetParam(ParamId param);
+ParamId FindParam(const char *name);
+bool SaveParams(void);
+void ResetParams(void);
+void SendParams(void);
+
+// Runtime parameters literals
+
+static const char __flash str_params_header[] = {"Parameters:"};
+
+#endif  // PARAMS_H
@@ -0,0 +1,172 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: profiler.c (task loop profiler library) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "profiler.h"
+
+#if LOOP_PROFILER
+static ProfileSection profile[PROFILER_SECTIONS];  // Run times of the task loop pass and each task
+static uint16_t pass_histogram[PROFILER_BUCKETS];  // Task loop passes per time bucket, each one stops at UINT16_MAX
+static volatile uint16_t timer1_overflows = 0;     // High word of the CPU cycle counter
+static uint8_t profiler_overhead = 0;              // CPU cycles taken by GetCycles itself, subtracted from each run
+
+// Function StartProfiler: Sets Timer1 up as a free-running CPU cycle counter and clears the measurements
+void StartProfiler(void) {
+    for (uint8_t section = 0; section < PROFILER_SECTIONS; section++) {
+        profile[section].min_cycles = UINT32_MAX;
+        profile[section].max_cycles = 0;
+        profile[section].avg_acc = 0;
+        profile[section].runs = 0;
+    }
+    for (uint8_t bucket = 0; bucket < PROFILER_BUCKETS; bucket++) {
+        pass_histogram[bucket] = 0;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        TCCR1A = 0;              // Normal mode, output compare pins disconnected
+        TCCR1B = (1 << CS10);    // No prescaler: one count per CPU cycle
+        TCNT1 = 0;
+        timer1_overflows = 0;
+        TIFR1 = (1 << TOV1);     // Clear any pending overflow flag
+        TIMSK1 |= (1 << TOIE1);  // Enable timer 1 overflow interrupt
+    }
+    uint32_t start = GetCycles();
+    profiler_overhead = (uint8_t)(GetCycles() - start);
+}
+
+// Function GetCycles: Returns the CPU cycles elapsed since StartProfiler (wraps every 268 seconds at 16 MHz)
+uint32_t GetCycles(void) {
+    uint16_t high;
+    uint16_t low;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        low = TCNT1;
+        high = timer1_overflows;
+        // An overflow not yet serviced belongs to a low word that already wrapped
+        if ((TIFR1 & (1 << TOV1)) && (low < 0x8000)) {
+            high++;
+        }
+    }
+    return ((uint32_t)high << 16) | low;
+}
+
+// Function ProfileRun: Records a run of a profiler section that started at start_cycles
+void ProfileRun(uint8_t section, uint32_t start_cycles) {
+    uint32_t cycles = GetCycles() - start_cycles;
+    cycles = (cycles > profiler_overhead) ? (cycles - profiler_overhead) : 0;
+    if (section >= PROFILER_SECTIONS) {
+        return;
+    }
+    ProfileSection *p_section = &profile[section];
+    if (cycles < p_section->min_cycles) {
+        p_section->min_cycles = cycles;
+    }
+    if (cycles > p_section->max_cycles) {
+        p_section->max_cycles = cycles;
+    }
+    if (p_section->runs == 0) {
+        p_section->avg_acc = cycles << PROFILER_AVG_SHIFT;  // The first run seeds the average
+    } else {
+        p_section->avg_acc += cycles - (p_section->avg_acc >> PROFILER_AVG_SHIFT);
+    }
+    if (p_section->runs < UINT16_MAX) {
+        p_section->runs++;
+    }
+    if (section == PROFILE_PASS) {
+        uint32_t us = CyclesToMicroseconds(cycles);
+        uint8_t bucket = 0;
+        while ((bucket < (PROFILER_BUCKETS - 1)) && (us >= ((uint32_t)PROFILER_BUCKET_US << bucket))) {
+            bucket++;
+        }
+        if (pass_histogram[bucket] < UINT16_MAX) {
+            pass_histogram[bucket]++;
+        }
+    }
+}
+
+// Function GetProfileTime: Returns the shortest, average or longest run of a profiler section (microseconds, up to UINT16_MAX)
+uint16_t GetProfileTime(uint8_t section, ProfileValue value) {
+    if ((section >= PROFILER_SECTIONS) || (profile[section].runs == 0)) {
+        return 0;
+    }
+    uint32_t cycles;
+    switch (value) {
+        case PROFILE_MIN: {
+            cycles = profile[section].min_cycles;
+            break;
+        }
+        case PROFILE_AVG: {
+            cycles = profile[section].avg_acc >> PROFILER_AVG_SHIFT;
+            break;
+        }
+        default: {
+            cycles = profile[section].max_cycles;
+            break;
+        }
+    }
+    uint32_t us = CyclesToMicroseconds(cycles);
+    return (us > UINT16_MAX) ? UINT16_MAX : (uint16_t)us;
+}
+
+// Function GetProfileBucket: Returns the task loop passes counted in a histogram bucket
+uint16_t GetProfileBucket(uint8_t bucket) {
+    return (bucket < PROFILER_BUCKETS) ? pass_histogram[bucket] : 0;
+}
+
+// Function SendProfileBuckets: Sends the histogram buckets in a range
+static void SendProfileBuckets(uint8_t first, uint8_t last) {
+    for (uint8_t bucket = first; bucket < last; bucket++) {
+        SerialTxChr(' ');
+        SerialTxChr((bucket < (PROFILER_BUCKETS - 1)) ? '<' : '>');
+        SerialTxNum((uint32_t)PROFILER_BUCKET_US << ((bucket < (PROFILER_BUCKETS - 1)) ? bucket : (bucket - 1)), DIGITS_FREE);
+        SerialTxChr(':');
+        SerialTxNum(pass_histogram[bucket], DIGITS_5);  // Fixed width, the dashboard rewrites the page in place
+    }
+}
+
+// Function SendProfileLine: Sends a piece of the task loop profile page, short enough for the serial transmission queue
+void SendProfileLine(uint8_t line) {
+    if (line == 0) {
+        SerialTxStr(str_prof_header);
+        SerialTxStr(str_crlf);
+    } else if (line <= PROFILER_SECTIONS) {
+        uint8_t section = line - 1;
+        if (section == PROFILE_PASS) {
+            SerialTxStr(str_prof_pass);
+        } else {
+            SerialTxStr(str_prof_task);
+            SerialTxNum(section, DIGITS_1);
+        }
+        for (ProfileValue value = PROFILE_MIN; value <= PROFILE_MAX; value++) {
+            SerialTxChr(' ');
+            SerialTxNum(GetProfileTime(section, value), DIGITS_5);
+        }
+        SerialTxChr(' ');
+        SerialTxNum(profile[section].runs, DIGITS_5);
+        SerialTxStr(str_crlf);
+    } else if (line == (PROFILER_SECTIONS + 1)) {
+        SerialTxStr(str_prof_histogram);
+        SendProfileBuckets(0, PROFILER_BUCKETS / 2);
+    } else if (line == (PROFILER_SECTIONS + 2)) {
+        SendProfileBuckets(PROFILER_BUCKETS / 2, PROFILER_BUCKETS);
+        SerialTxStr(str_crlf);
+    }
+}
+
+// Function SendProfile: Sends the task loop profile page over serial
+void SendProfile(void) {
+    for (uint8_t line = 0; line < PROFILE_LINES; line++) {
+        SendProfileLine(line);
+    }
+}
+
+// Timer1 overflow interrupt service routine: High word of the CPU cycle counter
+ISR(TIMER1_OVF_vect) {
+    timer1_overflows++;
+}
+#endif  // LOOP_PROFILER
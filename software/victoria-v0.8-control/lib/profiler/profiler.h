@@ -0,0 +1,67 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: profiler.h (task loop profiler headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+#include <timers.h>
+#include <util/atomic.h>
+
+#include "../../include/sys-settings.h"
+
+#define PROFILE_PASS 0                        // Profiler section of a whole task loop pass, task sections use their task id
+#define PROFILER_SECTIONS (SYSTEM_TASKS + 1)  // Task loop pass plus one section per task
+#define PROFILER_AVG_SHIFT 4                  // Running average weight of each new run: 1 / 2^PROFILER_AVG_SHIFT
+#define PROFILER_BUCKETS 8                    // Task loop pass time histogram buckets, the last one takes all longer passes
+#define PROFILER_BUCKET_US 128                // Upper limit of the first bucket (microseconds), doubled on each next one
+#define PROFILE_LINES (PROFILER_SECTIONS + 3)  // Profile page pieces: header, one per section and the histogram in two halves
+
+#define CyclesToMicroseconds(c) ((c) / clockCyclesPerMicrosecond())
+
+// Types
+
+typedef struct profile_section {
+    uint32_t min_cycles;  // Shortest run (CPU cycles)
+    uint32_t max_cycles;  // Longest run (CPU cycles)
+    uint32_t avg_acc;     // Running average run time, scaled by 2^PROFILER_AVG_SHIFT (CPU cycles)
+    uint16_t runs;        // Runs measured, stops at UINT16_MAX
+} ProfileSection;
+
+typedef enum profile_value {
+    PROFILE_MIN = 0,
+    PROFILE_AVG = 1,
+    PROFILE_MAX = 2
+} ProfileValue;
+
+// Prototypes
+
+#if LOOP_PROFILER
+void StartProfiler(void);
+uint32_t GetCycles(void);
+void ProfileRun(uint8_t section, uint32_t start_cycles);
+uint16_t GetProfileTime(uint8_t section, ProfileValue value);
+uint16_t GetProfileBucket(uint8_t bucket);
+void SendProfileLine(uint8_t line);
+void SendProfile(void);
+#endif  // LOOP_PROFILER
+
+// Profiler literals
+
+static const char __flash str_prof_header[] = {"Loop profile (us): min avg max runs"};
+static const char __flash str_prof_pass[] = {"Pass  "};
+static const char __flash str_prof_task[] = {"Task "};
+static const char __flash str_prof_histogram[] = {"Pass time histogram (us):"};
+
+#endif  // PROFILER_H
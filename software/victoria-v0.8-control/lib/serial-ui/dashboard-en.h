@@ -34,7 +34,7 @@
 #define CHR_RNDB_O 40            // (
 #define CHR_RNDB_C 41            // )
 
-#if SHOW_DASHBOARD
+#if DASHBOARD_FRAMES
 #define IGNITION_TRIES_CHR 84  // T
 static const char __flash str_header_02[] = {FW_ALIAS};
 static const char __flash str_space_xs[] = {" "};
@@ -87,8 +87,9 @@ static const char __flash str_wptimer[] = {"  CH water pump shutdown timer: "};
 static const char __flash str_wpmemory[] = {"<- Remaining time in memory: "};
 static const char __flash str_temperr[] = {"XX.X"};
 #endif  // SHOW_PUMP_TIMER
+#endif  // DASHBOARD_FRAMES
 
-#else
+#if !(SHOW_DASHBOARD)
 static const char __flash str_no_dashboard[] = {"- System dashboard disabled in settings ..."};
 #endif  // SHOW_DASHBOARD
 
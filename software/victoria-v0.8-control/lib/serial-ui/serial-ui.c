@@ -11,74 +11,154 @@
 
 #include "serial-ui.h"
 
+// Serial transmission queue, drained by the USART data register empty interrupt
+static volatile uint8_t tx_buffer[TX_BUFFER_LENGTH];
+static volatile uint8_t tx_head = 0;        // Next write position
+static volatile uint8_t tx_tail = 0;        // Next character to transmit
+static volatile uint16_t tx_overflows = 0;  // Characters that found the queue full
+
+// Serial reception queue, filled by the USART receive complete interrupt
+static volatile uint8_t rx_buffer[RX_BUFFER_LENGTH];
+static volatile uint8_t rx_head = 0;        // Next write position
+static volatile uint8_t rx_tail = 0;        // Next character to take
+static volatile uint16_t rx_overflows = 0;  // Characters dropped because the queue was full
+
+#if DASHBOARD_FRAMES
+// Next row of the whole dashboard redraw in progress
+static DashboardRow dashboard_row = DASHBOARD_ROWS;
+#if LOOP_PROFILER
+static uint8_t dashboard_profile_line = PROFILE_LINES;  // Next line of the profile page being sent
+static uint32_t dashboard_profile_time = 0;             // Time when the profile page was last sent (milliseconds)
+#endif  // LOOP_PROFILER
+#endif  // DASHBOARD_FRAMES
+
+#if (SHOW_DASHBOARD && DASHBOARD_DIFF)
+// Terminal cursor position, tracked to locate the dashboard fields
+static uint8_t cursor_row = 1;
+static uint8_t cursor_column = 1;
+// Dashboard fields and the layout state they were drawn with
+static DashboardSlot dashboard_fields[DASHBOARD_FIELDS];
+static uint8_t dashboard_end_row = 1;
+static uint16_t dashboard_state_key = 0;
+static uint32_t dashboard_pump_memory = 0;
+static bool dashboard_drawn = false;
+#if LOOP_PROFILER
+static uint8_t dashboard_profile_row = 1;  // Terminal row of the profile page header
+#endif  // LOOP_PROFILER
+#endif  // SHOW_DASHBOARD && DASHBOARD_DIFF
+
 // Function SerialInit
 void SerialInit(void) {
     UBRR0H = (uint8_t)(BAUD_PRESCALER >> 8);
     UBRR0L = (uint8_t)(BAUD_PRESCALER);
+#if SERIAL_SHELL
+    UCSR0B = (1 << RXCIE0) | (1 << RXEN0) | (1 << TXEN0);
+#else
     UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+#endif  // SERIAL_SHELL
     UCSR0C = (3 << UCSZ00);
 }
 
-// Function SerialRxChr
-uint8_t SerialRxChr(void) {
-    while (!(UCSR0A & (1 << RXC0))) {
-    };
-    return UDR0;
+// Function SerialRxChr: Takes the oldest character from the reception queue, returns false when it is empty
+bool SerialRxChr(uint8_t *p_character) {
+    if (rx_head == rx_tail) {
+        return false;
+    }
+    *p_character = rx_buffer[rx_tail];
+    rx_tail = (rx_tail + 1) & (RX_BUFFER_LENGTH - 1);
+    return true;
 }
 
-// Function SerialTxChr
-void SerialTxChr(uint8_t character_code) {
-    while (!(UCSR0A & (1 << UDRE0))) {
-    };
-    UDR0 = character_code;
+// Function GetSerialRxOverflows: Returns how many received characters were dropped because the reception queue was full
+uint16_t GetSerialRxOverflows(void) {
+    uint16_t overflows;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        overflows = rx_overflows;
+    }
+    return overflows;
 }
 
-// Function SerialTxNum
-void SerialTxNum(uint32_t number, DigitLength digits) {
-#define DATA_LNG 7
-    char str[DATA_LNG] = {0};
-    switch (digits) {
-        case DIGITS_1: {
-            sprintf(str, "%01u", (uint16_t)number);
-            break;
-        }
-        case DIGITS_2: {
-            sprintf(str, "%02u", (uint16_t)number);
-            break;
-        }
-        case DIGITS_3: {
-            sprintf(str, "%03u", (uint16_t)number);
-            break;
-        }
-        case DIGITS_4: {
-            sprintf(str, "%04u", (uint16_t)number);
-            break;
+#if SERIAL_SHELL
+// USART receive complete interrupt service routine
+ISR(USART_RX_vect) {
+    uint8_t character = UDR0;  // Reading the data register clears the interrupt
+    uint8_t next_head = (rx_head + 1) & (RX_BUFFER_LENGTH - 1);
+    if (next_head == rx_tail) {
+        // Queue full
+        if (rx_overflows < UINT16_MAX) {
+            rx_overflows++;
         }
-        case DIGITS_5: {
-            sprintf(str, "%05u", (uint16_t)number);
-            break;
-        }
-        case DIGITS_6: {
-            sprintf(str, "%06u", (uint16_t)number);
-            break;
-        }
-        case DIGITS_7:
-        case DIGITS_8:
-        case DIGITS_9:
-        case DIGITS_10: {
-            sprintf(str, "%0lu", (uint32_t)number);
-            break;
+        return;
+    }
+    rx_buffer[rx_head] = character;
+    rx_head = next_head;
+}
+#endif  // SERIAL_SHELL
+
+// Function SerialTxChr: Queues a character for transmission
+void SerialTxChr(uint8_t character_code) {
+#if (SHOW_DASHBOARD && DASHBOARD_DIFF)
+    if (character_code == '\n') {
+        cursor_row++;
+    } else if (character_code == '\r') {
+        cursor_column = 1;
+    } else if ((character_code >= SPACE) && (character_code < 127)) {
+        cursor_column++;
+    }
+#endif  // SHOW_DASHBOARD && DASHBOARD_DIFF
+    uint8_t next_head = (tx_head + 1) & (TX_BUFFER_LENGTH - 1);
+    if (next_head == tx_tail) {
+        // Queue full
+        if (tx_overflows < UINT16_MAX) {
+            tx_overflows++;
         }
-        case DIGITS_FREE:
-        default: {
-            sprintf(str, "%u", (uint16_t)number);
-            break;
+#if TX_DROP_ON_FULL
+        return;
+#else
+        while (next_head == tx_tail) {
+            // With interrupts disabled the queue doesn't drain by itself, so send its oldest character here
+            if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0))) {
+                UDR0 = tx_buffer[tx_tail];
+                tx_tail = (tx_tail + 1) & (TX_BUFFER_LENGTH - 1);
+            }
         }
+#endif  // TX_DROP_ON_FULL
+    }
+    tx_buffer[tx_head] = character_code;
+    tx_head = next_head;
+    UCSR0B |= (1 << UDRIE0);  // Start (or keep) draining the queue
+}
+
+// Function GetSerialTxOverflows: Returns how many characters found the transmission queue full
+uint16_t GetSerialTxOverflows(void) {
+    uint16_t overflows;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        overflows = tx_overflows;
     }
-    for (int i = 0; i < DATA_LNG; i++) {
-        while (!(UCSR0A & (1 << UDRE0))) {
-        };
-        UDR0 = str[i];
+    return overflows;
+}
+
+// Function GetSerialTxFree: Returns how many characters fit in the transmission queue without waiting
+uint8_t GetSerialTxFree(void) {
+    return (tx_tail - tx_head - 1) & (TX_BUFFER_LENGTH - 1);
+}
+
+// USART data register empty interrupt service routine
+ISR(USART_UDRE_vect) {
+    if (tx_head != tx_tail) {
+        UDR0 = tx_buffer[tx_tail];
+        tx_tail = (tx_tail + 1) & (TX_BUFFER_LENGTH - 1);
+    } else {
+        UCSR0B &= ~(1 << UDRIE0);  // Queue empty
+    }
+}
+
+// Function SerialTxNum: Sends a number zero-padded to the given digits (DIGITS_7 and up, or DIGITS_FREE, are not padded)
+void SerialTxNum(uint32_t number, DigitLength digits) {
+    char str[NUM_STR_LENGTH];
+    uint8_t length = FormatUnsigned(str, number, (digits <= DIGITS_6) ? digits : 0);
+    for (uint8_t i = 0; i < length; i++) {
+        SerialTxChr(str[i]);
     }
 }
 
@@ -90,26 +170,13 @@ void SerialTxStr(const __flash char *ptr_string) {
     }
 }
 
-// Function SerialTxTemp
+// Function SerialTxTemp: Sends a temperature in tenths of a degree with one decimal
 void SerialTxTemp(int ntc_temperature) {
-#define STR_NUM 5
-    char str_num[STR_NUM] = {0};
-    sprintf(str_num, "%02d", ((int)ntc_temperature));
-    char str_len = strlen(str_num);
-    // Integer part
-    for (int i = 0; i < str_len - 1; i++) {
-        while (!(UCSR0A & (1 << UDRE0))) {
-        };
-        UDR0 = str_num[i];
+    char str_num[NUM_STR_LENGTH];
+    uint8_t length = FormatTenths(str_num, ntc_temperature, DECIMAL_SEPARATOR);
+    for (uint8_t i = 0; i < length; i++) {
+        SerialTxChr(str_num[i]);
     }
-    // Decimal separator
-    while (!(UCSR0A & (1 << UDRE0))) {
-    };
-    UDR0 = DECIMAL_SEPARATOR;
-    // Decimal part
-    while (!(UCSR0A & (1 << UDRE0))) {
-    };
-    UDR0 = str_num[strlen(str_num) - 1];
 }
 
 // Function DrawDashedLine
@@ -135,375 +202,642 @@ void ClrScr(void) {
     for (uint8_t i = 0; i < (sizeof(clr_ascii) / sizeof(clr_ascii[0])); i++) {
         SerialTxChr(clr_ascii[i]);
     }
+#if (SHOW_DASHBOARD && DASHBOARD_DIFF)
+    cursor_row = 1;
+    cursor_column = 1;
+#endif  // SHOW_DASHBOARD && DASHBOARD_DIFF
 }
 
-#if SHOW_DASHBOARD
-
-// Function Dashboard
-void Dashboard(SysInfo *p_system, bool force_refresh) {
-    if (force_refresh |
-        (p_system->input_flags != p_system->last_displayed_iflags) |
-        (p_system->output_flags != p_system->last_displayed_oflags)) {
-        p_system->last_displayed_iflags = p_system->input_flags;
-        p_system->last_displayed_oflags = p_system->output_flags;
-
-        ClrScr();
-
-        DrawLine(DASH_WIDTH, H_ELINE);  // Dashed line
+#if DASHBOARD_FRAMES
+
+#if DASHBOARD_DIFF
+// Function MoveCursor: Moves the terminal cursor to a row and column (ANSI CUP sequence)
+static void MoveCursor(uint8_t row, uint8_t column) {
+    SerialTxChr(27);  // ESC
+    SerialTxChr(CHR_SQRB_O);
+    SerialTxNum(row, DIGITS_FREE);
+    SerialTxChr(';');
+    SerialTxNum(column, DIGITS_FREE);
+    SerialTxChr('H');
+    cursor_row = row;
+    cursor_column = column;
+}
 
-        SerialTxStr(str_crlf);  // CR + new line
+// Function GetStateKey: Returns a value that changes when the dashboard mode line changes
+static uint16_t GetStateKey(SysInfo *p_system) {
+    uint16_t state_key = p_system->system_state;
+    if (p_system->system_state == CH_ON_DUTY) {
+        state_key |= (p_system->inner_step << 8);
+    }
+    return state_key;
+}
+#endif  // DASHBOARD_DIFF
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_header_01);
-        SerialTxStr(str_header_02);
+// Function SerialTxBool: Sends the dashboard true or false literal
+static void SerialTxBool(bool value) {
+    if (value) {
+        SerialTxStr(str_true);
+    } else {
+        SerialTxStr(str_false);
+    }
+}
 
-        SerialTxStr(str_space_s);
+// Function GetFieldValue: Returns the value displayed by a dashboard field
+static uint16_t GetFieldValue(SysInfo *p_system, DashboardField field) {
+    switch (field) {
+        case DSH_IFLAGS:
+            return p_system->input_flags;
+        case DSH_DHW_TEMP:
+            return (uint16_t)GetNtcTemperature(p_system->dhw_temperature, TO_CELSIUS, DT_CELSIUS);
+        case DSH_CH_TEMP:
+            return (uint16_t)GetNtcTemperature(p_system->ch_temperature, TO_CELSIUS, DT_CELSIUS);
+        case DSH_CH_ADC:
+            return p_system->ch_temperature;
+        case DSH_OVERHEAT:
+            return GetFlag(p_system, INPUT_FLAGS, OVERHEAT_F);
+        case DSH_DHW_REQUEST:
+            return GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F);
+        case DSH_CH_REQUEST:
+            return GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F);
+        case DSH_AIRFLOW:
+            return GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F);
+        case DSH_FLAME:
+            return GetFlag(p_system, INPUT_FLAGS, FLAME_F);
+        case DSH_DHW_SETTING:
+            return GetKnobPosition(p_system->dhw_setting, DHW_SETTING_STEPS);
+        case DSH_CH_SETTING:
+            return GetKnobPosition(p_system->ch_setting, CH_SETTING_STEPS);
+        case DSH_SYSTEM_MODE:
+            return GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS);
+        case DSH_OFLAGS:
+            return p_system->output_flags;
+        case DSH_EXHAUST_FAN:
+            return GetFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
+        case DSH_WATER_PUMP:
+            return GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) | (p_system->ch_water_overheat << 1);
+        case DSH_SPARK_IGNITER:
+            return GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F) | (p_system->ignition_tries << 1);
+        case DSH_LED_UI:
+            return GetFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        case DSH_VALVE_S:
+            return GetFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);
+        case DSH_VALVE_1:
+            return GetFlag(p_system, OUTPUT_FLAGS, VALVE_1_F);
+        case DSH_VALVE_2:
+            return GetFlag(p_system, OUTPUT_FLAGS, VALVE_2_F);
+        case DSH_VALVE_3:
+            return GetFlag(p_system, OUTPUT_FLAGS, VALVE_3_F);
+#if SHOW_PUMP_TIMER
+        case DSH_PUMP_TIMER:
+            return GetTimeLeft(PUMP_TIMER_ID) / PUMP_TIMER_DIVISOR;
+#endif  // SHOW_PUMP_TIMER
+        default:
+            return 0;
+    }
+}
 
-        // Mode display
-        switch (p_system->system_state) {
-            case OFF: {
-                SerialTxStr(str_mode_00);
-                break;
-            }
-            case READY: {
-                SerialTxStr(str_mode_10);
-                break;
-            }
-            case IGNITING: {
-                SerialTxStr(str_mode_20);
-                break;
-            }
-            case DHW_ON_DUTY: {
-                SerialTxStr(str_mode_30);
-                break;
+// Function WriteField: Sends the text of a dashboard field
+static void WriteField(SysInfo *p_system, DashboardField field) {
+    switch (field) {
+        case DSH_IFLAGS: {
+            SerialTxNum(p_system->input_flags, DIGITS_3);
+            break;
+        }
+        case DSH_DHW_TEMP:
+        case DSH_CH_TEMP: {
+            int temperature = (int)GetFieldValue(p_system, field);
+            if (temperature != INVALID_TEMP_D) {
+                SerialTxTemp(temperature);
+            } else {
+                SerialTxStr(str_temperr);
             }
-            case CH_ON_DUTY: {
-                SerialTxStr(str_mode_40);
-                switch (p_system->inner_step) {
-                    case CH_ON_DUTY_1: {
-                        SerialTxStr(str_mode_41);
-                        break;
-                    }
-                    case CH_ON_DUTY_2: {
-                        SerialTxStr(str_mode_42);
-                        break;
-                    }
-                    default:
-                        break;
+            break;
+        }
+        case DSH_CH_ADC: {
+            SerialTxNum(p_system->ch_temperature, DIGITS_4);
+            break;
+        }
+        case DSH_DHW_SETTING:
+        case DSH_CH_SETTING: {
+            SerialTxNum(GetFieldValue(p_system, field), DIGITS_2);
+            break;
+        }
+        case DSH_SYSTEM_MODE: {
+            switch (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS)) {
+                case SYS_COMBI: {
+                    SerialTxStr(sys_mode_00);
+                    break;
+                }
+                case SYS_DHW: {
+                    SerialTxStr(sys_mode_01);
+                    break;
+                }
+                case SYS_OFF: {
+                    SerialTxStr(sys_mode_02);
+                    break;
+                }
+                case SYS_RESET: {
+                    SerialTxStr(sys_mode_03);
+                    break;
                 }
-                break;
             }
-            case ERROR: {
-                SerialTxStr(str_mode_100);
-                break;
+            break;
+        }
+        case DSH_OFLAGS: {
+            SerialTxNum(p_system->output_flags, DIGITS_3);
+            break;
+        }
+        case DSH_WATER_PUMP: {
+            SerialTxBool(GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F));
+            if (p_system->ch_water_overheat) {
+                SerialTxChr(ASTERISK);  // Asterisk (*)
+                SerialTxStr(str_space_s);
+            } else {
+                SerialTxStr(str_space_m);
+            }
+            break;
+        }
+        case DSH_SPARK_IGNITER: {
+            if (GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F)) {
+                SerialTxStr(str_true);
+                SerialTxStr(str_space_xs);
+                SerialTxChr(IGNITION_TRIES_CHR);                  // Ingnition tries initial
+                SerialTxNum(p_system->ignition_tries, DIGITS_1);  // Displays ignition tries
+            } else {
+                SerialTxStr(str_false);
+                SerialTxStr(str_space_m);
             }
+            break;
+        }
+#if SHOW_PUMP_TIMER
+        case DSH_PUMP_TIMER: {
+            SerialTxNum(GetTimeLeft(PUMP_TIMER_ID) / PUMP_TIMER_DIVISOR, DIGITS_7);
+            break;
+        }
+#endif  // SHOW_PUMP_TIMER
+        default: {  // On/off fields
+            SerialTxBool(GetFieldValue(p_system, field));
+            break;
         }
+    }
+}
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+// Function DrawField: Sends a dashboard field while drawing the whole dashboard, recording where it is
+static void DrawField(SysInfo *p_system, DashboardField field) {
+#if DASHBOARD_DIFF
+    dashboard_fields[field].row = cursor_row;
+    dashboard_fields[field].column = cursor_column;
+    dashboard_fields[field].value = GetFieldValue(p_system, field);
+    WriteField(p_system, field);
+    dashboard_fields[field].width = cursor_column - dashboard_fields[field].column;
+#else
+    WriteField(p_system, field);
+#endif  // DASHBOARD_DIFF
+}
 
-        SerialTxStr(str_space_xs); 
-        
-        DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
-        SerialTxStr(str_space_xs);
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+// Function DrawDashboardRow: Sends a piece of the whole dashboard, each one fits in DASH_ROW_ROOM queue characters
+static void DrawDashboardRow(SysInfo *p_system, DashboardRow row) {
+    switch (row) {
+        case DSH_ROW_TOP: {
+            ClrScr();
+            DrawLine(DASH_WIDTH, H_ELINE);  // Dashed line
+            SerialTxStr(str_crlf);          // CR + new line
+            break;
+        }
+        case DSH_ROW_MODE: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_header_01);
+            SerialTxStr(str_header_02);
+
+            SerialTxStr(str_space_s);
+
+            // Mode display
+            switch (p_system->system_state) {
+                case OFF: {
+                    SerialTxStr(str_mode_00);
+                    break;
+                }
+                case READY: {
+                    SerialTxStr(str_mode_10);
+                    break;
+                }
+                case IGNITING: {
+                    SerialTxStr(str_mode_20);
+                    break;
+                }
+                case DHW_ON_DUTY: {
+                    SerialTxStr(str_mode_30);
+                    break;
+                }
+                case CH_ON_DUTY: {
+                    SerialTxStr(str_mode_40);
+                    switch (p_system->inner_step) {
+                        case CH_ON_DUTY_1: {
+                            SerialTxStr(str_mode_41);
+                            break;
+                        }
+                        case CH_ON_DUTY_2: {
+                            SerialTxStr(str_mode_42);
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                    break;
+                }
+                case ERROR: {
+                    SerialTxStr(str_mode_100);
+                    break;
+                }
+            }
+#if DASHBOARD_DIFF
+            dashboard_state_key = GetStateKey(p_system);
+#endif  // DASHBOARD_DIFF
 
-        SerialTxStr(str_crlf);  // CR + new line
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            break;
+        }
+        case DSH_ROW_INPUTS: {
+            SerialTxStr(str_space_xs);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
+            SerialTxStr(str_space_xs);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        // Input flags
-        SerialTxStr(str_iflags);
-        SerialTxNum(p_system->input_flags, DIGITS_3);
-        
-        SerialTxStr(str_space_s);
+            SerialTxStr(str_crlf);  // CR + new line
 
-        // DHW temperature
-        int dhw_temperature = GetNtcTemperature(p_system->dhw_temperature, TO_CELSIUS, DT_CELSIUS);
-        SerialTxStr(str_lit_13);
-        if (dhw_temperature != INVALID_TEMP_D) {
-            SerialTxTemp(dhw_temperature);
-        } else {
-            SerialTxStr(str_temperr);
-        }
-        //SerialTxChr(TILDE);  // Tilde (~)
-        SerialTxChr(APOSTROPHE);  // Apostrophe (')
-        SerialTxChr(CHR_C);       // C
-
-        SerialTxStr(str_space_s);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        // CH temperature
-        int ch_temperature = GetNtcTemperature(p_system->ch_temperature, TO_CELSIUS, DT_CELSIUS);
-        SerialTxStr(str_lit_14);
-        if (ch_temperature != INVALID_TEMP_D) {
-            SerialTxTemp(ch_temperature);
-        } else {
-            SerialTxStr(str_temperr);
+            // Input flags
+            SerialTxStr(str_iflags);
+            DrawField(p_system, DSH_IFLAGS);
+            break;
         }
-        //SerialTxChr(TILDE);    // Tilde (~)
-        SerialTxChr(APOSTROPHE);  // Apostrophe (')
-        SerialTxChr(CHR_C);       // C
-        SerialTxStr(str_space_xs);     
-        SerialTxNum(p_system->ch_temperature, DIGITS_4);
-        SerialTxStr(str_space_xs);
+        case DSH_ROW_TEMPERATURES: {
+            SerialTxStr(str_space_s);
+
+            // DHW temperature
+            SerialTxStr(str_lit_13);
+            DrawField(p_system, DSH_DHW_TEMP);
+            //SerialTxChr(TILDE);  // Tilde (~)
+            SerialTxChr(APOSTROPHE);  // Apostrophe (')
+            SerialTxChr(CHR_C);       // C
+
+            SerialTxStr(str_space_s);
+
+            // CH temperature
+            SerialTxStr(str_lit_14);
+            DrawField(p_system, DSH_CH_TEMP);
+            //SerialTxChr(TILDE);    // Tilde (~)
+            SerialTxChr(APOSTROPHE);  // Apostrophe (')
+            SerialTxChr(CHR_C);       // C
+            SerialTxStr(str_space_xs);
+            DrawField(p_system, DSH_CH_ADC);
+            SerialTxStr(str_space_xs);
 
-        // Overheat
+            // Overheat
 #if !(OVERHEAT_OVERRIDE)
-        SerialTxStr(str_lit_04);
+            SerialTxStr(str_lit_04);
 #else
-        SerialTxStr(str_lit_04_override);
+            SerialTxStr(str_lit_04_override);
 #endif  // OVERHEAT_OVERRIDE
-        if (GetFlag(p_system, INPUT_FLAGS, OVERHEAT_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
-
-        SerialTxStr(str_space_xs); 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+            DrawField(p_system, DSH_OVERHEAT);
 
-        SerialTxStr(str_crlf);  // CR + new line
-
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            SerialTxStr(str_space_xs);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        // DHW Request
-        SerialTxStr(str_lit_00);
-        if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
         }
+        case DSH_ROW_REQUESTS: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        SerialTxStr(str_space_m);
+            // DHW Request
+            SerialTxStr(str_lit_00);
+            DrawField(p_system, DSH_DHW_REQUEST);
 
-        //CH Request
-        SerialTxStr(str_lit_01);
-        if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
+            SerialTxStr(str_space_m);
 
-        SerialTxStr(str_space_s);
+            //CH Request
+            SerialTxStr(str_lit_01);
+            DrawField(p_system, DSH_CH_REQUEST);
 
-        // Airflow
+            SerialTxStr(str_space_s);
+
+            // Airflow
 #if !(AIRFLOW_OVERRIDE)
-        SerialTxStr(str_lit_02);
+            SerialTxStr(str_lit_02);
 #else
-        SerialTxStr(str_lit_02_override);
+            SerialTxStr(str_lit_02_override);
 #endif  // AIRFLOW_OVERRIDE
-        if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
-
-        SerialTxStr(str_space_s);
-        
-        // Flame
-        SerialTxStr(str_lit_03);
-        if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
-
-        SerialTxStr(str_space_s);
-
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-
-        SerialTxStr(str_crlf);  // CR + new line
+            DrawField(p_system, DSH_AIRFLOW);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            SerialTxStr(str_space_s);
 
-        DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
-        SerialTxStr(str_space_xs);               
-        SerialTxChr(V_LINE);                // Horizontal separator (|)
+            // Flame
+            SerialTxStr(str_lit_03);
+            DrawField(p_system, DSH_FLAME);
 
-        SerialTxStr(str_crlf);  // CR + new line
+            SerialTxStr(str_space_s);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        SerialTxStr(str_lit_18);
-        SerialTxStr(str_space_s);
-
-        SerialTxStr(str_lit_15);
-        SerialTxChr(CHR_RNDB_O);
-        SerialTxNum(GetKnobPosition(p_system->dhw_setting, DHW_SETTING_STEPS), DIGITS_2);
-        SerialTxChr(CHR_RNDB_C);
-        
-        SerialTxStr(str_space_m);
-
-        SerialTxStr(str_lit_16);
-        SerialTxChr(CHR_RNDB_O);
-        SerialTxNum(GetKnobPosition(p_system->ch_setting, CH_SETTING_STEPS), DIGITS_2);
-        SerialTxChr(CHR_RNDB_C);
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
+        }
+        case DSH_ROW_RULE_1: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        SerialTxStr(str_space_m);
+            DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
+            SerialTxStr(str_space_xs);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        SerialTxStr(str_lit_17);
-        switch (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS)) {
-            case SYS_COMBI: {
-                SerialTxStr(sys_mode_00);
-                break;
-            }
-            case SYS_DHW: {
-                SerialTxStr(sys_mode_01);
-                break;
-            }
-            case SYS_OFF: {
-                SerialTxStr(sys_mode_02);
-                break;
-            }
-            case SYS_RESET: {
-                SerialTxStr(sys_mode_03);
-                break;
-            }
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
         }
+        case DSH_ROW_SETTINGS: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-
-        SerialTxStr(str_crlf);  // CR + new line
+            SerialTxStr(str_lit_18);
+            SerialTxStr(str_space_s);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            SerialTxStr(str_lit_15);
+            SerialTxChr(CHR_RNDB_O);
+            DrawField(p_system, DSH_DHW_SETTING);
+            SerialTxChr(CHR_RNDB_C);
 
-        DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
-        SerialTxStr(str_space_xs);
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_m);
 
-        SerialTxStr(str_crlf);
+            SerialTxStr(str_lit_16);
+            SerialTxChr(CHR_RNDB_O);
+            DrawField(p_system, DSH_CH_SETTING);
+            SerialTxChr(CHR_RNDB_C);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        SerialTxStr(str_space_xs); 
+            SerialTxStr(str_space_m);
 
-        SerialTxStr(str_oflags);
-        SerialTxNum(p_system->output_flags, DIGITS_3);
+            SerialTxStr(str_lit_17);
+            DrawField(p_system, DSH_SYSTEM_MODE);
 
-        SerialTxStr(str_space_l);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        // Exhaust fan
-        SerialTxStr(str_lit_05);
-        if (GetFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
         }
+        case DSH_ROW_RULE_2: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        SerialTxStr(str_space_m);
+            DrawLine(DASH_WIDTH - 4, H_ILINE);  // Dotted line
+            SerialTxStr(str_space_xs);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        // Water pump
-        SerialTxStr(str_lit_06);
-        if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
+            SerialTxStr(str_crlf);
+            break;
         }
+        case DSH_ROW_OUTPUTS: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_xs);
 
-        if (p_system->ch_water_overheat) {
-            SerialTxChr(ASTERISK);  // Asterisk (*)
-            SerialTxStr(str_space_s);   
-        } else {
-            SerialTxStr(str_space_m);
-        }
+            SerialTxStr(str_oflags);
+            DrawField(p_system, DSH_OFLAGS);
 
-        // Spark igniter
-        SerialTxStr(str_lit_07);
-        if (GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F)) {
-            SerialTxStr(str_true);
-            SerialTxStr(str_space_xs);                             
-            SerialTxChr(IGNITION_TRIES_CHR);                  // Ingnition tries initial
-            SerialTxNum(p_system->ignition_tries, DIGITS_1);  // Displays ignition tries
-        } else {
-            SerialTxStr(str_false);
-            SerialTxStr(str_space_m);
-        }
+            SerialTxStr(str_space_l);
 
-        SerialTxStr(str_space_s);
+            // Exhaust fan
+            SerialTxStr(str_lit_05);
+            DrawField(p_system, DSH_EXHAUST_FAN);
 
-        // LED UI
-        SerialTxStr(str_lit_12);
-        if (GetFlag(p_system, OUTPUT_FLAGS, LED_UI_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
+            SerialTxStr(str_space_m);
 
-        SerialTxStr(str_space_xs);
+            // Water pump
+            SerialTxStr(str_lit_06);
+            DrawField(p_system, DSH_WATER_PUMP);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+            // Spark igniter
+            SerialTxStr(str_lit_07);
+            DrawField(p_system, DSH_SPARK_IGNITER);
 
-        SerialTxStr(str_crlf);  // CR + new line
+            SerialTxStr(str_space_s);
 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
-        
-        SerialTxStr(str_space_xs);
+            // LED UI
+            SerialTxStr(str_lit_12);
+            DrawField(p_system, DSH_LED_UI);
 
-        // Security valve
-        SerialTxStr(str_lit_08);
-        if (GetFlag(p_system, OUTPUT_FLAGS, VALVE_S_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
+            SerialTxStr(str_space_xs);
 
-        SerialTxStr(str_space_s);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        // Valve 1
-        SerialTxStr(str_lit_09);
-        if (GetFlag(p_system, OUTPUT_FLAGS, VALVE_1_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
         }
+        case DSH_ROW_VALVES: {
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
 
-        SerialTxStr(str_space_s);
+            SerialTxStr(str_space_xs);
 
-        // Valve 2
-        SerialTxStr(str_lit_10);
-        if (GetFlag(p_system, OUTPUT_FLAGS, VALVE_2_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
+            // Security valve
+            SerialTxStr(str_lit_08);
+            DrawField(p_system, DSH_VALVE_S);
 
-        SerialTxStr(str_space_s);
+            SerialTxStr(str_space_s);
 
-        // Valve 3
-        SerialTxStr(str_lit_11);
-        if (GetFlag(p_system, OUTPUT_FLAGS, VALVE_3_F)) {
-            SerialTxStr(str_true);
-        } else {
-            SerialTxStr(str_false);
-        }
+            // Valve 1
+            SerialTxStr(str_lit_09);
+            DrawField(p_system, DSH_VALVE_1);
 
-        SerialTxStr(str_space_xs); 
-        SerialTxChr(V_LINE);  // Horizontal separator (|)
+            SerialTxStr(str_space_s);
 
-        SerialTxStr(str_crlf);          // CR + new line
-        DrawLine(DASH_WIDTH, H_ELINE);  // Dashed line
-        SerialTxStr(str_crlf);          // CR + new line
+            // Valve 2
+            SerialTxStr(str_lit_10);
+            DrawField(p_system, DSH_VALVE_2);
 
-#if SHOW_PUMP_TIMER
-        SerialTxStr(str_crlf);
-        SerialTxStr(str_wptimer);
-        //SerialTxNum(p_system->pump_delay, DIGITS_7);
-        SerialTxNum(GetTimeLeft(PUMP_TIMER_ID) / PUMP_TIMER_DIVISOR, DIGITS_7);
-        //SerialTxNum(GetTimeLeft, DIGITS_7);
+            SerialTxStr(str_space_s);
+
+            // Valve 3
+            SerialTxStr(str_lit_11);
+            DrawField(p_system, DSH_VALVE_3);
 
-        if (p_system->pump_timer_memory) {
             SerialTxStr(str_space_xs);
-            SerialTxStr(str_wpmemory);
-            SerialTxNum(p_system->pump_timer_memory / PUMP_TIMER_DIVISOR, DIGITS_7);
-            SerialTxStr(str_crlf);
+            SerialTxChr(V_LINE);  // Horizontal separator (|)
+
+            SerialTxStr(str_crlf);  // CR + new line
+            break;
         }
+        case DSH_ROW_BOTTOM: {
+            DrawLine(DASH_WIDTH, H_ELINE);  // Dashed line
+            SerialTxStr(str_crlf);          // CR + new line
+            break;
+        }
+        case DSH_ROW_PUMP_TIMER: {
+#if SHOW_PUMP_TIMER
+            SerialTxStr(str_crlf);
+            SerialTxStr(str_wptimer);
+            DrawField(p_system, DSH_PUMP_TIMER);
+
+            if (p_system->pump_timer_memory) {
+                SerialTxStr(str_space_xs);
+                SerialTxStr(str_wpmemory);
+                SerialTxNum(p_system->pump_timer_memory / PUMP_TIMER_DIVISOR, DIGITS_7);
+                SerialTxStr(str_crlf);
+            }
 #endif  // SHOW_PUMP_TIMER
-        SerialTxStr(str_crlf);
-        SerialTxStr(str_crlf);
+#if DASHBOARD_DIFF
+            dashboard_pump_memory = p_system->pump_timer_memory;
+#endif  // DASHBOARD_DIFF
+            SerialTxStr(str_crlf);
+            break;
+        }
+        case DSH_ROW_PROFILE: {
+            // The task loop profile page goes out a line at a time before this row on each whole redraw (UpdateProfile
+            // rewrites it in place every PROFILE_REFRESH ms)
+            SerialTxStr(str_crlf);
+            break;
+        }
+        case DSH_ROW_ERROR: {
+            // Error code, shown under the dashboard while in the ERROR state
+            if (p_system->system_state == ERROR) {
+                SerialTxStr(str_error_s);
+                SerialTxNum(p_system->error, DIGITS_3);
+                SerialTxStr(str_error_e);
+                SerialTxStr(str_crlf);
+            }
+#if DASHBOARD_DIFF
+            // Park the cursor here after each update, below the dashboard
+            dashboard_end_row = cursor_row;
+            dashboard_drawn = true;
+#endif  // DASHBOARD_DIFF
+            break;
+        }
+        default: {
+            break;
+        }
     }
 }
 
-#endif  // SHOW_DASHBOARD
+// Function DrawDashboard: Goes on with the whole dashboard redraw in progress, sending the rows that fit in the queue
+static void DrawDashboard(SysInfo *p_system) {
+    while ((dashboard_row < DASHBOARD_ROWS) && (GetSerialTxFree() >= DASH_ROW_ROOM)) {
+#if LOOP_PROFILER
+        if ((dashboard_row == DSH_ROW_PROFILE) && (dashboard_profile_line < PROFILE_LINES)) {
+#if DASHBOARD_DIFF
+            if (dashboard_profile_line == 0) {
+                dashboard_profile_row = cursor_row;
+            }
+#endif  // DASHBOARD_DIFF
+            SendProfileLine(dashboard_profile_line++);
+            continue;
+        }
+#endif  // LOOP_PROFILER
+        DrawDashboardRow(p_system, dashboard_row++);
+    }
+}
+
+#if (DASHBOARD_DIFF && LOOP_PROFILER)
+// Function UpdateProfile: Rewrites the profile page in place every PROFILE_REFRESH ms, the lines that fit in the queue.
+// Returns true while the rewrite is in progress, meanwhile the cursor is on the profile page.
+static bool UpdateProfile(void) {
+    if (dashboard_profile_line >= PROFILE_LINES) {
+        if ((GetMilliseconds() - dashboard_profile_time) < PROFILE_REFRESH) {
+            return false;
+        }
+        dashboard_profile_time = GetMilliseconds();
+        dashboard_profile_line = 1;  // The header stays, the profile lines have fixed widths
+        MoveCursor(dashboard_profile_row + 1, 1);
+    }
+    while ((dashboard_profile_line < PROFILE_LINES) && (GetSerialTxFree() >= DASH_ROW_ROOM)) {
+        SendProfileLine(dashboard_profile_line++);
+    }
+    if (dashboard_profile_line < PROFILE_LINES) {
+        return true;
+    }
+    MoveCursor(dashboard_end_row, 1);
+    return false;
+}
+#endif  // DASHBOARD_DIFF && LOOP_PROFILER
+
+#if DASHBOARD_DIFF
+// Function UpdateDashboard: Rewrites in place the dashboard fields whose values changed, returns false if a field didn't fit
+static bool UpdateDashboard(SysInfo *p_system) {
+    bool cursor_moved = false;
+    for (DashboardField field = 0; field < DASHBOARD_FIELDS; field++) {
+        DashboardSlot *p_slot = &dashboard_fields[field];
+        if (p_slot->row == 0) {
+            continue;  // Field not shown
+        }
+        uint16_t value = GetFieldValue(p_system, field);
+        if (value == p_slot->value) {
+            continue;
+        }
+        if (GetSerialTxFree() < DASH_FIELD_ROOM) {
+            break;  // Queue short of room, the remaining fields still differ and go on the next update
+        }
+        MoveCursor(p_slot->row, p_slot->column);
+        WriteField(p_system, field);
+        cursor_moved = true;
+        p_slot->value = value;
+        uint8_t width = cursor_column - p_slot->column;
+        if (width > p_slot->width) {
+            return false;  // The new text overwrote part of the layout
+        }
+        // Blank the rest of a field that got shorter
+        while (width++ < p_slot->width) {
+            SerialTxChr(SPACE);
+        }
+    }
+    if (cursor_moved) {
+        MoveCursor(dashboard_end_row, 1);
+    }
+    return true;
+}
+#endif  // DASHBOARD_DIFF
+
+// Function Dashboard: Displays the system status, redrawing it whole or only its changed fields.
+// A whole redraw goes out a few rows per call as the queue drains, so no call waits for the serial line.
+void Dashboard(SysInfo *p_system, bool force_refresh) {
+    bool redraw = force_refresh || (p_system->last_displayed_iflags == DASHBOARD_REFRESH);
+    if (dashboard_row >= DASHBOARD_ROWS) {
+#if DASHBOARD_DIFF
+        redraw = redraw || (dashboard_drawn == false) ||
+                 (GetStateKey(p_system) != dashboard_state_key) ||
+                 (p_system->pump_timer_memory != dashboard_pump_memory);
+#if LOOP_PROFILER
+        // The fields wait while the profile page is rewritten, the cursor is away from the dashboard end
+        redraw = redraw || ((UpdateProfile() == false) && (UpdateDashboard(p_system) == false));
+#else
+        redraw = redraw || (UpdateDashboard(p_system) == false);
+#endif  // LOOP_PROFILER
+#else
+        redraw = redraw ||
+                 (p_system->input_flags != p_system->last_displayed_iflags) ||
+                 (p_system->output_flags != p_system->last_displayed_oflags);
+#if LOOP_PROFILER
+        redraw = redraw || ((GetMilliseconds() - dashboard_profile_time) >= PROFILE_REFRESH);
+#endif  // LOOP_PROFILER
+#endif  // DASHBOARD_DIFF
+    }
+    if (redraw) {
+        // Start over, a field that changes while the rest is sent is updated after the redraw
+        dashboard_row = DSH_ROW_TOP;
+#if LOOP_PROFILER
+        dashboard_profile_line = 0;
+        dashboard_profile_time = GetMilliseconds();
+#endif  // LOOP_PROFILER
+#if DASHBOARD_DIFF
+        dashboard_drawn = false;
+#endif  // DASHBOARD_DIFF
+    }
+    DrawDashboard(p_system);
+    p_system->last_displayed_iflags = p_system->input_flags;
+    p_system->last_displayed_oflags = p_system->output_flags;
+}
+
+// Function DashboardPending: Tells if a whole dashboard redraw is still going out
+bool DashboardPending(void) {
+    return (dashboard_row < DASHBOARD_ROWS);
+}
+
+#endif  // DASHBOARD_FRAMES
@@ -12,10 +12,12 @@
 #ifndef SERIAL_UI_H
 #define SERIAL_UI_H
 
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <hal.h>
+#include <num-format.h>
+#include <profiler.h>
 #include <stdbool.h>
-#include <stdio.h>
 #include <string.h>
 #include <temp-calc.h>
 #include <timers.h>
@@ -39,6 +41,27 @@
 #define BAUDRATE 57600
 #define BAUD_PRESCALER (((F_CPU / (BAUDRATE * 16UL))) - 1)
 
+#define TX_BUFFER_LENGTH 128   // Serial transmission queue length (power of two, 256 max)
+#define TX_DROP_ON_FULL false  // True: drop characters when the transmission queue is full. False: wait for room
+// A whole dashboard redraw is about 900 characters, 160 ms of line time at 57600 bps. It goes out one row at a
+// time when the queue has room, spread over the dashboard task runs (the loop profiler page one line at a time).
+#define DASH_ROW_ROOM 96       // Free transmission queue characters needed to send the next row of a whole dashboard redraw
+#define DASH_FIELD_ROOM 32     // Free transmission queue characters needed to rewrite a dashboard field in place
+#define PROFILE_REFRESH 2000   // Loop profile page refresh period on the dashboard (milliseconds)
+#define RX_BUFFER_LENGTH 32    // Serial reception queue length (power of two, 256 max), filled by the USART RX interrupt
+
+#if ((TX_BUFFER_LENGTH & (TX_BUFFER_LENGTH - 1)) || (TX_BUFFER_LENGTH > 256))
+#error "TX_BUFFER_LENGTH must be a power of two, 256 max"
+#endif
+
+#if (DASH_ROW_ROOM >= TX_BUFFER_LENGTH)
+#error "DASH_ROW_ROOM must be shorter than TX_BUFFER_LENGTH"
+#endif
+
+#if ((RX_BUFFER_LENGTH & (RX_BUFFER_LENGTH - 1)) || (RX_BUFFER_LENGTH > 256))
+#error "RX_BUFFER_LENGTH must be a power of two, 256 max"
+#endif
+
 // Types
 
 typedef enum digit_length {
@@ -55,20 +78,79 @@ typedef enum digit_length {
     DIGITS_FREE = 0
 } DigitLength;
 
+#if DASHBOARD_FRAMES
+#define DASHBOARD_REFRESH 0xFF  // last_displayed_iflags marker that makes the next Dashboard call redraw it whole
+
+typedef enum dashboard_field {
+    DSH_IFLAGS = 0,
+    DSH_DHW_TEMP,
+    DSH_CH_TEMP,
+    DSH_CH_ADC,
+    DSH_OVERHEAT,
+    DSH_DHW_REQUEST,
+    DSH_CH_REQUEST,
+    DSH_AIRFLOW,
+    DSH_FLAME,
+    DSH_DHW_SETTING,
+    DSH_CH_SETTING,
+    DSH_SYSTEM_MODE,
+    DSH_OFLAGS,
+    DSH_EXHAUST_FAN,
+    DSH_WATER_PUMP,
+    DSH_SPARK_IGNITER,
+    DSH_LED_UI,
+    DSH_VALVE_S,
+    DSH_VALVE_1,
+    DSH_VALVE_2,
+    DSH_VALVE_3,
+    DSH_PUMP_TIMER,
+    DASHBOARD_FIELDS  // Number of dashboard fields
+} DashboardField;
+
+typedef enum dashboard_row {
+    DSH_ROW_TOP = 0,
+    DSH_ROW_MODE,
+    DSH_ROW_INPUTS,
+    DSH_ROW_TEMPERATURES,
+    DSH_ROW_REQUESTS,
+    DSH_ROW_RULE_1,
+    DSH_ROW_SETTINGS,
+    DSH_ROW_RULE_2,
+    DSH_ROW_OUTPUTS,
+    DSH_ROW_VALVES,
+    DSH_ROW_BOTTOM,
+    DSH_ROW_PUMP_TIMER,
+    DSH_ROW_PROFILE,
+    DSH_ROW_ERROR,
+    DASHBOARD_ROWS  // Number of dashboard rows, no whole redraw in progress
+} DashboardRow;
+
+typedef struct dashboard_slot {
+    uint8_t row;     // Terminal row where the field starts, 0 when the field isn't shown
+    uint8_t column;  // Terminal column where the field starts
+    uint8_t width;   // Characters taken by the field when the dashboard was drawn
+    uint16_t value;  // Last displayed value
+} DashboardSlot;
+#endif  // DASHBOARD_FRAMES
+
 // Prototypes
 
 void SerialInit(void);
-uint8_t SerialRxChr(void);
+bool SerialRxChr(uint8_t *p_character);
+uint16_t GetSerialRxOverflows(void);
 void SerialTxChr(uint8_t character_code);
+uint16_t GetSerialTxOverflows(void);
+uint8_t GetSerialTxFree(void);
 void SerialTxNum(uint32_t number, DigitLength digits);
 void SerialTxStr(const __flash char *ptr_string);
 void SerialTxTemp(int ntc_temperature);
 void DrawLine(uint8_t length, char line_char);
 int DivRound(const int numerator, const int denominator);
 void ClrScr(void);
-#if SHOW_DASHBOARD
+#if DASHBOARD_FRAMES
 void Dashboard(SysInfo *p_system, bool force_refresh);
-#endif  // SHOW_DASHBOARD
+bool DashboardPending(void);
+#endif  // DASHBOARD_FRAMES
 
 // Global console UI literals
 
@@ -0,0 +1,328 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: shell.c (serial command shell) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "shell.h"
+
+#if SERIAL_SHELL
+
+// Command line, tokenized in place while it is typed: separators are stored as string terminators
+static char line[SHELL_LINE_LENGTH];
+static uint8_t line_length = 0;                // Characters in the line, separators included
+static uint8_t token_start[SHELL_MAX_TOKENS];  // Position of each token in the line
+static uint8_t token_count = 0;                // Tokens started in the line
+static bool in_token = false;                  // The last character belongs to a token
+static bool line_overflow = false;             // The line didn't fit in the buffer or had too many tokens
+static uint8_t last_character = 0;             // Previous character received, pairs CR LF line ends
+
+// Function SerialTxRamStr: Sends a string stored in RAM
+static void SerialTxRamStr(const char *p_string) {
+    while (*p_string != '\0') {
+        SerialTxChr(*p_string++);
+    }
+}
+
+// Function ShellReply: Sends a reply line
+static void ShellReply(const __flash char *p_reply) {
+    SerialTxStr(p_reply);
+    SerialTxStr(str_crlf);
+}
+
+// Function MatchWord: Tells if a received word equals a flash string
+static bool MatchWord(const char *p_word, const __flash char *p_name) {
+    while ((*p_name != '\0') && (*p_name == *p_word)) {
+        p_name++;
+        p_word++;
+    }
+    return ((*p_name == '\0') && (*p_word == '\0'));
+}
+
+// Function ParseNumber: Converts a decimal word to a number, returns false if it isn't one or doesn't fit in 32 bits
+static bool ParseNumber(const char *p_word, uint32_t *p_number) {
+    uint32_t number = 0;
+    if (*p_word == '\0') {
+        return false;
+    }
+    for (; *p_word != '\0'; p_word++) {
+        if ((*p_word < '0') || (*p_word > '9')) {
+            return false;
+        }
+        uint8_t digit = *p_word - '0';
+        if (number > ((UINT32_MAX - digit) / 10)) {
+            return false;
+        }
+        number = (number * 10) + digit;
+    }
+    *p_number = number;
+    return true;
+}
+
+// Command help: Lists the commands
+static void CommandHelp(SysInfo *p_system, uint8_t argc, char *argv[]);
+
+// Command get: Sends a parameter, or all of them
+static void CommandGet(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    if (argc < 2) {
+        SendParams();
+        return;
+    }
+    ParamId param = FindParam(argv[1]);
+    if (param == PARAMS_COUNT) {
+        ShellReply(str_shell_bad_args);
+        return;
+    }
+    SerialTxRamStr(argv[1]);
+    SerialTxChr(' ');
+    SerialTxNum(GetParam(param), DIGITS_FREE);
+    SerialTxStr(str_crlf);
+}
+
+// Command set: Changes a parameter in RAM, save makes it permanent
+static void CommandSet(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    uint32_t value;
+    if (ParseNumber(argv[2], &value) && SetParam(FindParam(argv[1]), value)) {
+        ShellReply(str_shell_ok);
+    } else {
+        ShellReply(str_shell_bad_args);
+    }
+}
+
+// Command save: Writes the parameters to EEPROM
+static void CommandSave(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    ShellReply(SaveParams() ? str_shell_ok : str_shell_busy);
+}
+
+// Command defaults: Restores the default parameters in RAM, save makes it permanent
+static void CommandDefaults(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    ResetParams();
+    ShellReply(str_shell_ok);
+}
+
+// Command log: Sends the event log
+static void CommandLog(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    SendEventLog();
+}
+
+// Command stats: Sends the burner statistics
+static void CommandStats(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    SendBurnerStats();
+}
+
+#if LOOP_PROFILER
+// Command profile: Sends the task loop profile
+static void CommandProfile(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    SendProfile();
+}
+#endif  // LOOP_PROFILER
+
+// Command dash: Sends one whole dashboard frame, RunShell holds the echo and the prompt until it is out
+static void CommandDash(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    Dashboard(p_system, true);
+}
+
+#if SHELL_SENSOR_SIM
+// Digital input names, in InputFlag order
+static const char __flash str_sim_dhw[] = {"dhw"};
+static const char __flash str_sim_ch[] = {"ch"};
+static const char __flash str_sim_airflow[] = {"airflow"};
+static const char __flash str_sim_flame[] = {"flame"};
+static const char __flash str_sim_overheat[] = {"overheat"};
+static const char __flash *const __flash sim_inputs[DIGITAL_INPUTS] = {
+    str_sim_dhw, str_sim_ch, str_sim_airflow, str_sim_flame, str_sim_overheat};
+static const char __flash str_sim_on[] = {"on"};
+static const char __flash str_sim_off[] = {"off"};
+static const char __flash str_sim_pin[] = {"pin"};
+
+// Command sim: Forces a digital input on or off, or gives it back to its pin
+static void CommandSim(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    for (InputFlag input = 0; input < DIGITAL_INPUTS; input++) {
+        if (MatchWord(argv[1], sim_inputs[input]) == false) {
+            continue;
+        }
+        if (MatchWord(argv[2], str_sim_on)) {
+            SimulateDigitalInput(input, true, true);
+        } else if (MatchWord(argv[2], str_sim_off)) {
+            SimulateDigitalInput(input, true, false);
+        } else if (MatchWord(argv[2], str_sim_pin)) {
+            SimulateDigitalInput(input, false, false);
+        } else {
+            break;
+        }
+        ShellReply(str_shell_ok);
+        return;
+    }
+    ShellReply(str_shell_bad_args);
+}
+#endif  // SHELL_SENSOR_SIM
+
+// Command words and their arguments
+static const char __flash str_cmd_help[] = {"help"};
+static const char __flash str_cmd_get[] = {"get"};
+static const char __flash str_cmd_set[] = {"set"};
+static const char __flash str_cmd_save[] = {"save"};
+static const char __flash str_cmd_defaults[] = {"defaults"};
+static const char __flash str_cmd_log[] = {"log"};
+static const char __flash str_cmd_stats[] = {"stats"};
+static const char __flash str_cmd_dash[] = {"dash"};
+static const char __flash str_args_none[] = {""};
+static const char __flash str_args_get[] = {"[parameter]"};
+static const char __flash str_args_set[] = {"parameter value"};
+#if LOOP_PROFILER
+static const char __flash str_cmd_profile[] = {"profile"};
+#endif  // LOOP_PROFILER
+#if SHELL_SENSOR_SIM
+static const char __flash str_cmd_sim[] = {"sim"};
+static const char __flash str_args_sim[] = {"dhw|ch|airflow|flame|overheat on|off|pin"};
+#endif  // SHELL_SENSOR_SIM
+
+// Command table
+static const ShellEntry __flash shell_commands[] = {
+    {str_cmd_help,     CommandHelp,     0, str_args_none},
+    {str_cmd_get,      CommandGet,      0, str_args_get},
+    {str_cmd_set,      CommandSet,      2, str_args_set},
+    {str_cmd_save,     CommandSave,     0, str_args_none},
+    {str_cmd_defaults, CommandDefaults, 0, str_args_none},
+    {str_cmd_log,      CommandLog,      0, str_args_none},
+    {str_cmd_stats,    CommandStats,    0, str_args_none},
+    {str_cmd_dash,     CommandDash,     0, str_args_none},
+#if LOOP_PROFILER
+    {str_cmd_profile,  CommandProfile,  0, str_args_none},
+#endif  // LOOP_PROFILER
+#if SHELL_SENSOR_SIM
+    {str_cmd_sim,      CommandSim,      2, str_args_sim},
+#endif  // SHELL_SENSOR_SIM
+};
+
+#define SHELL_COMMANDS (sizeof(shell_commands) / sizeof(shell_commands[0]))
+
+// Command help: Lists the commands
+static void CommandHelp(SysInfo *p_system, uint8_t argc, char *argv[]) {
+    for (uint8_t cmd = 0; cmd < SHELL_COMMANDS; cmd++) {
+        SerialTxStr(shell_commands[cmd].name);
+        if (shell_commands[cmd].usage[0] != '\0') {
+            SerialTxChr(' ');
+            SerialTxStr(shell_commands[cmd].usage);
+        }
+        SerialTxStr(str_crlf);
+    }
+}
+
+// Function RunCommand: Runs the command in the line buffer
+static void RunCommand(SysInfo *p_system) {
+    char *argv[SHELL_MAX_TOKENS];
+    for (uint8_t token = 0; token < token_count; token++) {
+        argv[token] = &line[token_start[token]];
+    }
+    for (uint8_t cmd = 0; cmd < SHELL_COMMANDS; cmd++) {
+        if (MatchWord(argv[0], shell_commands[cmd].name)) {
+            if ((token_count - 1) < shell_commands[cmd].min_args) {
+                ShellReply(str_shell_bad_args);
+            } else {
+                shell_commands[cmd].command(p_system, token_count, argv);
+            }
+            return;
+        }
+    }
+    ShellReply(str_shell_unknown);
+}
+
+// Function EndLine: Runs the line received and clears the buffer for the next one
+static void EndLine(SysInfo *p_system) {
+    line[line_length] = '\0';
+#if SHELL_ECHO
+    SerialTxStr(str_crlf);
+#endif  // SHELL_ECHO
+    if (line_overflow) {
+        ShellReply(str_shell_too_long);
+    } else if (token_count > 0) {
+        RunCommand(p_system);
+    }
+    line_length = 0;
+    token_count = 0;
+    in_token = false;
+    line_overflow = false;
+    if (DashboardPending() == false) {
+        SerialTxStr(str_shell_prompt);  // After a dash frame, RunShell sends it when the frame is out
+    }
+}
+
+// Function EraseCharacter: Removes the last character of the line
+static void EraseCharacter(void) {
+    if (line_length == 0) {
+        return;
+    }
+    line_length--;
+    if ((token_count > 0) && (token_start[token_count - 1] == line_length)) {
+        token_count--;  // First character of the last token
+    }
+    in_token = ((line_length > 0) && (line[line_length - 1] != '\0'));
+#if SHELL_ECHO
+    SerialTxChr('\b');
+    SerialTxChr(' ');
+    SerialTxChr('\b');
+#endif  // SHELL_ECHO
+}
+
+// Function RunShell: Takes one received character and adds it to the command line, running the line when it ends.
+// A single character per call keeps a flood of input from holding up the other tasks, the excess is dropped by the reception queue
+void RunShell(SysInfo *p_system) {
+    if (DashboardPending()) {
+        // A dash frame is going out a few rows per call, the received characters wait unechoed in the reception queue
+        Dashboard(p_system, false);
+        if (DashboardPending() == false) {
+            SerialTxStr(str_shell_prompt);
+        }
+        return;
+    }
+    uint8_t character;
+    if (SerialRxChr(&character) == false) {
+        return;
+    }
+    uint8_t previous = last_character;
+    last_character = character;
+    if ((character == '\r') || (character == '\n')) {
+        if ((character == '\n') && (previous == '\r')) {
+            return;  // CR LF line end
+        }
+        EndLine(p_system);
+        return;
+    }
+    if ((character == '\b') || (character == 127)) {
+        EraseCharacter();
+        return;
+    }
+    if ((character < ' ') || (character > '~')) {
+        return;  // Other control characters are ignored
+    }
+    if (line_overflow) {
+        return;  // Discard the rest of a line that didn't fit
+    }
+    if (line_length >= (SHELL_LINE_LENGTH - 1)) {
+        line_overflow = true;
+        return;
+    }
+    if (character == ' ') {
+        character = '\0';  // Token separator
+        in_token = false;
+    } else if (in_token == false) {
+        if (token_count >= SHELL_MAX_TOKENS) {
+            line_overflow = true;
+            return;
+        }
+        token_start[token_count++] = line_length;
+        in_token = true;
+    }
+    line[line_length++] = character;
+#if SHELL_ECHO
+    SerialTxChr(last_character);
+#endif  // SHELL_ECHO
+}
+
+#endif  // SERIAL_SHELL
@@ -0,0 +1,61 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: shell.h (serial command shell headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <burner-stats.h>
+#include <event-log.h>
+#include <hal.h>
+#include <params.h>
+#include <profiler.h>
+#include <serial-ui.h>
+#include <stdbool.h>
+
+#include "../../include/sys-settings.h"
+
+#define SHELL_LINE_LENGTH 32  // Command line buffer, including the terminator
+#define SHELL_MAX_TOKENS 3    // Command word and up to two arguments
+#define SHELL_ECHO true       // True: Echoes the received characters back to the terminal
+
+#if (SERIAL_SHELL && SERIAL_TELEMETRY)
+#error "SERIAL_SHELL and SERIAL_TELEMETRY share the serial port, enable only one of them"
+#endif
+
+#if (SERIAL_SHELL && SHOW_DASHBOARD)
+#error "SERIAL_SHELL and SHOW_DASHBOARD share the serial terminal, enable only one of them (the shell dash command sends single frames)"
+#endif
+
+// Types
+
+typedef void (*ShellCommand)(SysInfo *p_system, uint8_t argc, char *argv[]);
+
+typedef struct shell_entry {
+    const __flash char *name;   // Command word
+    ShellCommand command;       // Handler, argv[0] is the command word
+    uint8_t min_args;           // Arguments needed, not counting the command word
+    const __flash char *usage;  // Arguments shown by help
+} ShellEntry;
+
+// Prototypes
+
+void RunShell(SysInfo *p_system);
+
+// Serial shell literals
+
+static const char __flash str_shell_prompt[] = {"> "};
+static const char __flash str_shell_ok[] = {"ok"};
+static const char __flash str_shell_busy[] = {"busy, try again"};
+static const char __flash str_shell_unknown[] = {"unknown command, try help"};
+static const char __flash str_shell_bad_args[] = {"bad arguments, try help"};
+static const char __flash str_shell_too_long[] = {"line too long or too many arguments"};
+
+#endif  // SHELL_H
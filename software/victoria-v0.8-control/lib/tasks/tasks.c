@@ -0,0 +1,89 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: tasks.c (cooperative task scheduler library) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "tasks.h"
+
+// System tasks, one slot per task id (slot = task_id - 1)
+static SystemTask task_buffer[SYSTEM_TASKS];
+static uint32_t next_deadline = 0;  // Nearest next_run of all tasks
+
+// Function GetTask: Returns the slot of a task id, NULL if the id is out of range
+static SystemTask *GetTask(TaskId task_id) {
+    if ((task_id == 0) || (task_id > SYSTEM_TASKS)) {
+        return NULL;
+    }
+    return &task_buffer[task_id - 1];
+}
+
+// Function AddTask: Sets a task body to run every period milliseconds, the first run is due right away
+bool AddTask(TaskId task_id, TaskFunction function, void *p_data, uint16_t period) {
+    SystemTask *p_task = GetTask(task_id);
+    if ((p_task == NULL) || (function == NULL)) {
+        return false;
+    }
+    p_task->function = function;
+    p_task->p_data = p_data;
+    p_task->period = period;
+    p_task->next_run = GetMilliseconds();
+    next_deadline = p_task->next_run;
+    return true;
+}
+
+// Function RunTasks: Runs the due tasks in id order, then sleeps until the next system tick if none is due
+void RunTasks(void) {
+    uint32_t now = GetMilliseconds();
+    if ((int32_t)(now - next_deadline) >= 0) {
+#if LOOP_PROFILER
+        uint32_t pass_start = GetCycles();
+#endif  // LOOP_PROFILER
+        // One timers snapshot for all the tasks run in this pass
+        UpdateTimers();
+        next_deadline = now + UINT16_MAX;
+        for (uint8_t i = 0; i < SYSTEM_TASKS; i++) {
+            SystemTask *p_task = &task_buffer[i];
+            if (p_task->function == NULL) {
+                continue;
+            }
+            if ((int32_t)(now - p_task->next_run) >= 0) {
+#if LOOP_PROFILER
+                uint32_t task_start = GetCycles();
+#endif  // LOOP_PROFILER
+                p_task->function(p_task->p_data);
+#if LOOP_PROFILER
+                ProfileRun(i + 1, task_start);
+#endif  // LOOP_PROFILER
+                // Keep the task on its period grid, unless it fell behind by a whole period
+                p_task->next_run += p_task->period;
+                if ((int32_t)(now - p_task->next_run) >= 0) {
+                    p_task->next_run = now + p_task->period;
+                }
+            }
+            if ((int32_t)(p_task->next_run - next_deadline) < 0) {
+                next_deadline = p_task->next_run;
+            }
+        }
+#if LOOP_PROFILER
+        ProfileRun(PROFILE_PASS, pass_start);
+#endif  // LOOP_PROFILER
+    }
+#if ENABLE_IDLE_SLEEP
+    // Sleep until the next interrupt (system tick or ADC conversion) unless a task is already due
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    if ((int32_t)(GetMilliseconds() - next_deadline) < 0) {
+        sleep_enable();
+        sei();  // The instruction after SEI runs before any pending interrupt, so no wake-up is missed
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+#endif  // ENABLE_IDLE_SLEEP
+}
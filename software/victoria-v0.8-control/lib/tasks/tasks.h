@@ -0,0 +1,47 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: tasks.h (cooperative task scheduler headers) for ATmega328
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SYS_TASKS_H
+#define SYS_TASKS_H
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <profiler.h>
+#include <stdbool.h>
+#include <timers.h>
+
+#include "../../include/sys-settings.h"
+
+#if ((SENSORS_TASK_ID > SYSTEM_TASKS) || (FSM_TASK_ID > SYSTEM_TASKS) || (HEAT_TASK_ID > SYSTEM_TASKS) || \
+     (DASHBOARD_TASK_ID > SYSTEM_TASKS) || (WATCHDOG_TASK_ID > SYSTEM_TASKS) || (TELEMETRY_TASK_ID > SYSTEM_TASKS) || \
+     (SHELL_TASK_ID > SYSTEM_TASKS))
+#error "Task ids must be in the 1 to SYSTEM_TASKS range"
+#endif
+
+// Types
+
+typedef uint8_t TaskId;
+typedef void (*TaskFunction)(void *p_data);
+
+typedef struct task {
+    TaskFunction function;  // Task body, NULL when the slot is free
+    void *p_data;           // Argument passed to the task body
+    uint16_t period;        // Time between runs (milliseconds)
+    uint32_t next_run;      // Time of the next run (milliseconds)
+} SystemTask;
+
+// Prototypes
+
+bool AddTask(TaskId task_id, TaskFunction function, void *p_data, uint16_t period);
+void RunTasks(void);
+
+#endif  // SYS_TASKS_H
@@ -0,0 +1,99 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: telemetry.c (binary telemetry library)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#include "telemetry.h"
+
+static uint8_t telemetry_sequence = 0;  // Packet counter, lets the receiver detect lost frames
+
+// Function PutWord: Stores a 16-bit value little-endian
+static void PutWord(uint8_t *p_packet, uint16_t value) {
+    p_packet[0] = (uint8_t)value;
+    p_packet[1] = (uint8_t)(value >> 8);
+}
+
+// Function PutLong: Stores a 32-bit value little-endian
+static void PutLong(uint8_t *p_packet, uint32_t value) {
+    PutWord(&p_packet[0], (uint16_t)value);
+    PutWord(&p_packet[2], (uint16_t)(value >> 16));
+}
+
+// Function CobsEncode: Encodes a block with Consistent Overhead Byte Stuffing (no 0x00 in the output, up to 254 bytes), returns the encoded length
+uint8_t CobsEncode(const uint8_t *p_source, uint8_t length, uint8_t *p_destination) {
+    uint8_t code_ix = 0;  // Position of the current code byte
+    uint8_t code = 1;     // Distance to the next zero
+    uint8_t out_ix = 1;
+    for (uint8_t i = 0; i < length; i++) {
+        if (p_source[i] == 0) {
+            p_destination[code_ix] = code;
+            code_ix = out_ix++;
+            code = 1;
+        } else {
+            p_destination[out_ix++] = p_source[i];
+            code++;
+        }
+    }
+    p_destination[code_ix] = code;
+    return out_ix;
+}
+
+// Function SendTelemetry: Sends a COBS-framed, CRC-checked packet with the system status
+void SendTelemetry(SysInfo *p_system) {
+    uint8_t packet[TELEMETRY_PACKET_LENGTH];
+    uint8_t frame[TELEMETRY_FRAME_LENGTH];
+    const BurnerStats *p_stats = GetBurnerStats();
+
+    packet[0] = TELEMETRY_VERSION;
+    packet[1] = telemetry_sequence++;
+    PutLong(&packet[2], GetMilliseconds());
+    packet[6] = p_system->system_state;
+    packet[7] = p_system->inner_step;
+    packet[8] = p_system->input_flags;
+    packet[9] = p_system->output_flags;
+    PutWord(&packet[10], p_system->dhw_temperature);
+    PutWord(&packet[12], p_system->ch_temperature);
+    PutWord(&packet[14], p_system->dhw_setting);
+    PutWord(&packet[16], p_system->ch_setting);
+    PutWord(&packet[18], p_system->system_mode);
+    packet[20] = p_system->current_heat_level;
+    packet[21] = p_system->current_valve;
+    packet[22] = p_system->error;
+    packet[23] = p_system->ignition_tries;
+    PutLong(&packet[24], p_stats->flame_seconds);
+    PutLong(&packet[28], p_stats->kcal);
+    PutLong(&packet[32], p_stats->gas_litres);
+    PutLong(&packet[36], p_stats->ignitions);
+    PutWord(&packet[40], p_stats->ignition_failures);
+    PutWord(&packet[42], p_stats->short_cycles);
+#if LOOP_PROFILER
+    PutWord(&packet[44], GetProfileTime(PROFILE_PASS, PROFILE_MIN));
+    PutWord(&packet[46], GetProfileTime(PROFILE_PASS, PROFILE_AVG));
+    PutWord(&packet[48], GetProfileTime(PROFILE_PASS, PROFILE_MAX));
+    for (uint8_t bucket = 0; bucket < PROFILER_BUCKETS; bucket++) {
+        PutWord(&packet[50 + (bucket * 2)], GetProfileBucket(bucket));
+    }
+#else
+    for (uint8_t i = 44; i < TELEMETRY_DATA_LENGTH; i++) {
+        packet[i] = 0;
+    }
+#endif  // LOOP_PROFILER
+
+    uint16_t crc = TELEMETRY_CRC_INIT;
+    for (uint8_t i = 0; i < TELEMETRY_DATA_LENGTH; i++) {
+        crc = _crc_xmodem_update(crc, packet[i]);
+    }
+    PutWord(&packet[TELEMETRY_DATA_LENGTH], crc);
+
+    uint8_t frame_length = CobsEncode(packet, TELEMETRY_PACKET_LENGTH, frame);
+    frame[frame_length++] = 0;  // Frame delimiter
+    for (uint8_t i = 0; i < frame_length; i++) {
+        SerialTxChr(frame[i]);
+    }
+}
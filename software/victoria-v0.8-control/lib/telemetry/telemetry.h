@@ -0,0 +1,57 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: telemetry.h (binary telemetry headers)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <avr/io.h>
+#include <burner-stats.h>
+#include <profiler.h>
+#include <serial-ui.h>
+#include <timers.h>
+#include <util/crc16.h>
+
+#include "../../include/sys-settings.h"
+
+#if (SERIAL_TELEMETRY && SHOW_DASHBOARD)
+#error "SERIAL_TELEMETRY and SHOW_DASHBOARD share the serial port, enable only one of them"
+#endif
+
+#if (PROFILER_BUCKETS != 8)
+#error "The telemetry packet layout carries 8 pass time histogram buckets"
+#endif
+
+#define TELEMETRY_VERSION 3                                   // Packet layout version, first packet byte
+#define TELEMETRY_CRC_INIT 0xFFFF                             // CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+#define TELEMETRY_DATA_LENGTH 66                              // Packet bytes covered by the CRC
+#define TELEMETRY_PACKET_LENGTH (TELEMETRY_DATA_LENGTH + 2)  // Packet bytes plus the CRC
+#define TELEMETRY_FRAME_LENGTH (TELEMETRY_PACKET_LENGTH + 2)  // COBS overhead byte plus the 0x00 frame delimiter
+
+// Telemetry packet layout (multi-byte fields little-endian)
+// ..........................................................................
+//  0: version         1: sequence         2-5: uptime (ms)
+//  6: system_state    7: inner_step       8: input_flags    9: output_flags
+// 10-11: dhw_temperature ADC    12-13: ch_temperature ADC
+// 14-15: dhw_setting ADC        16-17: ch_setting ADC    18-19: system_mode ADC
+// 20: current_heat_level   21: current_valve   22: error   23: ignition_tries
+// 24-27: flame_seconds   28-31: kcal   32-35: gas_litres   36-39: ignitions
+// 40-41: ignition_failures      42-43: short_cycles
+// 44-45: pass min (us)   46-47: pass avg (us)   48-49: pass max (us)   (LOOP_PROFILER, 0 otherwise)
+// 50-65: pass time histogram, PROFILER_BUCKETS counts of 2 bytes
+// 66-67: CRC-16/CCITT-FALSE of bytes 0-65
+// ..........................................................................
+
+// Prototypes
+
+uint8_t CobsEncode(const uint8_t *p_source, uint8_t length, uint8_t *p_destination);
+void SendTelemetry(SysInfo *p_system);
+
+#endif  // TELEMETRY_H
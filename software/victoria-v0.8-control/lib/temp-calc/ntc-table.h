@@ -0,0 +1,91 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: ntc-table.h (NTC ADC-to-temperature lookup table)
+ *  ........................................................
+ *  GENERATED BY tools/ntc-table-gen.py - DO NOT EDIT
+ *  ........................................................
+ */
+
+#ifndef NTC_TABLE_H
+#define NTC_TABLE_H
+
+#include <avr/io.h>
+
+// NTC parameters used to build the table
+#define NTC_BETA 3950      // Beta coefficient (K)
+#define NTC_R25 10200      // Resistance at 25 C (ohm)
+#define NTC_SERIES 10000  // Divider series resistor (ohm)
+
+#define NTC_TABLE_LEN 1024  // One entry per ADC code
+
+// ADC code -> temperature (tenths of a degree Celsius), INVALID_TEMP_D out of [-20.0, 90.0] C
+static const int16_t __flash ntc_temp_table[NTC_TABLE_LEN] = {
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 0-15
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 16-31
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 32-47
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 48-63
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 64-79
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, 898, 894, 890, 886, 882, 878, 874,  // 80-95
+    871, 867, 863, 860, 856, 852, 849, 845, 842, 838, 835, 832, 828, 825, 822, 819,  // 96-111
+    815, 812, 809, 806, 803, 800, 797, 794, 791, 788, 785, 782, 779, 776, 774, 771,  // 112-127
+    768, 765, 763, 760, 757, 755, 752, 749, 747, 744, 742, 739, 736, 734, 732, 729,  // 128-143
+    727, 724, 722, 719, 717, 715, 712, 710, 708, 705, 703, 701, 699, 696, 694, 692,  // 144-159
+    690, 687, 685, 683, 681, 679, 677, 675, 673, 670, 668, 666, 664, 662, 660, 658,  // 160-175
+    656, 654, 652, 650, 648, 646, 645, 643, 641, 639, 637, 635, 633, 631, 629, 628,  // 176-191
+    626, 624, 622, 620, 619, 617, 615, 613, 611, 610, 608, 606, 605, 603, 601, 599,  // 192-207
+    598, 596, 594, 593, 591, 589, 588, 586, 584, 583, 581, 580, 578, 576, 575, 573,  // 208-223
+    572, 570, 568, 567, 565, 564, 562, 561, 559, 558, 556, 555, 553, 552, 550, 549,  // 224-239
+    547, 546, 544, 543, 541, 540, 538, 537, 536, 534, 533, 531, 530, 528, 527, 526,  // 240-255
+    524, 523, 521, 520, 519, 517, 516, 515, 513, 512, 510, 509, 508, 506, 505, 504,  // 256-271
+    502, 501, 500, 499, 497, 496, 495, 493, 492, 491, 489, 488, 487, 486, 484, 483,  // 272-287
+    482, 481, 479, 478, 477, 476, 474, 473, 472, 471, 469, 468, 467, 466, 464, 463,  // 288-303
+    462, 461, 460, 458, 457, 456, 455, 454, 452, 451, 450, 449, 448, 447, 445, 444,  // 304-319
+    443, 442, 441, 440, 439, 437, 436, 435, 434, 433, 432, 431, 429, 428, 427, 426,  // 320-335
+    425, 424, 423, 422, 420, 419, 418, 417, 416, 415, 414, 413, 412, 411, 410, 408,  // 336-351
+    407, 406, 405, 404, 403, 402, 401, 400, 399, 398, 397, 396, 395, 394, 392, 391,  // 352-367
+    390, 389, 388, 387, 386, 385, 384, 383, 382, 381, 380, 379, 378, 377, 376, 375,  // 368-383
+    374, 373, 372, 371, 370, 369, 368, 367, 366, 365, 364, 363, 362, 361, 360, 359,  // 384-399
+    358, 357, 356, 355, 354, 353, 352, 351, 350, 349, 348, 347, 346, 345, 344, 343,  // 400-415
+    342, 341, 340, 339, 338, 337, 336, 335, 334, 334, 333, 332, 331, 330, 329, 328,  // 416-431
+    327, 326, 325, 324, 323, 322, 321, 320, 319, 318, 317, 316, 316, 315, 314, 313,  // 432-447
+    312, 311, 310, 309, 308, 307, 306, 305, 304, 303, 303, 302, 301, 300, 299, 298,  // 448-463
+    297, 296, 295, 294, 293, 293, 292, 291, 290, 289, 288, 287, 286, 285, 284, 283,  // 464-479
+    283, 282, 281, 280, 279, 278, 277, 276, 275, 274, 274, 273, 272, 271, 270, 269,  // 480-495
+    268, 267, 266, 266, 265, 264, 263, 262, 261, 260, 259, 258, 258, 257, 256, 255,  // 496-511
+    254, 253, 252, 251, 251, 250, 249, 248, 247, 246, 245, 244, 243, 243, 242, 241,  // 512-527
+    240, 239, 238, 237, 236, 236, 235, 234, 233, 232, 231, 230, 230, 229, 228, 227,  // 528-543
+    226, 225, 224, 223, 223, 222, 221, 220, 219, 218, 217, 217, 216, 215, 214, 213,  // 544-559
+    212, 211, 210, 210, 209, 208, 207, 206, 205, 204, 204, 203, 202, 201, 200, 199,  // 560-575
+    198, 198, 197, 196, 195, 194, 193, 192, 191, 191, 190, 189, 188, 187, 186, 185,  // 576-591
+    185, 184, 183, 182, 181, 180, 179, 179, 178, 177, 176, 175, 174, 173, 172, 172,  // 592-607
+    171, 170, 169, 168, 167, 166, 166, 165, 164, 163, 162, 161, 160, 160, 159, 158,  // 608-623
+    157, 156, 155, 154, 153, 153, 152, 151, 150, 149, 148, 147, 146, 146, 145, 144,  // 624-639
+    143, 142, 141, 140, 140, 139, 138, 137, 136, 135, 134, 133, 133, 132, 131, 130,  // 640-655
+    129, 128, 127, 126, 125, 125, 124, 123, 122, 121, 120, 119, 118, 118, 117, 116,  // 656-671
+    115, 114, 113, 112, 111, 110, 110, 109, 108, 107, 106, 105, 104, 103, 102, 101,  // 672-687
+    101, 100, 99, 98, 97, 96, 95, 94, 93, 92, 92, 91, 90, 89, 88, 87,  // 688-703
+    86, 85, 84, 83, 82, 81, 81, 80, 79, 78, 77, 76, 75, 74, 73, 72,  // 704-719
+    71, 70, 69, 68, 68, 67, 66, 65, 64, 63, 62, 61, 60, 59, 58, 57,  // 720-735
+    56, 55, 54, 53, 52, 51, 50, 50, 49, 48, 47, 46, 45, 44, 43, 42,  // 736-751
+    41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26,  // 752-767
+    25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10,  // 768-783
+    9, 8, 7, 6, 5, 3, 2, 1, 0, -1, -2, -3, -4, -5, -6, -7,  // 784-799
+    -8, -9, -10, -11, -13, -14, -15, -16, -17, -18, -19, -20, -21, -22, -24, -25,  // 800-815
+    -26, -27, -28, -29, -30, -31, -33, -34, -35, -36, -37, -38, -39, -41, -42, -43,  // 816-831
+    -44, -45, -46, -48, -49, -50, -51, -52, -54, -55, -56, -57, -58, -60, -61, -62,  // 832-847
+    -63, -65, -66, -67, -68, -70, -71, -72, -73, -75, -76, -77, -79, -80, -81, -82,  // 848-863
+    -84, -85, -86, -88, -89, -90, -92, -93, -95, -96, -97, -99, -100, -101, -103, -104,  // 864-879
+    -106, -107, -108, -110, -111, -113, -114, -116, -117, -119, -120, -122, -123, -125, -126, -128,  // 880-895
+    -129, -131, -132, -134, -135, -137, -139, -140, -142, -143, -145, -147, -148, -150, -152, -153,  // 896-911
+    -155, -157, -158, -160, -162, -164, -165, -167, -169, -171, -172, -174, -176, -178, -180, -182,  // 912-927
+    -184, -186, -187, -189, -191, -193, -195, -197, -199, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 928-943
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 944-959
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 960-975
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 976-991
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D,  // 992-1007
+    INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D, INVALID_TEMP_D  // 1008-1023
+};
+
+#endif  // NTC_TABLE_H
@@ -10,63 +10,60 @@
  */
 
 #include "temp-calc.h"
+#include "ntc-table.h"
 
-// Function FIR filter
+// Function FIR filter: Filters FIR_LEN readouts from buffer_position on, using 16-bit products and a shift
 uint16_t FilterFir(uint16_t adc_buffer[], uint8_t buffer_length, uint8_t buffer_position) {
-    unsigned long int aux = 0;
-    uint16_t result;
+    uint32_t aux = 0;
     for (uint8_t i = 0; i < FIR_LEN; i++) {
-        aux += (unsigned long)(adc_buffer[buffer_position++]) * (unsigned long)(fir_table[i]);
+        aux += (uint16_t)(adc_buffer[buffer_position++] * fir_table[i]);
         if (buffer_position == buffer_length) {
             buffer_position = 0;
         }
     }
-    result = ((unsigned long int)(aux)) / ((unsigned long int)(FIR_SUM));
-    return result;
+    return (uint16_t)(aux >> FIR_SHIFT);
 }
 
-// Function IIR filter
-uint16_t FilterIir(uint16_t adc_value) {
-    static uint16_t Y;
-    Y = (64 - IR_VAL) * adc_value + IR_VAL * Y;
-    Y = (Y >> 6);
-    return Y;
+// Function IIR filter: First-order low-pass filter, the caller keeps the filter state for each input
+uint16_t FilterIir(uint16_t *p_iir_value, uint16_t adc_value) {
+    *p_iir_value = (uint16_t)((64 - IR_VAL) * adc_value + IR_VAL * (*p_iir_value)) >> 6;
+    return *p_iir_value;
 }
 
-// Function CalculateNtcTemperature
+// Function FilterMedian: Returns the median of the MEDIAN_LEN readouts preceding buffer_position
+uint16_t FilterMedian(uint16_t adc_buffer[], uint8_t buffer_length, uint8_t buffer_position) {
+    uint16_t window[MEDIAN_LEN];
+    for (uint8_t i = 0; i < MEDIAN_LEN; i++) {
+        buffer_position = (buffer_position == 0) ? (buffer_length - 1) : (buffer_position - 1);
+        // Insertion sort while copying
+        uint8_t j = i;
+        while ((j > 0) && (window[j - 1] > adc_buffer[buffer_position])) {
+            window[j] = window[j - 1];
+            j--;
+        }
+        window[j] = adc_buffer[buffer_position];
+    }
+    return window[MEDIAN_LEN / 2];
+}
+
+// Function GetNtcTemperature: Converts an NTC ADC readout to tenths of a degree in the scale given by offset and delta
 int GetNtcTemperature(uint16_t ntc_adc_value, int temp_offset, int temp_delta) {
-    int aux;
-    uint16_t min, max;
-    uint8_t i;
-    // Search the table interval where the ADC value is located
-    for (i = 0; (i < NTC_VALUES) && (ntc_adc_value < (ntc_adc_table[i])); i++)
-        ;
-    if ((i == 0) || (i == NTC_VALUES)) {  // If there is not located, return an error
+    int aux = ntc_temp_table[ntc_adc_value & (NTC_TABLE_LEN - 1)];
+    if (aux == INVALID_TEMP_D) {  // Readout out of the table range
         return INVALID_TEMP_D;
     }
-    max = ntc_adc_table[i - 1];                 //Buscamos el valor más alto del intervalo
-    min = ntc_adc_table[i];                     //y el más bajoa
-    aux = (max - ntc_adc_value) * temp_delta;   //hacemos el primer paso de la interpolación
-    aux = aux / (max - min);                    //y el segundo paso
-    aux += (i - 1) * temp_delta + temp_offset;  //y añadimos el offset del resultado
-    return aux;
+    if ((temp_offset == TO_CELSIUS) && (temp_delta == DT_CELSIUS)) {
+        return aux;
+    }
+    // Other scales: the offset is the table's -20 °C point and the delta spans 10 °C
+    return temp_offset + (int)(((int32_t)(aux - TO_CELSIUS) * temp_delta) / DT_CELSIUS);
 }
 
-// Function GetNtctempDegrees
+// Function GetNtcTempDegrees: Converts an NTC ADC readout to degrees in the scale given by offset and delta
 float GetNtcTempDegrees(uint16_t ntc_adc_value, int temp_offset, int temp_delta) {
-    int aux;
-    uint16_t min, max;
-    uint8_t i;
-    // Search the table interval where the ADC value is located
-    for (i = 0; (i < NTC_VALUES) && (ntc_adc_value < (ntc_adc_table[i])); i++)
-        ;
-    if ((i == 0) || (i == NTC_VALUES)) {  // If there is not located, return an error
+    int aux = GetNtcTemperature(ntc_adc_value, temp_offset, temp_delta);
+    if (aux == INVALID_TEMP_D) {
         return INVALID_TEMP_F;
     }
-    max = ntc_adc_table[i - 1];                 //Buscamos el valor más alto del intervalo
-    min = ntc_adc_table[i];                     //y el más bajoa
-    aux = (max - ntc_adc_value) * temp_delta;   //hacemos el primer paso de la interpolación
-    aux = aux / (max - min);                    //y el segundo paso
-    aux += (i - 1) * temp_delta + temp_offset;  //y añadimos el offset del resultado
     return ((float)aux / 10);
 }
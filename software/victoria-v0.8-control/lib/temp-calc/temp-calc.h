@@ -14,7 +14,12 @@
 
 #include <avr/io.h>
 
-#define BUFFER_LENGTH 34 /* Circular buffers length */
+#define BUFFER_LENGTH 32 /* Circular buffers length (power of two) */
+#define BUFFER_SHIFT 5   /* log2(BUFFER_LENGTH): running-sum average divisor as a shift */
+
+#if ((1 << BUFFER_SHIFT) != BUFFER_LENGTH)
+#error "BUFFER_LENGTH must be equal to 2^BUFFER_SHIFT"
+#endif
 
 #define CH_TEMP_MASK 0x3FE
 
@@ -22,12 +27,14 @@
 #define INVALID_TEMP_F -32767.0
 
 // Filter settings
-#define FIR_SUM 11872
+#define FIR_SHIFT 9  /* FIR coefficients add up to 2^FIR_SHIFT (512) */
 #define IR_VAL 50
-#define FIR_LEN 31
+#define FIR_LEN 25
+#define MEDIAN_LEN 5 /* Median filter window (latest readouts) */
 
-// Number of NTC ADC values used for calculating temperature
-#define NTC_VALUES 12
+#if ((FIR_LEN > BUFFER_LENGTH) || (MEDIAN_LEN > BUFFER_LENGTH))
+#error "FIR_LEN and MEDIAN_LEN must not exceed BUFFER_LENGTH"
+#endif
 
 // Temperature calculation settings
 #define TO_CELSIUS -200   /* Celsius offset value */
@@ -39,20 +46,19 @@
 
 // Prototypes
 uint16_t FilterFir(uint16_t adc_buffer[], uint8_t buffer_length, uint8_t buffer_position);
-uint16_t FilterIir(uint16_t adc_value);
+uint16_t FilterIir(uint16_t *p_iir_value, uint16_t adc_value);
+uint16_t FilterMedian(uint16_t adc_buffer[], uint8_t buffer_length, uint8_t buffer_position);
 int GetNtcTemperature(uint16_t ntc_adc_value, int temp_offset, int temp_delta);
 float GetNtcTempDegrees(uint16_t ntc_adc_value, int temp_offset, int temp_delta);
 
-// Temperature to ADC readings conversion table
+// NTC ADC-to-temperature table: generated into ntc-table.h by tools/ntc-table-gen.py
 //  T°C:  -20, -10,   0,  10,  20,  30,  40,  50,  60,  70,  80, 90
 //  ADC:  929, 869, 787, 685, 573, 461, 359, 274, 206, 154, 116, 87
-//  NTC: 98.66, 56.25, 33.21, 20.24, 12.71, 8.19, 5.42, 3.66, 2.53, 1.78, 1.28, 0.93
-static const uint16_t __flash ntc_adc_table[NTC_VALUES] = {
-    929, 869, 787, 685, 573, 461, 359, 274, 206, 154, 116, 87};
-
-// FIR filter value table
-static const uint16_t __flash fir_table[FIR_LEN] = {
-    1, 3, 9, 23, 48, 89, 149, 230, 333, 454, 586, 719, 840, 938, 1002, 1024,
-    1002, 938, 840, 719, 586, 454, 333, 230, 149, 89, 48, 23, 9, 3, 1};
+
+// FIR filter value table (the former 31-tap window scaled to a 512 sum, zero taps dropped)
+// NOTE: A 10-bit ADC readout times the largest coefficient (44) fits in 16 bits
+static const uint8_t __flash fir_table[FIR_LEN] = {
+    1, 2, 4, 7, 10, 14, 20, 25, 31, 36, 41, 43, 44,
+    43, 41, 36, 31, 25, 20, 14, 10, 7, 4, 2, 1};
 
 #endif  // TEMP_CALC_H
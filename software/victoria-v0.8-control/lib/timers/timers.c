@@ -11,161 +11,188 @@
 
 #include "timers.h"
 
-// Function SetTimer
-bool SetTimer(TimerId timer_id, TimerLapse time_lapse, TimerMode timer_mode) {
-    // Disable interrupts ...
-    // cli();
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {       // loop through and check for free spot, then place timer in there...
-        if (timer_buffer[i].timer_id == TIMER_EMPTY) {  // place new timer here...
-            timer_buffer[i].timer_id = timer_id;
-            timer_buffer[i].timer_start_time = GetMilliseconds();
-            timer_buffer[i].timer_time_lapse = time_lapse;
-            timer_buffer[i].timer_mode = timer_mode;
-            return true;
-        }
+// System timers, one slot per timer id (slot = timer_id - 1)
+static SystemTimer timer_buffer[SYSTEM_TIMERS];
+static TimerId timer_queue_head = TIMER_EMPTY;  // Timer with the nearest deadline
+static uint32_t timers_now = 0;                 // Time snapshot taken once per main loop pass by UpdateTimers
+
+// Function GetTimer: Returns the slot of a timer id, NULL if the id is out of range
+static SystemTimer *GetTimer(TimerId timer_id) {
+    if ((timer_id == TIMER_EMPTY) || (timer_id > SYSTEM_TIMERS)) {
+        return NULL;
     }
-#if TIMER_INDEX_OVF_STOP
-    // If by this point the function didn't set a system timer and returned, indicate not enough slots!
-    VALVE_S_PORT &= ~(1 << VALVE_S_PIN);  // Set security valve pin low (inactive)
-    for (;;) {
-        for (int i = 0; i < 3; i++) {
-            LED_UI_PORT ^= (1 << LED_UI_PIN);
-            _delay_ms(125);  // Blocking delay
-            while (!(UCSR0A & (1 << UDRE0))) {
-            };
-            UDR0 = 84;  // "T"
-        }
-        while (!(UCSR0A & (1 << UDRE0))) {
-        };
-        UDR0 = 32;  // "SPACE"
-        _delay_ms(250);
+    return &timer_buffer[timer_id - 1];
+}
+
+// Function TimerExpired: Overflow-safe check of a deadline against the time snapshot
+static bool TimerExpired(SystemTimer *p_timer) {
+    return ((int32_t)(timers_now - p_timer->timer_deadline) >= 0);
+}
+
+// Function DequeueTimer: Removes a timer from the deadline queue
+static void DequeueTimer(SystemTimer *p_timer) {
+    if (!p_timer->queued) {
+        return;
     }
-#endif
-    // Enable interrupts ...
-    // sei();
-    return false;
+    TimerId *p_link = &timer_queue_head;
+    while (*p_link != p_timer->timer_id) {
+        p_link = &timer_buffer[*p_link - 1].next_id;
+    }
+    *p_link = p_timer->next_id;
+    p_timer->next_id = TIMER_EMPTY;
+    p_timer->queued = false;
 }
 
-// Function TimerRunning
-bool TimerRunning(TimerId timer_id) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            if ((GetMilliseconds() - timer_buffer[i].timer_start_time) >= timer_buffer[i].timer_time_lapse) {
-                return false;
-            }
-        }
+// Function EnqueueTimer: Inserts a timer into the deadline queue, kept sorted by deadline
+static void EnqueueTimer(SystemTimer *p_timer) {
+    DequeueTimer(p_timer);
+    TimerId *p_link = &timer_queue_head;
+    while ((*p_link != TIMER_EMPTY) &&
+           ((int32_t)(timer_buffer[*p_link - 1].timer_deadline - p_timer->timer_deadline) <= 0)) {
+        p_link = &timer_buffer[*p_link - 1].next_id;
+    }
+    p_timer->next_id = *p_link;
+    *p_link = p_timer->timer_id;
+    p_timer->queued = true;
+}
+
+// Function ArmTimer: Starts a timer lapse from the current time
+static void ArmTimer(SystemTimer *p_timer) {
+    p_timer->timer_deadline = GetMilliseconds() + p_timer->timer_time_lapse;
+    EnqueueTimer(p_timer);
+}
+
+// Function SetTimer: Sets (or sets again) the timer of a given id, its slot is always available
+bool SetTimer(TimerId timer_id, TimerLapse time_lapse, TimerMode timer_mode) {
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if (p_timer == NULL) {
+        return false;
     }
+    p_timer->timer_id = timer_id;
+    p_timer->timer_time_lapse = time_lapse;
+    p_timer->timer_mode = timer_mode;
+    ArmTimer(p_timer);
     return true;
 }
 
+// Function TimerRunning
+bool TimerRunning(TimerId timer_id) {
+    return !TimerFinished(timer_id);
+}
+
 // Function TimerFinished
 bool TimerFinished(TimerId timer_id) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            if ((GetMilliseconds() - timer_buffer[i].timer_start_time) >= timer_buffer[i].timer_time_lapse) {
-                return true;
-            }
-        }
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if ((p_timer == NULL) || (p_timer->timer_id == TIMER_EMPTY)) {
+        return false;
     }
-    return false;
+    return TimerExpired(p_timer);
 }
 
 // Function TimerExists
 bool TimerExists(TimerId timer_id) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            return true;
-        }
-    }
-    return false;
+    SystemTimer *p_timer = GetTimer(timer_id);
+    return ((p_timer != NULL) && (p_timer->timer_id != TIMER_EMPTY));
 }
 
 // Function GetTimeLeft
 uint32_t GetTimeLeft(TimerId timer_id) {
-    uint32_t time_left = 0;
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            time_left = timer_buffer[i].timer_start_time + timer_buffer[i].timer_time_lapse - GetMilliseconds();
-            if (time_left > timer_buffer[i].timer_time_lapse) {
-                time_left = 0;
-            }
-        }
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if ((p_timer == NULL) || (p_timer->timer_id == TIMER_EMPTY) || TimerExpired(p_timer)) {
+        return 0;
     }
-    return time_left;
+    return p_timer->timer_deadline - timers_now;
 }
 
 // Function RestartTimer
 uint8_t RestartTimer(TimerId timer_id) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            if (timer_buffer[i].timer_mode == RUN_ONCE_AND_HOLD) {  //&&
-                //(TimerRunning(i) == false)) {
-                timer_buffer[i].timer_start_time = GetMilliseconds();
-                return 0;
-            } else {
-                return 255; /* Error: The timer is empty or its type doesn't allow restarts or is running */
-            }
-        }
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if ((p_timer == NULL) || (p_timer->timer_id == TIMER_EMPTY)) {
+        return 0;
+    }
+    if (p_timer->timer_mode != RUN_ONCE_AND_HOLD) {
+        return 255; /* Error: The timer type doesn't allow restarts */
     }
+    ArmTimer(p_timer);
     return 0;
 }
 
 // Function ResetTimerLapse
 uint8_t ResetTimerLapse(TimerId timer_id, uint32_t time_lapse) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if (timer_buffer[i].timer_id == timer_id) {
-            if (timer_buffer[i].timer_mode == RUN_ONCE_AND_HOLD) {  //&&
-                //(TimerRunning(i) == false)) {
-                timer_buffer[i].timer_start_time = GetMilliseconds();
-                timer_buffer[i].timer_time_lapse = time_lapse;
-                return 0;
-            } else {
-                return 255; /* Error: The timer is empty or its type doesn't allow restarts or is running */
-            }
-        }
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if ((p_timer == NULL) || (p_timer->timer_id == TIMER_EMPTY)) {
+        return 0;
+    }
+    if (p_timer->timer_mode != RUN_ONCE_AND_HOLD) {
+        return 255; /* Error: The timer type doesn't allow restarts */
     }
+    p_timer->timer_time_lapse = time_lapse;
+    ArmTimer(p_timer);
     return 0;
 }
 
-// Function ProcessTimers
+// Function SetTimerCallback: Sets the function to call when a timer finishes (NULL removes it)
+bool SetTimerCallback(TimerId timer_id, TimerCallback callback) {
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if (p_timer == NULL) {
+        return false;
+    }
+    p_timer->callback = callback;
+    return true;
+}
+
+// Function UpdateTimers: Takes the time snapshot used by all timer queries and processes the finished timers
+void UpdateTimers(void) {
+    timers_now = GetMilliseconds();
+    ProcessTimers();
+}
+
+// Function ProcessTimers: Pops the finished timers from the head of the deadline queue
 void ProcessTimers(void) {
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {
-        if ((GetMilliseconds() - timer_buffer[i].timer_start_time >= timer_buffer[i].timer_time_lapse) &&
-            (timer_buffer[i].timer_id != TIMER_EMPTY)) {
-            switch (timer_buffer[i].timer_mode) {
-                case RUN_ONCE_AND_HOLD: {
-                    break;
-                }
-                case RUN_CONTINUOUSLY: {
-                    timer_buffer[i].timer_start_time = GetMilliseconds();
-                    break;
-                }
-                default: { /* RUN_ONCE_AND_DELETE */
-                    timer_buffer[i].timer_id = TIMER_EMPTY;
-                    timer_buffer[i].timer_start_time = 0;
-                    timer_buffer[i].timer_time_lapse = 0;
-                    break;
+    while ((timer_queue_head != TIMER_EMPTY) && TimerExpired(&timer_buffer[timer_queue_head - 1])) {
+        SystemTimer *p_timer = &timer_buffer[timer_queue_head - 1];
+        TimerId timer_id = p_timer->timer_id;
+        DequeueTimer(p_timer);
+        switch (p_timer->timer_mode) {
+            case RUN_ONCE_AND_HOLD: {  // Stays finished until it is restarted
+                break;
+            }
+            case RUN_CONTINUOUSLY: {  // Next period starts at the deadline, so it doesn't drift
+                p_timer->timer_deadline += p_timer->timer_time_lapse;
+                if (TimerExpired(p_timer)) {
+                    p_timer->timer_deadline = timers_now + p_timer->timer_time_lapse;
                 }
+                EnqueueTimer(p_timer);
+                break;
+            }
+            default: { /* RUN_ONCE_AND_DELETE */
+                p_timer->timer_id = TIMER_EMPTY;
+                break;
             }
-            //OnTimer(timer_buffer[i].timer_id);
         }
+#if ENABLE_TIMERS_CALLBACKS
+        TimerCallback callback = p_timer->callback;
+        if (p_timer->timer_id == TIMER_EMPTY) {
+            p_timer->callback = NULL;  // A deleted timer's callback doesn't carry over to the next SetTimer
+        }
+        if (callback != NULL) {
+            callback(timer_id);
+        }
+#endif
     }
 }
 
-// Function DeleteTimers (Deletes all timers of the same type)
+// Function DeleteTimer
 void DeleteTimer(TimerId timer_id) {
-    // Disable interrupts ...
-    // cli();
-    for (uint8_t i = 0; i < SYSTEM_TIMERS; i++) {    // loop through and check for timers of this type, then kill them...
-        if (timer_buffer[i].timer_id == timer_id) {  // kill timers...
-            timer_buffer[i].timer_id = TIMER_EMPTY;
-            timer_buffer[i].timer_start_time = 0;
-            timer_buffer[i].timer_time_lapse = 0;
-            return;
-        }
+    SystemTimer *p_timer = GetTimer(timer_id);
+    if ((p_timer == NULL) || (p_timer->timer_id == TIMER_EMPTY)) {
+        return;
     }
-    // Enable interrupts ...
-    // sei();
+    DequeueTimer(p_timer);
+    p_timer->timer_id = TIMER_EMPTY;
+    p_timer->timer_deadline = 0;
+    p_timer->timer_time_lapse = 0;
+    p_timer->callback = NULL;
 }
 
 // Function SetTickTimer: Sets the Timer0 hardware up
@@ -206,8 +233,4 @@ ISR(TIMER0_OVF_vect) {
     timer0_fractions = f;
     timer0_milliseconds = m;
     //timer0_overflow_cnt++;
-
-#if ENABLE_TIMERS_CALLBACKS
-    ProcessTimers();
-#endif
 }
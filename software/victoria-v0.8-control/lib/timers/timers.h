@@ -35,8 +35,13 @@
 #define FRACT_INC ((MICROSECONDS_PER_TIMER0_OVERFLOW % 1000) >> 3)
 #define FRACT_MAX (1000 >> 3)
 
-#define TIMER_EMPTY 0                  // Timer empty value
-#define ENABLE_TIMERS_CALLBACKS false  // Sets if the ProcessTimers function, which makes the callbacks, will be run by the ISR
+#define TIMER_EMPTY 0                 // Timer empty value (also the end mark of the deadline queue)
+#define ENABLE_TIMERS_CALLBACKS true  // Sets if ProcessTimers runs the expiry callbacks (from UpdateTimers, never from the ISR)
+
+#if ((FSM_TIMER_ID > SYSTEM_TIMERS) || (HEAT_TIMER_ID > SYSTEM_TIMERS) || (PUMP_TIMER_ID > SYSTEM_TIMERS) || \
+     (GAS_OFF_TIMER_ID > SYSTEM_TIMERS) || (ERROR_TIMER_ID > SYSTEM_TIMERS))
+#error "Timer ids must be in the 1 to SYSTEM_TIMERS range"
+#endif
 
 // Types
 
@@ -46,16 +51,20 @@ typedef enum timer_mode {
     RUN_CONTINUOUSLY = 2  // Use this mode for call-back functions only!
 } TimerMode;
 
+typedef uint8_t TimerId;
+typedef uint32_t TimerLapse;
+typedef void (*TimerCallback)(TimerId timer_id);
+
 typedef struct timer {
-    uint8_t timer_id;
-    uint32_t timer_start_time;
+    TimerId timer_id;          // Timer id, TIMER_EMPTY when the slot is free
+    uint32_t timer_deadline;   // Time (milliseconds) when the timer finishes
     uint32_t timer_time_lapse;
     TimerMode timer_mode;
+    TimerCallback callback;    // Function called when the timer finishes, NULL for none
+    TimerId next_id;           // Next timer in the deadline queue, TIMER_EMPTY at its end
+    bool queued;               // The timer is waiting in the deadline queue
 } SystemTimer;
 
-typedef uint8_t TimerId;
-typedef uint32_t TimerLapse;
-
 // Prototypes
 
 bool SetTimer(TimerId timer_id, TimerLapse time_lapse, TimerMode timer_mode);
@@ -65,12 +74,12 @@ bool TimerExists(TimerId timer_id);
 uint32_t GetTimeLeft(TimerId timer_id);
 uint8_t RestartTimer(TimerId timer_id);
 uint8_t ResetTimerLapse(TimerId timer_id, uint32_t time_lapse);
+bool SetTimerCallback(TimerId timer_id, TimerCallback callback);
+void UpdateTimers(void);
 void ProcessTimers(void);
 void DeleteTimer(TimerId timer_id);
 void SetTickTimer(void);
 uint32_t GetMilliseconds(void);
-//void OnTimer(uint8_t);
-//void OnTimer(SysInfo, uint8_t);
 
 // Globals
 
@@ -79,7 +88,4 @@ volatile static uint32_t timer0_milliseconds = 0;  // Range: 0 - 4294967295 mill
 volatile static uint8_t timer0_fractions = 0;      // Range 0 - 255
 //volatile static unsigned long timer0_overflow_cnt = 0; // Range 0 - 4294967295
 
-// System Timers globals
-SystemTimer timer_buffer[SYSTEM_TIMERS];
-
 #endif  // SYS_TIMERS_H
@@ -19,7 +19,8 @@ int main(void) {
       |___________________|
     */
 
-    // Disable watch dog timer
+    // Disable watch dog timer, keeping the reset cause for the event log
+    uint8_t reset_cause = MCUSR;
     MCUSR = 0;
     wdt_disable();
 
@@ -28,9 +29,9 @@ int main(void) {
 
     // System gas modulator
     HeatModulator gas_modulator[] = {
-        {VALVE_1, VALVE_1_F, 7000, 0.87, false},
-        {VALVE_2, VALVE_2_F, 12000, 1.46, false},
-        {VALVE_3, VALVE_3_F, 20000, 2.39, false}};
+        {VALVE_1, VALVE_1_F, VALVE_1_KCAL_H, VALVE_1_GAS_LH, false},
+        {VALVE_2, VALVE_2_F, VALVE_2_KCAL_H, VALVE_2_GAS_LH, false},
+        {VALVE_3, VALVE_3_F, VALVE_3_KCAL_H, VALVE_3_GAS_LH, false}};
 
     //System state initialization
     SysInfo sys_info;
@@ -43,6 +44,8 @@ int main(void) {
     p_system->last_displayed_iflags = 0;
     p_system->last_displayed_oflags = 0;
     p_system->error = ERROR_000;
+    p_system->error_retries = 0;
+    p_system->locked_out = false;
     p_system->ignition_tries = 1;
     p_system->ch_on_duty_step = CH_ON_DUTY_1;
     p_system->cycle_in_progress = 0;
@@ -94,9 +97,27 @@ int main(void) {
     // Pre-load analog sensor values
     for (uint8_t i = 0; i < BUFFER_LENGTH; i++) {
         for (AnalogInput analog_sensor = DHW_SETTING; analog_sensor <= CH_TEMPERATURE; analog_sensor++) {
-            CheckAnalogSensor(p_system, p_buffer_pack, analog_sensor, false);
+            PreloadAnalogSensor(p_buffer_pack, analog_sensor);
         }
     }
+    for (AnalogInput analog_sensor = DHW_SETTING; analog_sensor <= CH_TEMPERATURE; analog_sensor++) {
+        CheckAnalogSensor(p_system, p_buffer_pack, analog_sensor, false);
+    }
+
+    // Load the runtime tuning parameters
+    InitParams();
+
+    // Log the system start with its reset cause
+    InitEventLog(p_system, reset_cause);
+#if (EVENT_LOG_DUMP_AT_START && !(SERIAL_TELEMETRY))
+    SendEventLog();
+#endif  // EVENT_LOG_DUMP_AT_START && !SERIAL_TELEMETRY
+
+    // Load the burner runtime statistics
+    InitBurnerStats();
+#if (STATS_DUMP_AT_START && !(SERIAL_TELEMETRY))
+    SendBurnerStats();
+#endif  // STATS_DUMP_AT_START && !SERIAL_TELEMETRY
 
 #if SHOW_DASHBOARD
     // Show system dashboard
@@ -121,732 +142,221 @@ int main(void) {
     // Enable global interrupts
     sei();
     SetTickTimer();
+
+    // Start the interrupt-driven ADC sampling, paced by the system tick
+    StartAdcEngine(p_buffer_pack);
+
+    // Start the interrupt-driven digital input debouncing, paced by the system tick
+    StartDebounceEngine();
+
+#if SAFETY_FAST_PATH
+    // Start the interrupt-driven security valve shutdown on flame loss and overheat
+    StartSafetyPath();
+#endif  // SAFETY_FAST_PATH
+
+#if LOOP_PROFILER
+    // Start the Timer1 cycle counter that measures the task loop
+    StartProfiler();
+#endif  // LOOP_PROFILER
+
+    // Set system tasks (run in id order when due)
+    TaskData task_data = {p_system, p_buffer_pack};
+    AddTask(SENSORS_TASK_ID, SensorsTask, &task_data, SENSORS_TASK_PERIOD);  // Sensor sampling and safety checks
+    AddTask(FSM_TASK_ID, FsmTask, &task_data, FSM_TASK_PERIOD);              // Finite state machine step
+    AddTask(HEAT_TASK_ID, HeatTask, &task_data, HEAT_TASK_PERIOD);           // Heat modulator
+#if SHOW_DASHBOARD
+    AddTask(DASHBOARD_TASK_ID, DashboardTask, &task_data, DASHBOARD_TASK_PERIOD);  // Serial dashboard
+#endif  // SHOW_DASHBOARD
+    AddTask(WATCHDOG_TASK_ID, WatchdogTask, &task_data, WATCHDOG_TASK_PERIOD);  // Watchdog service
+#if SERIAL_TELEMETRY
+    AddTask(TELEMETRY_TASK_ID, TelemetryTask, &task_data, TELEMETRY_TASK_PERIOD);  // Binary telemetry
+#endif  // SERIAL_TELEMETRY
+#if SERIAL_SHELL
+    AddTask(SHELL_TASK_ID, ShellTask, &task_data, SHELL_TASK_PERIOD);  // Serial command shell
+#endif  // SERIAL_SHELL
     /* ___________________
       |                   | 
       |     Main Loop     |
       |___________________|
     */
     for (;;) {
-        // Reset the WDT
-        wdt_reset();
+        // Run the due tasks, then sleep until the next system tick
+        RunTasks();
+    } /* Main loop end */
 
-        // Update digital input sensors status
-        for (InputFlag digital_sensor = DHW_REQUEST_F; digital_sensor <= OVERHEAT_F; digital_sensor++) {
-            CheckDigitalSensor(p_system, digital_sensor, false);
-        }
+    return 0;
+}
 
-        // Update analog input sensors status
-        for (AnalogInput analog_sensor = DHW_SETTING; analog_sensor <= CH_TEMPERATURE; analog_sensor++) {
-            CheckAnalogSensor(p_system, p_buffer_pack, analog_sensor, false);
-        }
+// Function SensorsTask: Updates the sensor readouts and runs the safety checks that don't depend on the FSM state
+void SensorsTask(void *p_data) {
+    SysInfo *p_system = ((TaskData *)p_data)->p_system;
+    AdcBuffers *p_buffer_pack = ((TaskData *)p_data)->p_buffer_pack;
 
-        // If the CH water pump is on, check if its timer is finished to turn it off
-        if (TimerFinished(PUMP_TIMER_ID)) {
-            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F)) {
-                ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-            }
-        }
+    // Update digital input sensors status from the debounce engine
+    CheckDigitalSensors(p_system, false);
 
-        // DHW temperature sensor out of range -> Error 008
-        if ((p_system->dhw_temperature <= ADC_MIN_THRESHOLD) || (p_system->dhw_temperature >= ADC_MAX_THRESHOLD)) {
-            GasOff(p_system);
-            p_system->error = ERROR_008;
-            p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+#if SAFETY_FAST_PATH
+    // Security valve closed from interrupt context: on a flame loss the FSM retries the ignition, an overheat -> Error 001
+    if (CheckSafetyTrips(p_system) & (1 << OVERHEAT_F)) {
+        p_system->error = ERROR_001;
+        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+    }
+#endif  // SAFETY_FAST_PATH
+
+    // Update analog input sensors status from the ADC engine buffers
+    for (AnalogInput analog_sensor = DHW_SETTING; analog_sensor <= CH_TEMPERATURE; analog_sensor++) {
+        CheckAnalogSensor(p_system, p_buffer_pack, analog_sensor, false);
+    }
+
+    // If the CH water pump is on, check if its timer is finished to turn it off
+    if (TimerFinished(PUMP_TIMER_ID)) {
+        if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F)) {
+            ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
         }
+    }
+
+    // DHW temperature sensor out of range -> Error 008
+    if ((p_system->dhw_temperature <= ADC_MIN_THRESHOLD) || (p_system->dhw_temperature >= ADC_MAX_THRESHOLD)) {
+        GasOff(p_system);
+        p_system->error = ERROR_008;
+        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+    }
 
-        // CH temperature sensor out of range -> Error 009
-        if ((p_system->ch_temperature <= ADC_MIN_THRESHOLD) || (p_system->ch_temperature >= ADC_MAX_THRESHOLD)) {
+    // CH temperature sensor out of range -> Error 009
+    if ((p_system->ch_temperature <= ADC_MIN_THRESHOLD) || (p_system->ch_temperature >= ADC_MAX_THRESHOLD)) {
+        GasOff(p_system);
+        p_system->error = ERROR_009;
+        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+    }
+
+    // Unexpected CH water overtemperature detected -> Error 010
+    if (p_system->ch_temperature < (sys_params.ch_setpoint_high - MAX_CH_TEMP_TOLERANCE)) {
+        if (p_system->system_state == CH_ON_DUTY) {
+            // If the system is running in CH mode, there is a system failure, stop all and indicate error
             GasOff(p_system);
-            p_system->error = ERROR_009;
+            p_system->error = ERROR_010;
             p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-        }
-
-        // Unexpected CH water overtemperature detected -> Error 010
-        if (p_system->ch_temperature < (CH_SETPOINT_HIGH - MAX_CH_TEMP_TOLERANCE)) {
-            if (p_system->system_state == CH_ON_DUTY) {
-                // If the system is running in CH mode, there is a system failure, stop all and indicate error
-                GasOff(p_system);
-                p_system->error = ERROR_010;
-                p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-            } else {
-                // If the system is DHW mode, activate the pump until the CH hot water has flow off the exchanger.
-                // NOTE: While in DWH mode the pump is off, so the water is not recirculating through the CH circuit.
-                // The CH circuit water held inside the heat exchanger gets hot collaterally and can cause the
-                //  bimetallic thermostat to detect overtemperature and disrupting the operation.
-                p_system->ch_water_overheat = true;
-                if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                    SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                }
-            }
         } else {
-            // If the system is DHW mode and the CH water overtemperature is no longer detected, turn the pump off
-            if ((p_system->ch_temperature >= (CH_SETPOINT_HIGH - (MAX_CH_TEMP_TOLERANCE + 10))) && p_system->ch_water_overheat) {
-                if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) && TimerFinished(PUMP_TIMER_ID)) {
-                    ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                }
-                p_system->ch_water_overheat = false;
+            // If the system is DHW mode, activate the pump until the CH hot water has flow off the exchanger.
+            // NOTE: While in DWH mode the pump is off, so the water is not recirculating through the CH circuit.
+            // The CH circuit water held inside the heat exchanger gets hot collaterally and can cause the
+            //  bimetallic thermostat to detect overtemperature and disrupting the operation.
+            p_system->ch_water_overheat = true;
+            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
+                SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
+            }
+        }
+    } else {
+        // If the system is DHW mode and the CH water overtemperature is no longer detected, turn the pump off
+        if ((p_system->ch_temperature >= (sys_params.ch_setpoint_high - (MAX_CH_TEMP_TOLERANCE + 10))) && p_system->ch_water_overheat) {
+            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) && TimerFinished(PUMP_TIMER_ID)) {
+                ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
             }
+            p_system->ch_water_overheat = false;
         }
+    }
 
 #if !(OVERHEAT_OVERRIDE)
-        // Verify that the overheat thermostat is not open, otherwise, there's a failure
-        if (GetFlag(p_system, INPUT_FLAGS, OVERHEAT_F)) {
-            p_system->error = ERROR_001;
-            p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-        }
+    // Verify that the overheat thermostat is not open, otherwise, there's a failure
+    if (GetFlag(p_system, INPUT_FLAGS, OVERHEAT_F)) {
+        p_system->error = ERROR_001;
+        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
+    }
 #endif  // OVERHEAT_OVERRIDE
+}
 
-#if SHOW_DASHBOARD
-        // Display updated status on system dashboard
-        Dashboard(p_system, false);
-#endif  // SHOW_DASHBOARD
+// Mode indication state
+static uint8_t mode_toggles = 0;               // LED_UI toggles shown of the current OFF or RESET indication
+static SystemMode indicated_mode = SYS_COMBI;  // Mode being indicated, SYS_COMBI or SYS_DHW when none is
+
+// Function ModeIndication: Blinks LED_UI and sends a mark on each toggle while in OFF or RESET mode, paced by the FSM timer
+static void ModeIndication(SysInfo *p_system, SystemMode system_mode) {
+    if (system_mode != indicated_mode) {
+        // Mode change: the FSM doesn't use its timer in OFF or RESET mode, the indication takes it over
+        if (mode_toggles & 1) {
+            ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);  // Leave LED_UI as the interrupted indication found it
+        }
+        mode_toggles = 0;
+        indicated_mode = system_mode;
+        if (system_mode >= SYS_OFF) {
+            ResetTimerLapse(FSM_TIMER_ID, 0);
+        }
+    }
+    if ((system_mode < SYS_OFF) || (TimerFinished(FSM_TIMER_ID) == false)) {
+        return;
+    }
+    uint8_t toggles = (system_mode == SYS_OFF) ? OFF_BLINK_TOGGLES : RESET_BLINK_TOGGLES;
+    if (mode_toggles < toggles) {
+        ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
+        SerialTxChr((system_mode == SYS_OFF) ? (char)46 : (char)42);
+        mode_toggles++;
+        ResetTimerLapse(FSM_TIMER_ID, (system_mode == SYS_OFF) ? OFF_BLINK_TIME : RESET_BLINK_TIME);
+    } else {
+        SerialTxChr((char)32);
+        mode_toggles = 0;
+        ResetTimerLapse(FSM_TIMER_ID, MODE_PAUSE_TIME);
+    }
+}
+
+// Function FsmTask: Runs a step of the system finite state machine
+void FsmTask(void *p_data) {
+    SysInfo *p_system = ((TaskData *)p_data)->p_system;
+    SystemMode system_mode = GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS);
+
+    if (system_mode < SYS_OFF) {
+        ModeIndication(p_system, system_mode);  // Ends an OFF or RESET indication in progress
+        RunFsm(p_system);
+    } else { /* If the system is in OFF or RESET mode ... */
+        if (system_mode == SYS_RESET) {
+            // A RESET also releases an error lockout
+            ReleaseLockout(p_system);
+        }
+        ResetFsm(p_system);
+        ModeIndication(p_system, system_mode);
+    } /* Big if end */
+}
+
+// Function HeatTask: Modulates the gas valves while the burner is on duty and updates the burner statistics
+void HeatTask(void *p_data) {
+    SysInfo *p_system = ((TaskData *)p_data)->p_system;
+
+    if (p_system->system_state == DHW_ON_DUTY) {
+        // The heat level is chosen once per heat cycle, before it starts
+        if (p_system->cycle_in_progress == false) {
+            p_system->current_heat_level = GetDhwHeatLevel(p_system);
+        }
+        ModulateHeat(p_system, p_system->current_heat_level, DHW_CYCLE);
+    } else if ((p_system->system_state == CH_ON_DUTY) && (p_system->inner_step == CH_ON_DUTY_1)) {
+        if (p_system->cycle_in_progress == false) {
+            p_system->current_heat_level = GetChHeatLevel(p_system);
+        }
+        ModulateHeat(p_system, p_system->current_heat_level, CH_CYCLE);
+    }
+    UpdateBurnerStats(p_system);
+}
 
-        if (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS) < SYS_OFF) {
-            // System FSM
-            switch (p_system->system_state) {
-                /* _________________________
-                  |                         |
-                  |   System state -> OFF   |
-                  |_________________________|
-                */
-                case OFF: {
-                    // Verify that the flame sensor is off at this point, otherwise, there's a failure
-                    if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
-                        GasOff(p_system);
-                        p_system->error = ERROR_002;
-                        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-                        break;
-                    }
-#if !(AIRFLOW_OVERRIDE)
-                    // If there isn't a fan test in progress, verify that the airflow sensor is off, otherwise, there's a failure
-                    if ((p_system->inner_step < OFF_3) && (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F))) {
-                        ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
-                        p_system->error = ERROR_003;
-                        p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-                        break;
-                    }
-#endif  // AIRFLOW_OVERRIDE
-                    switch (p_system->inner_step) {
-                        // .....................................
-                        // . Step OFF_1 : Turn all devices off  .
-                        // .....................................
-                        case OFF_1: {
-                            // Turn all actuators off, except the CH water pump
-                            GasOff(p_system);
-                            ResetTimerLapse(FSM_TIMER_ID, DLY_OFF_2);
-                            //if (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS) < SYS_OFF) {
-                            p_system->inner_step = OFF_2;
-                            //}
-                            break;
-                        }
-                        // ..................................................
-                        // . Step OFF_2 : Fan test in progress: turn fan on  .
-                        // ..................................................
-                        case OFF_2: {
-#if (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
-                            if (TimerFinished(FSM_TIMER_ID)) {                   // DLY_OFF_2
-                                SetFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);  // Turn exhaust fan on
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_OFF_3);
-                                p_system->inner_step = OFF_3;
-                            }
-#else
-                            p_system->inner_step = OFF_3;
-#endif  // AIRFLOW_OVERRIDE && FAN_TEST_OVERRIDE
-                            break;
-                        }
-                        // .....................................................................
-                        // . Step OFF_3 : Fan test in progress: check airflow sensor activation .
-                        // .....................................................................
-                        case OFF_3: {
-#if (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
-                            // Airflow sensor activated -> fan test successful
-                            if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
-                                ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_OFF_4);
-                                p_system->inner_step = OFF_4;
-                            }
-                            // Timeout: Airflow sensor didn't activate on time -> fan test failed
-                            if (TimerFinished(FSM_TIMER_ID)) {  // DLY_OFF_3
-                                ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
-                                p_system->error = ERROR_004;
-                                p_system->system_state = ERROR;
-                            }
-#else
-                            // Airflow sensor check skipped
-#if SHOW_DASHBOARD
-                            p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-#endif  // SHOW_DASHBOARD
-                            ResetTimerLapse(FSM_TIMER_ID, DLY_OFF_4);
-                            p_system->inner_step = OFF_4;
-#endif  // AIRFLOW_OVERRIDE && FAN_TEST_OVERRIDE
-                            break;
-                        }
-                        // .......................................................................
-                        // . Step OFF_4 : Fan test in progress: check airflow sensor deactivation .
-                        // .......................................................................
-                        case OFF_4: {
-                            if (TimerFinished(FSM_TIMER_ID)) {  // DLY_OFF_4 --- Let the fan to rev down after the test ---
-#if (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
-                                if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
-                                    p_system->error = ERROR_006;
-                                    p_system->system_state = ERROR;
-                                } else {
-#if SHOW_DASHBOARD
-                                    p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-#endif                                                                       // SHOW_DASHBOARD
-                                    ResetTimerLapse(FSM_TIMER_ID, (DLY_READY_1));
-                                    p_system->inner_step = READY_1;
-                                    p_system->system_state = READY;
-                                }
-#else
-#if SHOW_DASHBOARD
-                                p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-#endif  // SHOW_DASHBOARD
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                                p_system->inner_step = READY_1;
-                                p_system->system_state = READY;
-#endif  // AIRFLOW_OVERRIDE && FAN_TEST_OVERRIDE
-                            }
-                            break;
-                        }
-                        // ................
-                        // . OFF : Default .
-                        // ................
-                        default: {
-                            if (p_system->system_state == OFF) {
-                                p_system->inner_step = OFF_1;
-                            }
-                            break;
-                        }
-                    }
-                    break;
-                }
-                /* ___________________________
-                  |                           |
-                  |   System state -> READY   |
-                  |___________________________|
-                */
-                case READY: {
-                    // Give the flame sensor time before checking if it is off when the gas is closed
-                    // Give the airflow sensor time before checking if it switches off when the fan gets turned off
-                    //if (delay < (DLY_READY_1 - DLY_FLAME_OFF)) {
-                    if (TimerFinished(FSM_TIMER_ID)) { /* DLY_READY_1 */
-                        // Verify that the flame sensor is off at this point, otherwise, there's a failure
-                        if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
-                            p_system->error = ERROR_002;
-                            p_system->system_state = ERROR; /* >>>>> Next state -> ERROR */
-                        }
-#if !(AIRFLOW_OVERRIDE)
-                        // Verify that the airflow sensor is off at this point, otherwise, there's a failure
-                        if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
-                            p_system->error = ERROR_003;
-                            p_system->system_state = ERROR; /* >>>>> Next state -> ERROR */
-                        }
-#endif /* AIRFLOW_OVERRIDE */
-                    }
-                    // If the CH water pump is off, but it still has pending running time, turn it on
-                    if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                        if (p_system->pump_timer_memory != 0) {
-                            ResetTimerLapse(PUMP_TIMER_ID, p_system->pump_timer_memory);
-                            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                                SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                            }
-                            p_system->pump_timer_memory = 0;
-                        }
-                    }
-
-                    // Check if there a DHW or CH request. If both are requested, DHW will have higher priority after ignition
-                    if ((GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) || (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F))) {
-#if SHOW_DASHBOARD
-                        p_system->last_displayed_iflags = 0xFF; /* Force a display dashboard refresh */
-#endif                                                          // SHOW_DASHBOARD
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                        p_system->inner_step = IGNITING_1;
-                        p_system->system_state = IGNITING;
-                    }
-                    if (TimerFinished(FSM_TIMER_ID)) { /* DLY_READY_1 */
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-#if SHOW_DASHBOARD
-                        p_system->last_displayed_iflags = 0xFF; /* Force a display dashboard refresh */
-#endif                                                          // SHOW_DASHBOARD
-                    }
-                    break;
-                }
-                /* ______________________________
-                  |                              |
-                  |   System state -> IGNITING   |
-                  |______________________________|
-                */
-                case IGNITING: {
-                    // Check if the DHW and CH request are over
-                    if ((GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F) == false) &&
-                        (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false)) {
-                        // Request canceled, turn actuators off and return to "ready" state
-                        GasOff(p_system);
-#if SHOW_DASHBOARD
-                        p_system->last_displayed_iflags = 0xFF; /* Force a display dashboard refresh */
-#endif                                                          // SHOW_DASHBOARD
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                        p_system->ignition_tries = 1;
-                        p_system->inner_step = READY_1;
-                        p_system->system_state = READY;
-                        break;  // *** *** *** *** *** *** *** *** *** *** *** *** //
-                    }
-                    switch (p_system->inner_step) {
-                        // .................................
-                        // . Step IGNITING_1 : Turn fan on  .
-                        // .................................
-                        case IGNITING_1: {
-                            if (TimerFinished(FSM_TIMER_ID)) {                  /* DLY_IGNITING_1 */
-                                SetFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F); /* Turn exhaust fan on */
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_2);
-                                p_system->inner_step = IGNITING_2;
-                            }
-                            break;
-                        }
-                        // ..........................................
-                        // . Step IGNITING_2 : Check airflow sensor  .
-                        // ..........................................
-                        case IGNITING_2: {
-#if !(AIRFLOW_OVERRIDE)
-                            // Airflow sensor activated -> continue ignition sequence
-                            if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F)) {
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_3);
-                                p_system->inner_step = IGNITING_3;
-                            }
-                            // Airflow sensor activation timeout -> ignition sequence canceled
-                            if (TimerFinished(FSM_TIMER_ID)) { /* DLY_IGNITING_2 */
-                                ClearFlag(p_system, OUTPUT_FLAGS, EXHAUST_FAN_F);
-                                p_system->error = ERROR_004;
-                                p_system->system_state = ERROR;
-                            }
-#else
-                            // Airflow sensor check skipped
-#if SHOW_DASHBOARD
-                            p_system->last_displayed_iflags = 0xFF; /* Force a display dashboard refresh */
-#endif  // SHOW_DASHBOARD
-                            ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_3);
-                            p_system->inner_step = IGNITING_3;
-#endif  // AIRFLOW_OVERRIDE
-                            break;
-                        }
-                        // .............................................
-                        // . Step IGNITING_3 : Open gas security valve  .
-                        // .............................................
-                        case IGNITING_3: {
-                            if (TimerFinished(FSM_TIMER_ID)) { /* DLY_IGNITING_3 */
-                                SetFlag(p_system, OUTPUT_FLAGS, VALVE_S_F);
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_4);
-                                p_system->inner_step = IGNITING_4;
-                            }
-                            break;
-                        }
-                        // ......................................................
-                        // . Step IGNITING_4 : Open gas valve 1 or 2 alternately .
-                        // ......................................................
-                        case IGNITING_4: {
-                            if (TimerFinished(FSM_TIMER_ID)) { /* DLY_IGNITING_4 */
-                                if ((GetFlag(p_system, OUTPUT_FLAGS, VALVE_1_F) == false) || (p_system->ignition_tries == 1)) {
-                                    OpenHeatValve(p_system, VALVE_1);
-                                } else {
-                                    OpenHeatValve(p_system, VALVE_2);
-                                }
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_5);
-                                p_system->inner_step = IGNITING_5;
-                            }
-                            break;
-                        }
-                        // ..........................................
-                        // . Step IGNITING_5 : Turn spark igniter on .
-                        // ..........................................
-                        case IGNITING_5: {
-                            if (TimerFinished(FSM_TIMER_ID)) { /* DLY_IGNITING_5 */
-                                SetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
-                                // Stretch flame detection timeout on each ignition retry
-                                ResetTimerLapse(FSM_TIMER_ID, (DLY_IGNITING_6));
-                                p_system->inner_step = IGNITING_6;
-                            }
-                            break;
-                        }
-                        // ...............................................................................
-                        // . Step IGNITING_6 : Check flame and hand over control to the requested service .
-                        // ...............................................................................
-                        case IGNITING_6: {
-                            // As soon as the flame is detected, the spark igniter is turned off
-                            // and control is handed over to the requested service
-                            if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
-                                // Turn spark igniter off
-                                if (GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F)) {
-                                    ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
-                                }
-                                // Reset ignition attempts counter
-                                p_system->ignition_tries = 1;
-                                // Hand over control to the requested service (DHW has higher priority)
-                                if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
-                                    ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
-#if SHOW_DASHBOARD
-                                    ResetTimerLapse(FSM_TIMER_ID, DLY_DHW_ON_DUTY_LOOP);
-#endif  // SHOW_DASHBOARD
-                                    p_system->inner_step = DHW_ON_DUTY_1;
-                                    p_system->system_state = DHW_ON_DUTY;
-                                } else {
-                                    if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F)) {
-                                        ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
-#if SHOW_DASHBOARD
-                                        ResetTimerLapse(FSM_TIMER_ID, DLY_CH_ON_DUTY_LOOP);
-#endif  //SHOW_DASHBOARD
-                                        p_system->inner_step = CH_ON_DUTY_1;
-                                        p_system->system_state = CH_ON_DUTY;
-                                    } else {
-                                        // Request canceled, turn actuators off and return to "ready" state
-                                        GasOff(p_system);
-                                        ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                                        p_system->inner_step = READY_1;
-                                        p_system->system_state = READY;
-                                    }
-                                }
-                            } else {
-                                // Timer finished without detecting flame
-                                if (TimerFinished(FSM_TIMER_ID)) {  // DLY_IGNITING_6
-                                    // Increment ignition retry counter
-                                    if (p_system->ignition_tries++ >= MAX_IGNITION_TRIES) {
-                                        // If the number of ignition retries reached the maximum, close gas and indicate an error
-                                        GasOff(p_system);
-                                        // Reset ignition retry counter
-                                        p_system->ignition_tries = 1;
-                                        p_system->error = ERROR_005;
-                                        p_system->system_state = ERROR;
-                                    } else {
-                                        // If there are retries to be tried, restart the ignition cycle with the new parameters
-                                        if (GetFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F)) {
-                                            ClearFlag(p_system, OUTPUT_FLAGS, SPARK_IGNITER_F);
-                                        }
-                                        ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_4);
-                                        p_system->inner_step = IGNITING_4;
-                                    }
-                                }
-                            }
-                            break;
-                        }
-                        // .....................
-                        // . IGNITING : Default .
-                        // .....................
-                        default: {
-                            if (p_system->system_state == IGNITING) {
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                                p_system->inner_step = IGNITING_1;
-                            }
-                            break;
-                        }
-                    }
-                    break;
-                }
-                /* _________________________________
-                  |                                 |
-                  |   System state -> DHW_ON_DUTY   |
-                  |_________________________________|
-                */
-                case DHW_ON_DUTY: {
-                    // If the flame sensor is off, check that gas valves 3 and 2 are closed and retry ignition
-                    if (GetFlag(p_system, INPUT_FLAGS, FLAME_F) == false) {
-                        // Turn all heat valves off except the valve 1
-                        OpenHeatValve(p_system, VALVE_1);
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                        p_system->inner_step = IGNITING_1;
-                        p_system->system_state = IGNITING;
-                        break;
-                    }
-#if !(AIRFLOW_OVERRIDE)
-                    // Verify that the airflow sensor is on, otherwise, close gas and go to error
-                    if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F) == false) {
-                        GasOff(p_system); /* Close gas, turn igniter and fan off */
-                        p_system->error = ERROR_007;
-                        p_system->system_state = ERROR; /* >>>>> Next state -> ERROR */
-                    }
-#endif /* AIRFLOW_OVERRIDE */
-                    // If a CH water overtemperature is not detected, but the CH water pump is on, store the running time remaining and halt it ...
-                    if (p_system->ch_water_overheat == false) {
-                        if ((p_system->pump_timer_memory == 0) && GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F)) {
-                            p_system->pump_timer_memory = GetTimeLeft(PUMP_TIMER_ID);
-                            ResetTimerLapse(PUMP_TIMER_ID, 0);
-                            ClearFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                        }
-                    }
-                    // Check if the DHW request is over
-                    if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F) == false) {
-                        // If there is a CH request active, modulate to valve 1 and
-                        // hand over control to CH service state
-                        if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F)) {
-#if SHOW_DASHBOARD
-                            p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-                            ResetTimerLapse(FSM_TIMER_ID, DLY_CH_ON_DUTY_LOOP);
-#endif  // SHOW_DASHBOARD
-                            p_system->inner_step = p_system->ch_on_duty_step;
-                            p_system->system_state = CH_ON_DUTY;
-                        } else {
-                            // DHW request canceled, turn gas off and return to "ready" state
-                            GasOff(p_system);
-                            ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
-                            ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                            p_system->inner_step = READY_1;
-                            p_system->system_state = READY;
-                        }
-                    } else {
-                        // ***************************************************************************************
-                        //                                                                                         *
-                        p_system->current_heat_level = GetKnobPosition(p_system->dhw_setting, DHW_SETTING_STEPS);  //*
-                        ModulateHeat(p_system, p_system->current_heat_level, DHW_HEAT_CYCLE_TIME);                 //*
-                        //                                                                                        *
-                        // ***************************************************************************************
-                    }
-#if SHOW_DASHBOARD
-#if AUTO_DHW_DSP_REFRESH
-                    if (TimerFinished(FSM_TIMER_ID)) {  // DLY_DHW_ON_DUTY_1
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_DHW_ON_DUTY_LOOP);
-                        p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-                    }
-#endif  // AUTO_DHW_DSP_REFRESH
-#endif  // SHOW_DASHBOARD
-                    break;
-                }
-                /* ________________________________
-                  |                                |
-                  |   System state -> CH_ON_DUTY   |
-                  |________________________________|
-                */
-                case CH_ON_DUTY: {
-                    switch (p_system->inner_step) {
-                        // ............................................
-                        // . Step CH_ON_DUTY_1 : CH heating, burner on .
-                        // ............................................
-                        case CH_ON_DUTY_1: {
-                            // If the flame sensor is off, and CH request is still active, check that gas valves 3 and 2 are closed and retry ignition
-                            if (GetFlag(p_system, INPUT_FLAGS, FLAME_F) == false) {
-                                // Turn all heat valves off except the valve 1
-                                OpenHeatValve(p_system, VALVE_1);
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                                p_system->inner_step = IGNITING_1;
-                                p_system->system_state = IGNITING;
-                            }
-#if !(AIRFLOW_OVERRIDE)
-                            // Verify that the airflow sensor is on, otherwise, close gas and go to error
-                            if (GetFlag(p_system, INPUT_FLAGS, AIRFLOW_F) == false) {
-                                GasOff(p_system);  // Close gas, turn igniter and fan off
-                                p_system->error = ERROR_007;
-                                p_system->system_state = ERROR;  // >>>>> Next state -> ERROR
-                            }
-#endif /* AIRFLOW_OVERRIDE */
-                            // Turn CH water pump on and reset its timer continuously to its full-time lapse
-                            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                                SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                            }
-                            ResetTimerLapse(PUMP_TIMER_ID, PUMP_TIMER_DURATION);
-                            p_system->pump_timer_memory = 0;
-                            p_system->ch_water_overheat = false;
-
-                            // If there is a DHW request active, modulate and hand over control to DHW service
-                            if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
-                                p_system->ch_on_duty_step = CH_ON_DUTY_1;  // Preserve current CH service step
-                                // OpenHeatValve(p_system, VALVE_1); // Change to valve 1 before handing over control to DHW state
-                                ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
-#if SHOW_DASHBOARD
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_DHW_ON_DUTY_LOOP);
-#endif  // SHOW_DASHBOARD
-                                p_system->inner_step = DHW_ON_DUTY_1;
-                                p_system->system_state = DHW_ON_DUTY;
-                            } else {
-                                // Check if the CH request is over
-                                if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false) {
-                                    // CH request canceled, turn gas off and return to "ready" state
-                                    GasOff(p_system);
-                                    ResetTimerLapse(HEAT_TIMER_ID, HEAT_TIMER_DURATION);
-                                    ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                                    p_system->inner_step = READY_1;
-                                    p_system->system_state = READY;
-                                    break;
-                                }
-                            }
-                            // While the CH water temperature is cooler than setpoint high, continue heating
-                            // Otherwise, close gas and move on to CH_ON_DUTY_2 step
-                            // NOTE: The temperature reading last bit is masked out to avoid oscillations
-                            if ((p_system->ch_temperature & CH_TEMP_MASK) >= CH_SETPOINT_HIGH) {
-                                // *************************************************************************************
-                                //                                                                                       *
-                                p_system->current_heat_level = GetKnobPosition(p_system->ch_setting, CH_SETTING_STEPS);  //*
-                                ModulateHeat(p_system, p_system->current_heat_level, DHW_HEAT_CYCLE_TIME);               //*
-                                //                                                                                       *
-                                // *************************************************************************************
-
-                            } else {
-                                //Close gas
-                                GasOff(p_system);
-                                // NO NO NO Restart the water pump shutdown timeout counter
-                                // NO NO NO p_system->pump_delay = DLY_WATER_PUMP_OFF;
-                                p_system->inner_step = CH_ON_DUTY_2;
-                            }
-                            break;
-                        }
-                        // .........................................................
-                        // . Step CH_ON_DUTY_2 : CH recirculating water, burner off .
-                        // .........................................................
-                        case CH_ON_DUTY_2: {
-                            // Close gas
-                            if (GetFlag(p_system, INPUT_FLAGS, FLAME_F)) {
-                                GasOff(p_system);
-                            }
-                            // If the CH water pump is off, but it still has pending running time, turn it on
-                            if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                                if (p_system->pump_timer_memory != 0) {
-                                    ResetTimerLapse(PUMP_TIMER_ID, p_system->pump_timer_memory);
-                                    if (GetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F) == false) {
-                                        SetFlag(p_system, OUTPUT_FLAGS, WATER_PUMP_F);
-                                    }
-                                    p_system->pump_timer_memory = 0;
-                                }
-                            }
-                            // If the CH water temperature is colder than setpoint low, ignite the burner,
-                            // then go back to CH_ON_DUTY_1 step
-                            // NOTE: The temperature reading last bit is masked out to avoid oscillations
-                            if ((p_system->ch_temperature & CH_TEMP_MASK) >= CH_SETPOINT_LOW) {
-                                p_system->inner_step = CH_ON_DUTY_1;
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                                p_system->inner_step = IGNITING_1;
-                                p_system->system_state = IGNITING;
-                                break;
-                            }
-                            // If there is a DHW request active, ignite and hand over control to DHW service
-                            if (GetFlag(p_system, INPUT_FLAGS, DHW_REQUEST_F)) {
-                                p_system->ch_on_duty_step = CH_ON_DUTY_2;  // Preserve current CH service step
-#if SHOW_DASHBOARD
-                                p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-#endif                                                                   // SHOW_DASHBOARD
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_IGNITING_1);
-                                p_system->inner_step = IGNITING_1;
-                                p_system->system_state = IGNITING;
-                            } else {
-                                // Check if the CH request is over
-                                if (GetFlag(p_system, INPUT_FLAGS, CH_REQUEST_F) == false) {
-                                    // CH request canceled, turn gas off and return to "ready" state
-                                    GasOff(p_system);
-                                    ResetTimerLapse(FSM_TIMER_ID, DLY_READY_1);
-                                    p_system->inner_step = READY_1;
-                                    p_system->system_state = READY;
-                                }
-                            }
-                            break;
-                        }
-                        // .......................
-                        // . CH_ON_DUTY : Default .
-                        // .......................
-                        default: {
-                            if (p_system->system_state == CH_ON_DUTY) {
-#if SHOW_DASHBOARD
-                                ResetTimerLapse(FSM_TIMER_ID, DLY_CH_ON_DUTY_LOOP);
-#endif  // SHOW_DASHBOARD
-                                p_system->inner_step = p_system->ch_on_duty_step;
-                            }
-                            break;
-                        }
-                    }
-#if SHOW_DASHBOARD
-#if AUTO_CH_DSP_REFRESH
-                    if (TimerFinished(FSM_TIMER_ID)) {  // DLY_CH_ON_DUTY_1
-                        ResetTimerLapse(FSM_TIMER_ID, DLY_CH_ON_DUTY_LOOP);
-                        p_system->last_displayed_iflags = 0xFF;  // Force a display dashboard refresh
-                    }
-#endif  // AUTO_CH_DSP_REFRESH
-#endif  // SHOW_DASHBOARD
-                    break;
-                }
-                /* ___________________________
-                  |                           |
-                  |   System state -> ERROR   |
-                  |___________________________|
-                */
-                case ERROR: {
-                    // Turn all actuators off, except the CH water pump
-                    GasOff(p_system);
-                    uint8_t error_loops = 5; /* Number of times the error will be displayed */
-                    // Error loop -> displays the error code "error_loops" times
-                    while (error_loops--) {
-                        // Update digital input sensors status
-                        for (InputFlag digital_sensor = DHW_REQUEST_F; digital_sensor <= OVERHEAT_F; digital_sensor++) {
-                            //CheckDigitalSensor(p_system, digital_sensor, p_debounce, false);
-                            CheckDigitalSensor(p_system, digital_sensor, false);
-                        }
-                        p_system->system_state = ERROR;
 #if SHOW_DASHBOARD
-                        // Display updated status on system dashboard
-                        Dashboard(p_system, true);
-                        SerialTxStr(str_error_s);
-                        SerialTxNum(p_system->error, DIGITS_3);
-                        SerialTxStr(str_error_e);
-                        SerialTxStr(str_crlf);
+// Function DashboardTask: Displays the updated status on the system dashboard
+void DashboardTask(void *p_data) {
+    Dashboard(((TaskData *)p_data)->p_system, false);
+}
 #endif  // SHOW_DASHBOARD
-                        SetFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-                        _delay_ms(500);  // 500-millisecond blocking delay before each error signaling
-                        ClearFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-                        _delay_ms(500);  // 500-millisecond blocking delay after each error signaling
-                    }
-                    // If there are not enough slots for the required system timers, the system must be halted!
-                    if (p_system->error != 12) {
-                        // End of error loop
-                        // Next state -> OFF (reset error and try to resume service)
-#if SHOW_DASHBOARD
-                        p_system->last_displayed_iflags = 0xFF; /* Force a display dashboard refresh */
-#endif                                                          // SHOW_DASHBOARD
-                        p_system->error = ERROR_000;
-                        p_system->inner_step = OFF_1;
-                        p_system->system_state = OFF;
-                    } else {
-                        return 1;
-                    }
-                    break;
-                }
-                /* _____________________________
-                  |                             |
-                  |   System state -> Default   |
-                  |_____________________________|
-                */
-                default: {
-                    ResetTimerLapse(FSM_TIMER_ID, DLY_OFF_2);
-                    p_system->inner_step = OFF_1;
-                    p_system->system_state = OFF;
-                    break;
-                }
-
-            }    /* System FSM end */
-        } else { /* If the system is in OFF or RESET mode ... */
-            //ClrScr();
-            if (GetKnobPosition(p_system->system_mode, SYSTEM_MODE_STEPS) == SYS_OFF) {
-                // System OFF mode indication
-                GasOff(p_system);
-                p_system->system_state = OFF;
-                p_system->inner_step = OFF_1;
-                for (int i = 0; i < 6; i++) {
-                    ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-                    _delay_ms(100);  // Blocking delay
-                    SerialTxChr((char)46);
-                }
-                SerialTxChr((char)32);
-            } else {
-                // System RESET mode indication
-                GasOff(p_system);
-                p_system->system_state = OFF;
-                p_system->inner_step = OFF_1;
-                for (int i = 0; i < 14; i++) {
-                    ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-                    _delay_ms(50);  // Blocking delay
-                    SerialTxChr((char)42);
-                }
-                SerialTxChr((char)32);
-            }
-            //ToggleFlag(p_system, OUTPUT_FLAGS, LED_UI_F);
-            _delay_ms(125);  // Blocking delay
 
-        } /* Big if end */
+// Function WatchdogTask: Resets the WDT, it stops being reset if a task hangs
+void WatchdogTask(void *p_data) {
+    wdt_reset();
+}
 
-    } /* Main loop end */
+#if SERIAL_TELEMETRY
+// Function TelemetryTask: Sends a binary telemetry frame
+void TelemetryTask(void *p_data) {
+    SendTelemetry(((TaskData *)p_data)->p_system);
+}
+#endif  // SERIAL_TELEMETRY
 
-    return 0;
+#if SERIAL_SHELL
+// Function ShellTask: Feeds a received character to the serial command shell
+void ShellTask(void *p_data) {
+    RunShell(((TaskData *)p_data)->p_system);
 }
+#endif  // SERIAL_SHELL
@@ -0,0 +1,479 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr-shim.c (ATmega328 shim engine for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+// Each test includes this file once, next to its Unity test cases. The engine advances the simulated time in
+// system ticks (Timer0 overflows, 1.024 ms) and runs the enabled interrupt vectors in hardware priority order:
+// - Timer0 overflow and compare match A, once per tick
+// - ADC conversion complete, auto-triggered by the Timer0 overflow, reading the channel selected by ADMUX
+// - USART data register empty, at the programmed baud rate; USART receive complete, from ShimUartRx
+// - EEPROM ready: a started write lands in shim_eeprom by the next tick
+// - External interrupt 0 and pin change interrupts, from the pin levels set with ShimSetPin
+// The time runs while the firmware sleeps, busy-waits (_delay_ms), or spins on SREG (one tick each SHIM_SPIN_READS
+// accesses). ShimStartFirmware runs a main function in a coroutine, ShimRunFor lets it go for a given time.
+
+#include "avr-shim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+// Vectors, weak so that a test links only the modules it needs
+extern void INT0_vect(void) __attribute__((weak));
+extern void PCINT0_vect(void) __attribute__((weak));
+extern void PCINT1_vect(void) __attribute__((weak));
+extern void PCINT2_vect(void) __attribute__((weak));
+extern void TIMER1_OVF_vect(void) __attribute__((weak));
+extern void TIMER0_COMPA_vect(void) __attribute__((weak));
+extern void TIMER0_OVF_vect(void) __attribute__((weak));
+extern void USART_RX_vect(void) __attribute__((weak));
+extern void USART_UDRE_vect(void) __attribute__((weak));
+extern void ADC_vect(void) __attribute__((weak));
+extern void EE_READY_vect(void) __attribute__((weak));
+
+// Registers
+volatile uint8_t shim_sfr[SHIM_SFR_COUNT];
+volatile uint16_t shim_adcw = 0;
+volatile uint16_t shim_eear = 0;
+volatile uint16_t shim_ocr1a = 0;
+volatile uint16_t shim_udr0 = SHIM_UDR_EMPTY;
+
+// Shim state shared with the tests
+uint8_t shim_eeprom[E2END + 1] = {[0 ... E2END] = 0xFF};
+ShimHook shim_tick_hook = NULL;
+ShimHook shim_idle_hook = NULL;
+ShimTxHook shim_tx_hook = NULL;
+
+// Interrupt flag registers: the firmware clears a flag by writing a one to it, the shim tells those writes from its
+// own by comparing the register with the value it published last
+typedef struct shim_flags {
+    volatile uint8_t *p_sfr;  // Interrupt flag register
+    uint8_t pending;          // Flags set
+    uint8_t published;        // Value last stored in the register by the shim
+} ShimFlags;
+
+static ShimFlags tifr0 = {&TIFR0, 0, 0};
+static ShimFlags tifr1 = {&TIFR1, 0, 0};
+static ShimFlags eifr = {&EIFR, 0, 0};
+static ShimFlags pcifr = {&PCIFR, 0, 0};
+
+// Engine state
+static uint32_t ticks = 0;                 // System ticks since start
+static uint16_t spin_reads = 0;            // SREG accesses since the last tick
+static uint32_t delay_us = 0;              // Busy-wait time not yet turned into ticks
+static bool in_tick = false;               // A tick is being run
+static bool in_isr = false;                // A vector is being run
+static uint8_t pin_inputs[3] = {0, 0, 0};  // Input pin levels set by the tests, by port
+static uint8_t pin_reads[3];               // PINx values handed to the firmware
+static uint8_t timer1_quarter = 0;         // Ticks since the last Timer1 overflow (every 4 ticks without prescaler)
+static uint16_t timer1_count = 0;          // TCNT1 value handed to the firmware
+static uint16_t adc_inputs[8];             // Analog input voltages, as ADC codes
+static bool adc_pending = false;           // A conversion completed, ADIF
+static int32_t uart_credit = 0;            // CPU cycles available to shift characters out
+static uint8_t rx_queue[SHIM_RX_LENGTH];   // Characters waiting to be received
+static uint16_t rx_head = 0;
+static uint16_t rx_tail = 0;
+static bool watchdog_on = false;
+static uint32_t watchdog_ticks = 0;        // Watchdog timeout
+static uint32_t watchdog_count = 0;        // Ticks since the last watchdog reset
+
+// Firmware coroutine
+static ucontext_t test_context;
+static ucontext_t firmware_context;
+static uint8_t firmware_stack[SHIM_STACK_SIZE];
+static void (*p_firmware_entry)(void) = NULL;
+static bool in_firmware = false;           // The firmware coroutine is running
+static bool firmware_stopped = false;      // The firmware reset or returned, it won't run again
+static uint32_t run_until = 0;             // Tick at which the firmware hands control back to the test
+static const char *p_reset_reason = NULL;
+
+static void ShimTick(void);
+static void ShimDispatch(void);
+
+// Function ShimReset: Stops the firmware on a microcontroller reset (watchdog, bad interrupt, main returning)
+static void ShimReset(const char *p_reason) {
+    p_reset_reason = p_reason;
+    if (in_firmware) {
+        firmware_stopped = true;
+        in_firmware = false;
+        swapcontext(&firmware_context, &test_context);  // Never resumed
+    }
+    fprintf(stderr, "avr-shim: reset (%s) at tick %u\n", p_reason, ticks);
+    exit(EXIT_FAILURE);
+}
+
+// Function SyncFlags: Takes the flags cleared by the firmware and publishes the pending ones
+static void SyncFlags(ShimFlags *p_flags) {
+    if (*p_flags->p_sfr != p_flags->published) {
+        p_flags->pending &= ~*p_flags->p_sfr;
+    }
+    *p_flags->p_sfr = p_flags->published = p_flags->pending;
+}
+
+// Function RaiseFlag: Sets an interrupt flag
+static void RaiseFlag(ShimFlags *p_flags, uint8_t bit) {
+    SyncFlags(p_flags);
+    p_flags->pending |= (1 << bit);
+    SyncFlags(p_flags);
+}
+
+// Function TakeFlag: Clears an interrupt flag whose vector is about to run
+static void TakeFlag(ShimFlags *p_flags, uint8_t bit) {
+    p_flags->pending &= ~(1 << bit);
+    SyncFlags(p_flags);
+}
+
+// Function UartCharCycles: Returns the CPU cycles needed to send a character (start bit, 8 data bits, stop bit)
+static int32_t UartCharCycles(void) {
+    uint16_t ubrr = ((uint16_t)(UBRR0H & 0x0F) << 8) | UBRR0L;
+    return 10L * ((SHIM_UCSR0A & (1 << U2X0)) ? 8 : 16) * (ubrr + 1);
+}
+
+// Function FlushUdr: Sends the character written to UDR0, if any
+static void FlushUdr(void) {
+    if (shim_udr0 != SHIM_UDR_EMPTY) {
+        uint8_t character = (uint8_t)shim_udr0;
+        shim_udr0 = SHIM_UDR_EMPTY;
+        uart_credit -= UartCharCycles();
+        if ((UCSR0B & (1 << TXEN0)) && (shim_tx_hook != NULL)) {
+            shim_tx_hook(character);
+        }
+    }
+}
+
+// Function RunVector: Runs an interrupt vector with the global interrupt flag cleared, like the hardware does
+static void RunVector(void (*p_vector)(void)) {
+    if (p_vector == NULL) {
+        ShimReset("interrupt without a vector");
+    }
+    SHIM_SREG &= ~(1 << SREG_I);
+    in_isr = true;
+    p_vector();
+    in_isr = false;
+    SHIM_SREG |= (1 << SREG_I);  // RETI
+}
+
+// Function RunNextVector: Runs the highest priority interrupt pending, returns false if none is
+static bool RunNextVector(void) {
+    SyncFlags(&tifr0);
+    SyncFlags(&tifr1);
+    SyncFlags(&eifr);
+    SyncFlags(&pcifr);
+    if ((eifr.pending & (1 << INTF0)) && (EIMSK & (1 << INT0))) {
+        TakeFlag(&eifr, INTF0);
+        RunVector(INT0_vect);
+    } else if ((pcifr.pending & (1 << PCIF0)) && (PCICR & (1 << PCIE0))) {
+        TakeFlag(&pcifr, PCIF0);
+        RunVector(PCINT0_vect);
+    } else if ((pcifr.pending & (1 << PCIF1)) && (PCICR & (1 << PCIE1))) {
+        TakeFlag(&pcifr, PCIF1);
+        RunVector(PCINT1_vect);
+    } else if ((pcifr.pending & (1 << PCIF2)) && (PCICR & (1 << PCIE2))) {
+        TakeFlag(&pcifr, PCIF2);
+        RunVector(PCINT2_vect);
+    } else if ((tifr1.pending & (1 << TOV1)) && (TIMSK1 & (1 << TOIE1))) {
+        TakeFlag(&tifr1, TOV1);
+        RunVector(TIMER1_OVF_vect);
+    } else if ((tifr0.pending & (1 << OCF0A)) && (TIMSK0 & (1 << OCIE0A))) {
+        TakeFlag(&tifr0, OCF0A);
+        RunVector(TIMER0_COMPA_vect);
+    } else if ((tifr0.pending & (1 << TOV0)) && (TIMSK0 & (1 << TOIE0))) {
+        TakeFlag(&tifr0, TOV0);
+        RunVector(TIMER0_OVF_vect);
+    } else if ((rx_head != rx_tail) && ((UCSR0B & ((1 << RXEN0) | (1 << RXCIE0))) == ((1 << RXEN0) | (1 << RXCIE0)))) {
+        FlushUdr();
+        shim_udr0 = rx_queue[rx_tail];
+        rx_tail = (rx_tail + 1) % SHIM_RX_LENGTH;
+        RunVector(USART_RX_vect);
+        shim_udr0 = SHIM_UDR_EMPTY;
+    } else if ((UCSR0B & (1 << UDRIE0)) && (uart_credit >= UartCharCycles())) {
+        RunVector(USART_UDRE_vect);
+        if ((shim_udr0 == SHIM_UDR_EMPTY) && (UCSR0B & (1 << UDRIE0))) {
+            uart_credit = 0;  // The vector sent nothing and kept its interrupt on, try again on the next tick
+            return false;
+        }
+        FlushUdr();
+    } else if (adc_pending && (SHIM_ADCSRA & (1 << ADIE))) {
+        adc_pending = false;
+        RunVector(ADC_vect);
+    } else if ((EECR & (1 << EERIE)) && !(EECR & (1 << EEPE))) {
+        RunVector(EE_READY_vect);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Function ShimDispatch: Runs the pending interrupts while they are enabled
+static void ShimDispatch(void) {
+    if (in_isr || !(SHIM_SREG & (1 << SREG_I))) {
+        return;
+    }
+    for (uint16_t run = 0; RunNextVector(); run++) {
+        if (run >= SHIM_DISPATCH_LIMIT) {
+            fprintf(stderr, "avr-shim: an interrupt vector doesn't clear its cause\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Function ShimTick: Advances the simulated time by one system tick
+static void ShimTick(void) {
+    if (in_tick) {
+        return;
+    }
+    in_tick = true;
+    ticks++;
+    spin_reads = 0;
+    FlushUdr();
+    // Timer0: overflow and compare match A once per tick, the overflow auto-triggers an ADC conversion
+    if (TCCR0B & 0x07) {
+        RaiseFlag(&tifr0, TOV0);
+        RaiseFlag(&tifr0, OCF0A);
+        if ((SHIM_ADCSRA & (1 << ADEN)) && (SHIM_ADCSRA & (1 << ADATE)) && ((ADCSRB & 0x07) == (1 << ADTS2))) {
+            adc_pending = true;
+        }
+    }
+    // Timer1 without prescaler: 16384 cycles per tick, an overflow each 4 ticks
+    if (TCCR1B & 0x07) {
+        if (++timer1_quarter >= 4) {
+            timer1_quarter = 0;
+            RaiseFlag(&tifr1, TOV1);
+        }
+    }
+    // USART: shift register time, a bit more than a tick of it can be banked while idle
+    uart_credit += SHIM_TICK_CYCLES;
+    if (uart_credit > (SHIM_TICK_CYCLES + (2 * UartCharCycles()))) {
+        uart_credit = SHIM_TICK_CYCLES + (2 * UartCharCycles());
+    }
+    // EEPROM: a write started on the previous tick is done
+    if (EECR & (1 << EEPE)) {
+        shim_eeprom[EEAR & E2END] = SHIM_EEDR;
+        EECR &= ~((1 << EEPE) | (1 << EEMPE));
+    }
+    if (watchdog_on && (++watchdog_count > watchdog_ticks)) {
+        ShimReset("watchdog timeout");
+    }
+    if (shim_tick_hook != NULL) {
+        shim_tick_hook();
+    }
+    in_tick = false;
+    if (adc_pending) {
+        shim_adcw = adc_inputs[ADMUX & 0x07];  // The conversion started by this tick's overflow sees the inputs the plant just set
+    }
+    ShimDispatch();
+    if (in_firmware && (ticks >= run_until)) {
+        in_firmware = false;
+        swapcontext(&firmware_context, &test_context);
+        in_firmware = true;
+    }
+}
+
+// Accessors of the registers with side effects
+
+volatile uint8_t *ShimSreg(void) {
+    if (!in_tick && (++spin_reads >= SHIM_SPIN_READS)) {
+        ShimTick();  // Busy CPU: a polling loop, or a long run of code between ticks
+    } else {
+        ShimDispatch();
+    }
+    return &SHIM_SREG;
+}
+
+volatile uint8_t *ShimPin(uint8_t port) {
+    static volatile uint8_t *const p_ddr[3] = {&DDRB, &DDRC, &DDRD};
+    static volatile uint8_t *const p_port[3] = {&PORTB, &PORTC, &PORTD};
+    pin_reads[port] = (*p_port[port] & *p_ddr[port]) | (pin_inputs[port] & ~*p_ddr[port]);
+    return &pin_reads[port];
+}
+
+volatile uint8_t *ShimAdcsra(void) {
+    if (SHIM_ADCSRA & (1 << ADIF)) {
+        SHIM_ADCSRA &= ~(1 << ADIF);  // Written one: clears the flag
+        adc_pending = false;
+    }
+    if (SHIM_ADCSRA & (1 << ADSC)) {
+        // Single conversion started by the previous write, done by this read
+        shim_adcw = adc_inputs[ADMUX & 0x07];
+        SHIM_ADCSRA &= ~(1 << ADSC);
+        adc_pending = true;
+    }
+    return &SHIM_ADCSRA;
+}
+
+volatile uint8_t *ShimEedr(void) {
+    if (EECR & (1 << EERE)) {
+        SHIM_EEDR = shim_eeprom[EEAR & E2END];
+        EECR &= ~(1 << EERE);
+    }
+    return &SHIM_EEDR;
+}
+
+volatile uint8_t *ShimUcsr0a(void) {
+    FlushUdr();  // A direct write to UDR0 goes out at once
+    SHIM_UCSR0A |= (1 << UDRE0);
+    if (rx_head != rx_tail) {
+        SHIM_UCSR0A |= (1 << RXC0);
+    } else {
+        SHIM_UCSR0A &= ~(1 << RXC0);
+    }
+    return &SHIM_UCSR0A;
+}
+
+volatile uint8_t *ShimTcnt0(void) {
+    SHIM_TCNT0 = (uint8_t)((spin_reads * 256UL) / SHIM_SPIN_READS);
+    return &SHIM_TCNT0;
+}
+
+volatile uint16_t *ShimTcnt1(void) {
+    timer1_count = (uint16_t)((timer1_quarter * (uint32_t)SHIM_TICK_CYCLES) + ((spin_reads * (uint32_t)SHIM_TICK_CYCLES) / SHIM_SPIN_READS));
+    return (volatile uint16_t *)&timer1_count;
+}
+
+// avr-libc functions
+
+uint8_t eeprom_read_byte(const uint8_t *p_address) {
+    return shim_eeprom[(uintptr_t)p_address & E2END];
+}
+
+uint16_t eeprom_read_word(const uint16_t *p_address) {
+    uintptr_t address = (uintptr_t)p_address & E2END;
+    return shim_eeprom[address] | ((uint16_t)shim_eeprom[(address + 1) & E2END] << 8);
+}
+
+void eeprom_read_block(void *p_data, const void *p_address, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        ((uint8_t *)p_data)[i] = shim_eeprom[((uintptr_t)p_address + i) & E2END];
+    }
+}
+
+void ShimDelayMicroseconds(uint32_t microseconds) {
+    delay_us += microseconds;
+    while (delay_us >= SHIM_TICK_US) {
+        delay_us -= SHIM_TICK_US;
+        ShimTick();
+    }
+}
+
+void ShimSleep(void) {
+    if (!(SMCR & (1 << SE))) {
+        return;
+    }
+    if (shim_idle_hook != NULL) {
+        shim_idle_hook();
+    }
+    ShimTick();  // Nothing wakes the CPU up before the next Timer0 overflow
+}
+
+void ShimWatchdogEnable(uint8_t timeout) {
+    if (timeout == WDTO_15MS) {
+        // The shortest timeout is only used to restart the system from a bare endless loop, which the shim can't run
+        ShimReset("watchdog restart");
+    }
+    watchdog_on = true;
+    watchdog_ticks = ((16000UL << timeout) + SHIM_TICK_US - 1) / SHIM_TICK_US;
+    watchdog_count = 0;
+}
+
+void ShimWatchdogDisable(void) {
+    watchdog_on = false;
+}
+
+void ShimWatchdogReset(void) {
+    watchdog_count = 0;
+}
+
+// Test interface
+
+// Function ShimSetPin: Sets the level of an input pin, raising its external or pin change interrupt flag
+void ShimSetPin(uint8_t port, uint8_t pin, bool level) {
+    uint8_t mask = (1 << pin);
+    bool previous = (pin_inputs[port] & mask);
+    if (level) {
+        pin_inputs[port] |= mask;
+    } else {
+        pin_inputs[port] &= ~mask;
+    }
+    if (previous == level) {
+        return;
+    }
+    if ((port == SHIM_PORT_D) && (pin == 2)) {
+        uint8_t sense = EICRA & 0x03;
+        if ((sense == 1) || ((sense == 2) && !level) || ((sense == 3) && level)) {
+            RaiseFlag(&eifr, INTF0);
+        }
+    }
+    static volatile uint8_t *const p_pcmsk[3] = {&PCMSK0, &PCMSK1, &PCMSK2};
+    if (*p_pcmsk[port] & mask) {
+        RaiseFlag(&pcifr, port);
+    }
+}
+
+// Function ShimGetOutput: Returns the level driven on an output pin
+bool ShimGetOutput(uint8_t port, uint8_t pin) {
+    static volatile uint8_t *const p_ddr[3] = {&DDRB, &DDRC, &DDRD};
+    static volatile uint8_t *const p_port[3] = {&PORTB, &PORTC, &PORTD};
+    return ((*p_ddr[port] & *p_port[port]) >> pin) & 1;
+}
+
+// Function ShimSetAdc: Sets the voltage of an analog input, as the code a conversion returns
+void ShimSetAdc(uint8_t channel, uint16_t value) {
+    adc_inputs[channel & 0x07] = value & 0x3FF;
+}
+
+// Function ShimUartRx: Queues characters to be received by the USART
+void ShimUartRx(const char *p_text) {
+    while (*p_text != '\0') {
+        uint16_t next = (rx_head + 1) % SHIM_RX_LENGTH;
+        if (next == rx_tail) {
+            return;
+        }
+        rx_queue[rx_head] = (uint8_t)*p_text++;
+        rx_head = next;
+    }
+}
+
+// Function ShimGetTicks: Returns the system ticks since start
+uint32_t ShimGetTicks(void) {
+    return ticks;
+}
+
+// Function FirmwareStart: Body of the firmware coroutine
+static void FirmwareStart(void) {
+    p_firmware_entry();
+    ShimReset("main returned");
+}
+
+// Function ShimStartFirmware: Prepares a main function to run in its own coroutine
+void ShimStartFirmware(void (*p_entry)(void)) {
+    p_firmware_entry = p_entry;
+    getcontext(&firmware_context);
+    firmware_context.uc_stack.ss_sp = firmware_stack;
+    firmware_context.uc_stack.ss_size = sizeof(firmware_stack);
+    firmware_context.uc_link = NULL;
+    makecontext(&firmware_context, FirmwareStart, 0);
+}
+
+// Function ShimRunFor: Runs the firmware for a simulated time, returns false if it has stopped
+bool ShimRunFor(uint32_t milliseconds) {
+    if (firmware_stopped || (p_firmware_entry == NULL)) {
+        return false;
+    }
+    run_until = ticks + (uint32_t)(((uint64_t)milliseconds * 1000 + SHIM_TICK_US - 1) / SHIM_TICK_US);
+    in_firmware = true;
+    swapcontext(&test_context, &firmware_context);
+    return !firmware_stopped;
+}
+
+// Function ShimGetResetReason: Returns why the firmware stopped, NULL while it runs
+const char *ShimGetResetReason(void) {
+    return p_reset_reason;
+}
@@ -0,0 +1,57 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr-shim.h (ATmega328 shim engine headers for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef AVR_SHIM_H
+#define AVR_SHIM_H
+
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/delay.h>
+
+#define SHIM_TICK_US 1024          // Simulated time of a system tick: one Timer0 overflow (prescaler 64 @ 16 MHz)
+#define SHIM_TICK_CYCLES 16384     // CPU cycles in a system tick
+#define SHIM_SPIN_READS 256        // SREG accesses without a tick that count as a tick of busy CPU time
+#define SHIM_UDR_EMPTY 0xFFFF      // UDR0 holds no character to send
+#define SHIM_RX_LENGTH 256         // Characters waiting to be received
+#define SHIM_STACK_SIZE 262144     // Host stack of the firmware coroutine (bytes)
+#define SHIM_DISPATCH_LIMIT 10000  // Interrupts run back to back before the shim gives up on a stuck vector
+
+#define ShimMilliseconds(ticks) ((uint32_t)(((uint64_t)(ticks) * SHIM_TICK_US) / 1000))
+
+// Types
+
+typedef void (*ShimHook)(void);
+typedef void (*ShimTxHook)(uint8_t character);
+
+// Prototypes
+
+void ShimSetPin(uint8_t port, uint8_t pin, bool level);
+bool ShimGetOutput(uint8_t port, uint8_t pin);
+void ShimSetAdc(uint8_t channel, uint16_t value);
+void ShimUartRx(const char *p_text);
+uint32_t ShimGetTicks(void);
+void ShimStartFirmware(void (*p_entry)(void));
+bool ShimRunFor(uint32_t milliseconds);
+const char *ShimGetResetReason(void);
+
+// Shim state shared with the tests
+
+extern uint8_t shim_eeprom[E2END + 1];  // EEPROM contents, erased (0xFF) at start
+extern ShimHook shim_tick_hook;         // Called on each system tick, before the interrupts run (plant models)
+extern ShimHook shim_idle_hook;         // Called when the firmware puts the CPU to sleep
+extern ShimTxHook shim_tx_hook;         // Called with each character sent by the USART
+
+#endif  // AVR_SHIM_H
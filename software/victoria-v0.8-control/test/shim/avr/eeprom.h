@@ -0,0 +1,28 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/eeprom.h (EEPROM shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_EEPROM_H
+#define SHIM_AVR_EEPROM_H
+
+#include <avr/io.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EEMEM
+
+#define eeprom_is_ready() bit_is_clear(EECR, EEPE)
+#define eeprom_busy_wait() loop_until_bit_is_clear(EECR, EEPE)
+
+uint8_t eeprom_read_byte(const uint8_t *p_address);
+uint16_t eeprom_read_word(const uint16_t *p_address);
+void eeprom_read_block(void *p_data, const void *p_address, size_t length);
+
+#endif  // SHIM_AVR_EEPROM_H
@@ -0,0 +1,26 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/interrupt.h (interrupt shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_INTERRUPT_H
+#define SHIM_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+// Interrupt vectors are plain functions, the shim engine calls them with the global interrupt flag cleared
+#define ISR(vector, ...) void vector(void)
+#define EMPTY_INTERRUPT(vector) \
+    void vector(void) {         \
+    }
+
+#define sei() (SREG |= (1 << SREG_I))
+#define cli() (SREG &= (uint8_t) ~(1 << SREG_I))
+
+#endif  // SHIM_AVR_INTERRUPT_H
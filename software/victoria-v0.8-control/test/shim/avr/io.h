@@ -0,0 +1,218 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/io.h (ATmega328 register shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_IO_H
+#define SHIM_AVR_IO_H
+
+// Native builds only: the firmware modules see the ATmega328 registers they use as plain host variables.
+// The registers with side effects (SREG, the pins, ADCSRA, EEDR, UCSR0A and the timer counters) are
+// accessor functions of the shim engine (avr-shim.c), which runs the interrupt vectors on each system tick.
+
+#include <stdint.h>
+
+#define SHIM_SFR_COUNT 64
+
+extern volatile uint8_t shim_sfr[SHIM_SFR_COUNT];
+extern volatile uint16_t shim_adcw;
+extern volatile uint16_t shim_eear;
+extern volatile uint16_t shim_ocr1a;
+extern volatile uint16_t shim_udr0;
+
+volatile uint8_t *ShimSreg(void);
+volatile uint8_t *ShimPin(uint8_t port);
+volatile uint8_t *ShimAdcsra(void);
+volatile uint8_t *ShimEedr(void);
+volatile uint8_t *ShimUcsr0a(void);
+volatile uint8_t *ShimTcnt0(void);
+volatile uint16_t *ShimTcnt1(void);
+
+#define _SFR_SHIM(n) (shim_sfr[n])
+
+// Ports (PINx reads the outputs back, like the hardware)
+#define SHIM_PORT_B 0
+#define SHIM_PORT_C 1
+#define SHIM_PORT_D 2
+#define PINB (*ShimPin(SHIM_PORT_B))
+#define PINC (*ShimPin(SHIM_PORT_C))
+#define PIND (*ShimPin(SHIM_PORT_D))
+#define DDRB _SFR_SHIM(0)
+#define DDRC _SFR_SHIM(1)
+#define DDRD _SFR_SHIM(2)
+#define PORTB _SFR_SHIM(3)
+#define PORTC _SFR_SHIM(4)
+#define PORTD _SFR_SHIM(5)
+
+// Status, reset and external interrupts
+#define SREG (*ShimSreg())
+#define MCUSR _SFR_SHIM(6)
+#define EICRA _SFR_SHIM(7)
+#define EIMSK _SFR_SHIM(8)
+#define EIFR _SFR_SHIM(9)
+#define PCICR _SFR_SHIM(10)
+#define PCIFR _SFR_SHIM(11)
+#define PCMSK0 _SFR_SHIM(12)
+#define PCMSK1 _SFR_SHIM(13)
+#define PCMSK2 _SFR_SHIM(14)
+
+// Timer0 (system tick)
+#define TCCR0A _SFR_SHIM(15)
+#define TCCR0B _SFR_SHIM(16)
+#define TCNT0 (*ShimTcnt0())
+#define OCR0A _SFR_SHIM(17)
+#define TIMSK0 _SFR_SHIM(18)
+#define TIFR0 _SFR_SHIM(19)
+
+// Timer1 (loop profiler)
+#define TCCR1A _SFR_SHIM(20)
+#define TCCR1B _SFR_SHIM(21)
+#define TCNT1 (*ShimTcnt1())
+#define OCR1A shim_ocr1a
+#define TIMSK1 _SFR_SHIM(22)
+#define TIFR1 _SFR_SHIM(23)
+
+// ADC and analog comparator
+#define ADMUX _SFR_SHIM(24)
+#define ADCSRA (*ShimAdcsra())
+#define ADCSRB _SFR_SHIM(25)
+#define ADC shim_adcw
+#define ADCW shim_adcw
+#define DIDR0 _SFR_SHIM(26)
+#define ACSR _SFR_SHIM(27)
+
+// USART0
+#define UCSR0A (*ShimUcsr0a())
+#define UCSR0B _SFR_SHIM(28)
+#define UCSR0C _SFR_SHIM(29)
+#define UBRR0H _SFR_SHIM(30)
+#define UBRR0L _SFR_SHIM(31)
+#define UDR0 shim_udr0
+
+// EEPROM
+#define EECR _SFR_SHIM(32)
+#define EEDR (*ShimEedr())
+#define EEAR shim_eear
+
+// Sleep mode control
+#define SMCR _SFR_SHIM(33)
+
+// Shim internal storage behind the accessors
+#define SHIM_SREG _SFR_SHIM(40)
+#define SHIM_ADCSRA _SFR_SHIM(41)
+#define SHIM_EEDR _SFR_SHIM(42)
+#define SHIM_UCSR0A _SFR_SHIM(43)
+#define SHIM_TCNT0 _SFR_SHIM(44)
+
+// Bit positions (ATmega328P)
+#define SREG_I 7
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define PIN0 0
+#define PIN1 1
+#define PIN2 2
+#define PIN3 3
+#define PIN4 4
+#define PIN5 5
+#define PIN6 6
+#define PIN7 7
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define INT0 0
+#define INT1 1
+#define INTF0 0
+#define INTF1 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+#define PCINT6 6
+#define PCINT7 7
+#define WGM00 0
+#define WGM01 1
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define TOIE1 0
+#define OCIE1A 1
+#define TOV1 0
+#define OCF1A 1
+#define REFS0 6
+#define REFS1 7
+#define ADLAR 5
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define ACIE 3
+#define ACD 7
+#define MPCM0 0
+#define U2X0 1
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCSZ00 1
+#define UCSZ01 2
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define SE 0
+
+#define E2END 1023
+#define RAMEND 0x8FF
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) \
+    do {                                \
+    } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) \
+    do {                                  \
+    } while (bit_is_set(sfr, bit))
+
+#endif  // SHIM_AVR_IO_H
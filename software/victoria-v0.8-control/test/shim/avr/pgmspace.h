@@ -0,0 +1,27 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/pgmspace.h (program memory shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_PGMSPACE_H
+#define SHIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Native builds define __flash as empty, so flash data is ordinary constant data
+#define PROGMEM
+#define PSTR(string) (string)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_byte_near(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_word_near(address) (*(const uint16_t *)(address))
+#define strlen_P strlen
+
+#endif  // SHIM_AVR_PGMSPACE_H
@@ -0,0 +1,27 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/sleep.h (sleep mode shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_SLEEP_H
+#define SHIM_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE 0
+
+void ShimSleep(void);
+
+// The CPU wakes up on the next interrupt, which the shim runs on the next system tick
+#define set_sleep_mode(mode) (SMCR = (uint8_t)(mode))
+#define sleep_enable() (SMCR |= (1 << SE))
+#define sleep_disable() (SMCR &= (uint8_t) ~(1 << SE))
+#define sleep_cpu() ShimSleep()
+
+#endif  // SHIM_AVR_SLEEP_H
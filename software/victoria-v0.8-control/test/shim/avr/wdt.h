@@ -0,0 +1,36 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: avr/wdt.h (watchdog shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_AVR_WDT_H
+#define SHIM_AVR_WDT_H
+
+#include <stdint.h>
+
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+void ShimWatchdogEnable(uint8_t timeout);
+void ShimWatchdogDisable(void);
+void ShimWatchdogReset(void);
+
+#define wdt_enable(timeout) ShimWatchdogEnable(timeout)
+#define wdt_disable() ShimWatchdogDisable()
+#define wdt_reset() ShimWatchdogReset()
+
+#endif  // SHIM_AVR_WDT_H
@@ -0,0 +1,39 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: util/atomic.h (atomic block shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_UTIL_ATOMIC_H
+#define SHIM_UTIL_ATOMIC_H
+
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+// Same construction as avr-libc: the block clears the global interrupt flag on entry and a cleanup
+// handler restores it on any exit, break and return included
+
+static inline uint8_t ShimAtomicEnter(void) {
+    cli();
+    return 1;
+}
+
+static inline void ShimAtomicRestore(const uint8_t *p_sreg) {
+    SREG = *p_sreg;
+}
+
+static inline void ShimAtomicForceOn(const uint8_t *p_sreg) {
+    (void)p_sreg;
+    sei();
+}
+
+#define ATOMIC_RESTORESTATE uint8_t shim_sreg_save __attribute__((__cleanup__(ShimAtomicRestore))) = SREG
+#define ATOMIC_FORCEON uint8_t shim_sreg_save __attribute__((__cleanup__(ShimAtomicForceOn))) = 0
+#define ATOMIC_BLOCK(type) for (type, shim_atomic_once = ShimAtomicEnter(); shim_atomic_once; shim_atomic_once = 0)
+
+#endif  // SHIM_UTIL_ATOMIC_H
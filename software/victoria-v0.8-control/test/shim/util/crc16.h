@@ -0,0 +1,43 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: util/crc16.h (CRC shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_UTIL_CRC16_H
+#define SHIM_UTIL_CRC16_H
+
+#include <stdint.h>
+
+// C equivalents of the avr-libc assembler routines, as given in its documentation
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data) {
+    crc = crc ^ ((uint16_t)data << 8);
+    for (uint8_t i = 0; i < 8; i++) {
+        if (crc & 0x8000) {
+            crc = (crc << 1) ^ 0x1021;
+        } else {
+            crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+    crc ^= data;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (crc & 0x80) {
+            crc = (crc << 1) ^ 0x07;
+        } else {
+            crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+#endif  // SHIM_UTIL_CRC16_H
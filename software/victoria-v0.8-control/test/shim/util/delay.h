@@ -0,0 +1,23 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: util/delay.h (busy-wait delay shim for host tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+#ifndef SHIM_UTIL_DELAY_H
+#define SHIM_UTIL_DELAY_H
+
+#include <stdint.h>
+
+void ShimDelayMicroseconds(uint32_t microseconds);
+
+// A busy wait lets the simulated time run, interrupts included
+#define _delay_ms(milliseconds) ShimDelayMicroseconds((uint32_t)((milliseconds) * 1000UL))
+#define _delay_us(microseconds) ShimDelayMicroseconds((uint32_t)(microseconds))
+
+#endif  // SHIM_UTIL_DELAY_H
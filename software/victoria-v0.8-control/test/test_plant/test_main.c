@@ -0,0 +1,549 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: test_main.c (whole firmware against a scripted boiler plant)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+// Runs on the native_plant environment: pio test -e native_plant
+//
+// The unmodified firmware (src/ main renamed to FirmwareMain) runs on the shim engine against a lumped model of the
+// boiler: the flame lights from the spark with gas flowing, the airflow sensor follows the exhaust fan, and the burner
+// heats the DHW water drawn from the tap or the CH loop. The scenarios run one after another on a single timeline,
+// like a day in the life of the boiler, while the plant checks the safety invariants on every system tick.
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <unity.h>
+
+#include "avr-shim.c"
+#include "victoria-control.h"
+#include "ntc-table.h"  // NTC divider parameters
+
+// Plant model
+#define PLANT_AMBIENT 20.0          // Room and CH return water temperature when cold (°C)
+#define PLANT_COLD_WATER 12.0       // DHW inlet temperature (°C)
+#define PLANT_DHW_FLOW 0.1          // DHW draw with the tap open (kg/s, 6 l/min)
+#define PLANT_DHW_CAPACITY 8000.0   // DHW heat exchanger water and metal (J/K)
+#define PLANT_DHW_LOSS 5.0          // DHW heat exchanger standby loss (W/K)
+#define PLANT_CH_CAPACITY 62800.0   // CH loop water, 15 liters (J/K)
+#define PLANT_CH_LOSS 150.0         // CH radiators with the pump on (W/K)
+#define PLANT_CH_STANDBY_LOSS 10.0  // CH loop with the pump off (W/K)
+#define PLANT_WATER_HEAT 4186.0     // Water specific heat (J/kg/K)
+#define PLANT_EFFICIENCY 0.9        // Burner heat that reaches the water
+#define PLANT_KCAL_H_W 1.163        // Watts per kcal/h
+#define PLANT_IGNITION_TIME 200     // Spark time with gas flowing that lights the flame (ms)
+#define PLANT_FAN_SPIN_UP 400       // Fan running time that closes the airflow sensor (ms)
+#define PLANT_FAN_SPIN_DOWN 300     // Fan stopped time that opens the airflow sensor (ms)
+
+// Knob positions, as ADC readouts (a higher readout is a lower position)
+#define KNOB_COMBI 900
+#define KNOB_OFF 390
+#define KNOB_RESET 100
+#define KNOB_MIDDLE 512
+
+// Bounds checked by the scenarios
+#define MAX_TASK_GAP (3 * SENSORS_TASK_PERIOD)  // Longest time between two sensor task runs (ms), no task waits for the serial line
+#define DHW_BAND 50            // DHW outlet mean temperature band around the target once settled (tenths of a degree)
+#define DHW_OVERSHOOT 20       // DHW outlet temperature allowed above the target once settled (tenths of a degree)
+#define THROUGHPUT_CYCLES 40   // DHW draws of the throughput run
+#define POLL_TIME 10           // Simulated time between condition checks (ms)
+
+// The fan test steps only run with the airflow sensor checked
+#define FAN_TEST (!(AIRFLOW_OVERRIDE) && !(FAN_TEST_OVERRIDE))
+
+typedef bool (*Condition)(void);
+
+typedef struct plant {
+    double dhw_temp;     // DHW heat exchanger outlet (°C)
+    double ch_temp;      // CH loop flow (°C)
+    bool tap_open;       // DHW drawn, closes the DHW request switch
+    bool ch_request;     // Room thermostat calling for heat
+    bool gas_supply;     // Gas at the valve inlet
+    bool blowout;        // Flame blown out while the gas flows
+    bool flue_blocked;   // Exhaust duct blocked, the airflow sensor stays open
+    bool overheat;       // Overheat thermostat open
+    uint16_t mode_knob;  // System mode potentiometer readout
+    bool flame;          // Flame lit
+    bool airflow;        // Airflow sensor closed
+    uint32_t spark_ticks;
+    uint32_t fan_ticks;  // Ticks since the fan last changed
+    bool fan_was_on;
+} Plant;
+
+static Plant plant;
+static SysInfo *p_system = NULL;  // Firmware system state, captured on the first sensor task run
+
+// Observations
+static uint32_t step_ticks[ERROR_1 + 1];  // Ticks spent in each FSM inner step
+static uint32_t last_sensors_tick = 0;
+static uint32_t max_task_gap = 0;         // Ticks, longest time between two sensor task runs
+static uint16_t boot_tx_overflows = 0;    // Characters that found the TX queue full during the start-up dumps
+static uint32_t unlit_gas_ticks = 0;      // Ticks of the current run of gas flowing without a flame
+static uint32_t max_unlit_gas_ticks = 0;
+static uint32_t worst_unlit_gas_ticks = 0;  // Longest run of unlit gas over all the scenarios
+static uint32_t fanless_gas_ticks = 0;    // Ticks with gas flowing and the exhaust fan off
+static uint32_t ignitions = 0;            // Flames lit by the spark
+static uint32_t led_toggles = 0;          // LED_UI changes
+static bool led_was_on = false;
+static double dhw_min = 1000.0;           // DHW outlet temperature range and mean of the current draw, once settled (°C)
+static double dhw_max = -1000.0;
+static double dhw_sum = 0.0;
+static uint32_t dhw_samples = 0;
+static bool dhw_settled = false;
+
+int FirmwareMain(void);
+uint8_t __real_CheckDigitalSensors(SysInfo *p_system, bool show_dashboard);
+
+// Function __wrap_CheckDigitalSensors: Captures the system state and times the sensor task runs (linked with --wrap)
+uint8_t __wrap_CheckDigitalSensors(SysInfo *p_sys, bool show_dashboard) {
+    uint32_t now = ShimGetTicks();
+    if (p_system != NULL) {
+        if ((now - last_sensors_tick) > max_task_gap) {
+            max_task_gap = now - last_sensors_tick;
+        }
+    }
+    p_system = p_sys;
+    last_sensors_tick = now;
+    return __real_CheckDigitalSensors(p_sys, show_dashboard);
+}
+
+// Function Driven: Tells if an output pin is configured and driven to a level
+static bool Driven(volatile uint8_t *p_ddr, volatile uint8_t *p_port, uint8_t pin, bool level) {
+    return ((*p_ddr >> pin) & 1) && (((*p_port >> pin) & 1) == level);
+}
+
+// Function NtcAdc: Returns the ADC readout of an NTC thermistor divider at a temperature
+static uint16_t NtcAdc(double temperature) {
+    double r = NTC_R25 * exp(NTC_BETA * ((1.0 / (temperature + 273.15)) - (1.0 / 298.15)));
+    double code = (1024.0 * r) / (NTC_SERIES + r);
+    return (code > 1023.0) ? 1023 : (uint16_t)code;
+}
+
+// Function GasFlowing: Tells if the security valve and a heat valve are open
+static bool GasFlowing(void) {
+    return Driven(&VALVE_S_DDR, &VALVE_S_PORT, VALVE_S_PIN, true) &&
+           (Driven(&VALVE_1_DDR, &VALVE_1_PORT, VALVE_1_PIN, true) ||
+            Driven(&VALVE_2_DDR, &VALVE_2_PORT, VALVE_2_PIN, true) ||
+            Driven(&VALVE_3_DDR, &VALVE_3_PORT, VALVE_3_PIN, true));
+}
+
+// Function BurnerPower: Returns the heat given to the water by the open heat valves (W)
+static double BurnerPower(void) {
+    double kcal_h = 0.0;
+    if (Driven(&VALVE_1_DDR, &VALVE_1_PORT, VALVE_1_PIN, true)) {
+        kcal_h += VALVE_1_KCAL_H;
+    }
+    if (Driven(&VALVE_2_DDR, &VALVE_2_PORT, VALVE_2_PIN, true)) {
+        kcal_h += VALVE_2_KCAL_H;
+    }
+    if (Driven(&VALVE_3_DDR, &VALVE_3_PORT, VALVE_3_PIN, true)) {
+        kcal_h += VALVE_3_KCAL_H;
+    }
+    return kcal_h * PLANT_KCAL_H_W * PLANT_EFFICIENCY;
+}
+
+// Function PlantTick: Advances the plant by a system tick, sets the firmware inputs and checks the invariants
+static void PlantTick(void) {
+    const double dt = SHIM_TICK_US / 1e6;
+    bool gas = GasFlowing() && plant.gas_supply;
+    bool fan = Driven(&FAN_DDR, &FAN_PORT, FAN_PIN, true);
+    // Flame: lit by the spark (active low) after a while with gas flowing, out as soon as the gas stops
+    if (gas && Driven(&SPARK_DDR, &SPARK_PORT, SPARK_PIN, false)) {
+        plant.spark_ticks++;
+    } else {
+        plant.spark_ticks = 0;
+    }
+    if ((gas == false) || plant.blowout) {
+        plant.flame = false;
+    } else if ((plant.flame == false) && (ShimMilliseconds(plant.spark_ticks) >= PLANT_IGNITION_TIME)) {
+        plant.flame = true;
+        ignitions++;
+    }
+    // Airflow sensor: follows the fan with its spin up and down times
+    if (fan != plant.fan_was_on) {
+        plant.fan_was_on = fan;
+        plant.fan_ticks = 0;
+    }
+    plant.fan_ticks++;
+    if (fan && !plant.flue_blocked && (ShimMilliseconds(plant.fan_ticks) >= PLANT_FAN_SPIN_UP)) {
+        plant.airflow = true;
+    } else if (!fan && (ShimMilliseconds(plant.fan_ticks) >= PLANT_FAN_SPIN_DOWN)) {
+        plant.airflow = false;
+    } else if (plant.flue_blocked) {
+        plant.airflow = false;
+    }
+    // Water: the burner heats the DHW exchanger while the tap is open, otherwise the CH loop
+    double power = plant.flame ? BurnerPower() : 0.0;
+    bool pump = Driven(&PUMP_DDR, &PUMP_PORT, PUMP_PIN, true);
+    double dhw_flow = plant.tap_open ? PLANT_DHW_FLOW : 0.0;
+    double dhw_power = plant.tap_open ? power : 0.0;
+    double ch_power = plant.tap_open ? 0.0 : power;
+    plant.dhw_temp += dt * (dhw_power - (dhw_flow * PLANT_WATER_HEAT * (plant.dhw_temp - PLANT_COLD_WATER)) -
+                            (PLANT_DHW_LOSS * (plant.dhw_temp - PLANT_AMBIENT))) / PLANT_DHW_CAPACITY;
+    plant.ch_temp += dt * (ch_power - ((pump ? PLANT_CH_LOSS : PLANT_CH_STANDBY_LOSS) * (plant.ch_temp - PLANT_AMBIENT))) /
+                     PLANT_CH_CAPACITY;
+    // Firmware inputs
+    ShimSetPin(SHIM_PORT_D, FLAME_PIN, plant.flame);
+    ShimSetPin(SHIM_PORT_C, AIRFLOW_PIN, !plant.airflow);
+    ShimSetPin(SHIM_PORT_B, OVERHEAT_PIN, !plant.overheat);
+    ShimSetPin(SHIM_PORT_B, DHW_RQ_PIN, !plant.tap_open);
+    ShimSetPin(SHIM_PORT_B, CH_RQ_PIN, !plant.ch_request);
+    ShimSetAdc(DHW_TEMP_ADC, NtcAdc(plant.dhw_temp));
+    ShimSetAdc(CH_TEMP_ADC, NtcAdc(plant.ch_temp));
+    ShimSetAdc(SYS_MOD_ADC, plant.mode_knob);
+    bool led = Driven(&LED_UI_DDR, &LED_UI_PORT, LED_UI_PIN, true);
+    if (led != led_was_on) {
+        led_was_on = led;
+        led_toggles++;
+    }
+    // Invariants: no gas without the exhaust fan, no long runs of unlit gas
+    if (GasFlowing()) {
+        if (fan == false) {
+            fanless_gas_ticks++;
+        }
+        unlit_gas_ticks = plant.flame ? 0 : (unlit_gas_ticks + 1);
+        if (unlit_gas_ticks > max_unlit_gas_ticks) {
+            max_unlit_gas_ticks = unlit_gas_ticks;
+        }
+    } else {
+        unlit_gas_ticks = 0;
+    }
+    // Coverage and DHW regulation
+    if (p_system != NULL) {
+        if (p_system->inner_step <= ERROR_1) {
+            step_ticks[p_system->inner_step]++;
+        }
+        if (dhw_settled) {
+            dhw_min = fmin(dhw_min, plant.dhw_temp);
+            dhw_max = fmax(dhw_max, plant.dhw_temp);
+            dhw_sum += plant.dhw_temp;
+            dhw_samples++;
+        }
+    }
+}
+
+// Function RunFirmware: Firmware coroutine entry
+static void RunFirmware(void) {
+    FirmwareMain();
+}
+
+// Function Run: Runs the firmware and the plant for a simulated time
+static void Run(uint32_t milliseconds) {
+    TEST_ASSERT_TRUE_MESSAGE(ShimRunFor(milliseconds), "The firmware stopped");
+}
+
+// Function RunUntil: Runs until a condition holds, returns the simulated time it took (ms), fails on timeout
+static uint32_t RunUntil(Condition condition, uint32_t timeout, const char *p_what) {
+    uint32_t start = ShimGetTicks();
+    while (condition() == false) {
+        if (ShimMilliseconds(ShimGetTicks() - start) > timeout) {
+            TEST_FAIL_MESSAGE(p_what);
+        }
+        Run(POLL_TIME);
+    }
+    return ShimMilliseconds(ShimGetTicks() - start);
+}
+
+// Function RunTicksUntil: Runs tick by tick until a condition holds, returns the ticks it took, fails on timeout
+static uint32_t RunTicksUntil(Condition condition, uint32_t timeout_ticks, const char *p_what) {
+    uint32_t start = ShimGetTicks();
+    while (condition() == false) {
+        if ((ShimGetTicks() - start) > timeout_ticks) {
+            TEST_FAIL_MESSAGE(p_what);
+        }
+        Run(1);
+    }
+    return ShimGetTicks() - start;
+}
+
+// Conditions
+static bool IsReady(void) {
+    return (p_system != NULL) && (p_system->inner_step == READY_1);
+}
+static bool IsDhwOnDuty(void) {
+    return (p_system != NULL) && (p_system->system_state == DHW_ON_DUTY);
+}
+static bool IsChBurning(void) {
+    return (p_system != NULL) && (p_system->inner_step == CH_ON_DUTY_1);
+}
+static bool IsChPaused(void) {
+    return (p_system != NULL) && (p_system->inner_step == CH_ON_DUTY_2);
+}
+static bool IsIgniting(void) {
+    return (p_system != NULL) && (p_system->system_state == IGNITING);
+}
+static bool IsError(void) {
+    return (p_system != NULL) && (p_system->system_state == ERROR);
+}
+static bool IsOff(void) {
+    return (p_system != NULL) && (p_system->system_state == OFF);
+}
+static bool SecurityValveClosed(void) {
+    return !Driven(&VALVE_S_DDR, &VALVE_S_PORT, VALVE_S_PIN, true);
+}
+static bool PumpOff(void) {
+    return !Driven(&PUMP_DDR, &PUMP_PORT, PUMP_PIN, true);
+}
+
+// Function DhwTargetCelsius: Returns the DHW target set by the DHW knob (°C)
+static double DhwTargetCelsius(void) {
+    return GetDhwTarget(p_system) / 10.0;
+}
+
+// Function ChTargetCelsius: Returns the CH flow target set by the CH knob (°C)
+static double ChTargetCelsius(void) {
+    return GetChTarget(p_system) / 10.0;
+}
+
+void setUp(void) {
+    fanless_gas_ticks = 0;
+    max_unlit_gas_ticks = 0;
+}
+
+void tearDown(void) {
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, fanless_gas_ticks, "Gas flowing with the exhaust fan off");
+    // Each ignition try keeps the gas open for its step delays, plus up to an FSM task period per step
+    uint32_t unlit_bound = (uint32_t)sys_params.max_ignition_tries *
+                           (sys_params.dly_igniting_4 + sys_params.dly_igniting_5 + sys_params.dly_igniting_6 + (3 * FSM_TASK_PERIOD));
+#if !(SAFETY_FAST_PATH)
+    // A flame loss on duty keeps the gas open through the flame debounce and the re-ignition steps before the first try
+    unlit_bound += sys_params.debounce_time[FLAME_F] + sys_params.dly_igniting_1 + sys_params.dly_igniting_2 +
+                   sys_params.dly_igniting_3 + (4 * FSM_TASK_PERIOD);
+#endif  // SAFETY_FAST_PATH
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(unlit_bound, ShimMilliseconds(max_unlit_gas_ticks), "Gas flowing without a flame for too long");
+    if (max_unlit_gas_ticks > worst_unlit_gas_ticks) {
+        worst_unlit_gas_ticks = max_unlit_gas_ticks;
+    }
+}
+
+// Startup: fan test, then READY
+void test_startup(void) {
+    RunUntil(IsReady, 30000, "READY not reached after the start");
+    boot_tx_overflows = GetSerialTxOverflows();  // Start-up dumps, sent before the interrupts are on
+#if FAN_TEST
+    TEST_ASSERT_GREATER_THAN(0, step_ticks[OFF_3]);
+#endif  // FAN_TEST
+    TEST_ASSERT_GREATER_THAN(0, step_ticks[OFF_4]);
+    TEST_ASSERT_TRUE(PumpOff());
+    TEST_ASSERT_FALSE(GasFlowing());
+}
+
+// DHW draw: the burner lights and holds the outlet temperature in a band around the target, closing the tap stops it
+void test_dhw_draw(void) {
+    uint32_t lit = ignitions;
+    plant.tap_open = true;
+    RunUntil(IsDhwOnDuty, 15000, "DHW_ON_DUTY not reached");
+    TEST_ASSERT_EQUAL_UINT32(lit + 1, ignitions);
+    Run(90000);
+    dhw_settled = true;
+    Run(60000);
+    dhw_settled = false;
+    // The heat valves take turns within each heat cycle, the outlet ripples around its mean
+    double target = DhwTargetCelsius();
+    double mean = dhw_sum / dhw_samples;
+    char message[96];
+    snprintf(message, sizeof(message), "DHW %.1f..%.1f C, mean %.1f C, target %.1f C", dhw_min, dhw_max, mean, target);
+    TEST_MESSAGE(message);
+#if DHW_CLOSED_LOOP
+    TEST_ASSERT_TRUE_MESSAGE(fabs(mean - target) <= (DHW_BAND / 10.0), message);
+    TEST_ASSERT_TRUE_MESSAGE(dhw_max <= (target + (DHW_OVERSHOOT / 10.0)), message);
+#endif  // DHW_CLOSED_LOOP
+    plant.tap_open = false;
+    RunUntil(IsReady, 5000, "READY not reached after the DHW draw");
+    TEST_ASSERT_FALSE(GasFlowing());
+#if !(DHW_CLOSED_LOOP)
+    TEST_IGNORE_MESSAGE("DHW_CLOSED_LOOP false: the DHW knob sets the heat level, the outlet isn't held at the target");
+#endif  // DHW_CLOSED_LOOP
+}
+
+// CH demand: the burner heats the loop, pauses above the target, and the pump overruns after the demand is over
+void test_ch_demand(void) {
+    plant.ch_request = true;
+    RunUntil(IsChBurning, 15000, "CH_ON_DUTY_1 not reached");
+    Run(100);
+    TEST_ASSERT_FALSE(PumpOff());
+    RunUntil(IsChPaused, 1200000, "The CH burner never paused");
+    double target = ChTargetCelsius();
+    TEST_ASSERT_TRUE(plant.ch_temp <= (target + ((CH_MAX_OVERSHOOT + 10) / 10.0)));
+    TEST_ASSERT_FALSE(GasFlowing());
+    RunUntil(IsChBurning, CH_MIN_OFF_TIME + 600000, "The CH burner never restarted");
+    plant.ch_request = false;
+    RunUntil(IsReady, 5000, "READY not reached after the CH demand");
+    TEST_ASSERT_FALSE(PumpOff());
+    uint32_t overrun = RunUntil(PumpOff, PUMP_TIMER_DURATION + 10000, "The pump kept running");
+    TEST_ASSERT_GREATER_OR_EQUAL(PUMP_TIMER_DURATION - 1000, overrun);
+}
+
+// Ignition failure: no gas at the inlet, the tries run out -> Error 005, the automatic retry lights once the gas is back
+void test_ignition_failure(void) {
+    plant.gas_supply = false;
+    plant.tap_open = true;
+    RunUntil(IsError, 30000, "ERROR not reached without gas");
+    TEST_ASSERT_EQUAL_UINT8(ERROR_005, p_system->error);
+    RunUntil(SecurityValveClosed, MAX_TASK_GAP, "The gas stayed open in the ERROR state");
+    plant.gas_supply = true;
+    RunUntil(IsDhwOnDuty, 60000, "The retry didn't light the burner");
+    TEST_ASSERT_EQUAL_UINT8(0, p_system->error_retries);
+    plant.tap_open = false;
+    RunUntil(IsReady, 5000, "READY not reached after the ignition failure");
+}
+
+// Flame blowout: the safety path closes the security valve within its confirmation time, the FSM lights the burner again
+void test_flame_blowout(void) {
+    plant.tap_open = true;
+    RunUntil(IsDhwOnDuty, 15000, "DHW_ON_DUTY not reached");
+    Run(5000);
+    plant.blowout = true;
+#if SAFETY_FAST_PATH
+    uint32_t ticks = RunTicksUntil(SecurityValveClosed, 1000, "The security valve stayed open without a flame");
+    char message[64];
+    snprintf(message, sizeof(message), "Security valve closed %u ticks after the flame loss", ticks);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_OR_EQUAL(SAFETY_FLAME_LOSS_TIME, ticks);  // Bound: confirmation ticks x 1.024 ms, the shim edges fall on a tick
+#else
+    // Without the fast path the gas stays open until the FSM re-ignition, tearDown checks how long it flows unlit
+    RunUntil(IsIgniting, sys_params.debounce_time[FLAME_F] + (2 * FSM_TASK_PERIOD), "The flame loss wasn't found");
+#endif  // SAFETY_FAST_PATH
+    plant.blowout = false;
+    RunUntil(IsDhwOnDuty, 15000, "The burner wasn't lit again after the blowout");
+    TEST_ASSERT_GREATER_THAN(0, step_ticks[IGNITING_1]);
+    plant.tap_open = false;
+    RunUntil(IsReady, 5000, "READY not reached after the blowout");
+#if !(SAFETY_FAST_PATH)
+    TEST_IGNORE_MESSAGE("SAFETY_FAST_PATH false: the security valve closing time isn't checked");
+#endif  // SAFETY_FAST_PATH
+}
+
+// Overheat: the thermostat opening closes the gas at once -> Error 001, the service resumes once it closes again
+void test_overheat(void) {
+    plant.tap_open = true;
+    RunUntil(IsDhwOnDuty, 15000, "DHW_ON_DUTY not reached");
+    Run(2000);
+    plant.overheat = true;
+    uint32_t ticks = RunTicksUntil(SecurityValveClosed, 1000, "The security valve stayed open on overheat");
+#if SAFETY_FAST_PATH
+    TEST_ASSERT_LESS_OR_EQUAL(SAFETY_OVERHEAT_TIME, ticks);
+#else
+    TEST_ASSERT_LESS_OR_EQUAL(sys_params.debounce_time[OVERHEAT_F] + FSM_TASK_PERIOD, ShimMilliseconds(ticks));
+#endif  // SAFETY_FAST_PATH
+    RunUntil(IsError, 1000, "ERROR not reached on overheat");
+    TEST_ASSERT_EQUAL_UINT8(ERROR_001, p_system->error);
+    plant.overheat = false;
+    plant.tap_open = false;
+    RunUntil(IsReady, 30000, "READY not reached after the overheat");
+}
+
+// Blocked flue: the airflow sensor never closes, the ignition stops before the gas is opened -> Error 004
+void test_blocked_flue(void) {
+#if AIRFLOW_OVERRIDE
+    TEST_IGNORE_MESSAGE("AIRFLOW_OVERRIDE: the airflow sensor isn't checked");
+#else
+    uint32_t gas_opened = step_ticks[IGNITING_4];
+    plant.flue_blocked = true;
+    plant.tap_open = true;
+    RunUntil(IsError, 15000, "ERROR not reached with the flue blocked");
+    TEST_ASSERT_EQUAL_UINT8(ERROR_004, p_system->error);
+    TEST_ASSERT_EQUAL_UINT32(gas_opened, step_ticks[IGNITING_4]);
+    plant.flue_blocked = false;
+    plant.tap_open = false;
+    RunUntil(IsReady, 30000, "READY not reached after the blocked flue");
+#endif  // AIRFLOW_OVERRIDE
+}
+
+// Mode knob: OFF stops the service while the tap is open and blinks LED_UI, RESET too, COMBI resumes
+void test_mode_knob(void) {
+    plant.tap_open = true;
+    RunUntil(IsDhwOnDuty, 15000, "DHW_ON_DUTY not reached");
+    plant.mode_knob = KNOB_OFF;
+    RunUntil(IsOff, 1000, "OFF not reached with the knob");
+    uint32_t toggles = led_toggles;
+    Run(5000);
+    TEST_ASSERT_FALSE(GasFlowing());
+    TEST_ASSERT_GREATER_THAN(toggles, led_toggles);
+    plant.mode_knob = KNOB_RESET;
+    toggles = led_toggles;
+    Run(3000);
+    TEST_ASSERT_TRUE(IsOff());
+    TEST_ASSERT_GREATER_THAN(toggles, led_toggles);
+    plant.mode_knob = KNOB_COMBI;
+    RunUntil(IsDhwOnDuty, 30000, "DHW_ON_DUTY not reached after the knob went back to COMBI");
+    plant.tap_open = false;
+    RunUntil(IsReady, 5000, "READY not reached after the mode changes");
+}
+
+// Throughput: back to back DHW draws, measures how fast the simulation runs
+void test_throughput(void) {
+    struct timespec start, end;
+    uint32_t lit = ignitions;
+    uint32_t sim_start = ShimGetTicks();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint8_t cycle = 0; cycle < THROUGHPUT_CYCLES; cycle++) {
+        plant.tap_open = true;
+        RunUntil(IsDhwOnDuty, 15000, "DHW_ON_DUTY not reached");
+        Run(20000);
+        plant.tap_open = false;
+        RunUntil(IsReady, 5000, "READY not reached after a draw");
+        Run(5000);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_EQUAL_UINT32(lit + THROUGHPUT_CYCLES, ignitions);
+    double wall = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9);
+    double simulated = ShimMilliseconds(ShimGetTicks() - sim_start) / 1000.0;
+    char message[128];
+    snprintf(message, sizeof(message), "%u ignitions, %.0f s simulated in %.2f s (%.0fx, %.1f ignitions/s)",
+             THROUGHPUT_CYCLES, simulated, wall, simulated / wall, THROUGHPUT_CYCLES / wall);
+    TEST_MESSAGE(message);
+}
+
+// Coverage: every FSM step was visited, the task loop latency stayed bounded
+void test_coverage(void) {
+    static const InnerStep steps[] = {OFF_1, OFF_2,
+#if FAN_TEST
+                                      OFF_3,
+#endif  // FAN_TEST
+                                      OFF_4, READY_1, IGNITING_1, IGNITING_2, IGNITING_3, IGNITING_4, IGNITING_5,
+                                      IGNITING_6, DHW_ON_DUTY_1, CH_ON_DUTY_1, CH_ON_DUTY_2, ERROR_1};
+    char message[96];
+    for (uint8_t i = 0; i < (sizeof(steps) / sizeof(steps[0])); i++) {
+        snprintf(message, sizeof(message), "Step %3u: %10.1f s", steps[i], ShimMilliseconds(step_ticks[steps[i]]) / 1000.0);
+        TEST_MESSAGE(message);
+    }
+    snprintf(message, sizeof(message), "Longest sensor task gap %u ms, longest unlit gas %u ms",
+             ShimMilliseconds(max_task_gap), ShimMilliseconds(worst_unlit_gas_ticks));
+    TEST_MESSAGE(message);
+    for (uint8_t i = 0; i < (sizeof(steps) / sizeof(steps[0])); i++) {
+        TEST_ASSERT_GREATER_THAN(0, step_ticks[steps[i]]);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_TASK_GAP, ShimMilliseconds(max_task_gap));
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(boot_tx_overflows, GetSerialTxOverflows(), "The task loop found the TX queue full");
+}
+
+int main(void) {
+    plant.dhw_temp = PLANT_AMBIENT;
+    plant.ch_temp = PLANT_AMBIENT;
+    plant.gas_supply = true;
+    plant.mode_knob = KNOB_COMBI;
+    ShimSetAdc(DHW_POT_ADC, KNOB_MIDDLE);
+    ShimSetAdc(CH_SET_ADC, KNOB_MIDDLE);
+    shim_tick_hook = PlantTick;
+    PlantTick();
+    ShimStartFirmware(RunFirmware);
+    UNITY_BEGIN();
+    RUN_TEST(test_startup);
+    RUN_TEST(test_dhw_draw);
+    RUN_TEST(test_ch_demand);
+    RUN_TEST(test_ignition_failure);
+    RUN_TEST(test_flame_blowout);
+    RUN_TEST(test_overheat);
+    RUN_TEST(test_blocked_flue);
+    RUN_TEST(test_mode_knob);
+    RUN_TEST(test_throughput);
+    RUN_TEST(test_coverage);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: test_main.c (ADC ring buffer running sum tests)
+ *  ........................................................
+ *  Version: 0.8 "Easter Quarantine" / 2020-04-09
+ *  gustavo.casanova@nicebots.com
+ *  ........................................................
+ */
+
+// Runs on the native environment: pio test -e native -f test_ring_buffer
+
+#include <hal.h>
+#include <unity.h>
+
+#include "avr-shim.c"
+
+#define RANDOM_PUSHES 100000
+
+static uint32_t random_state = 1;
+
+// Function RandomAdc: Returns a pseudo-random 10-bit ADC readout (32-bit LCG, repeatable)
+static uint16_t RandomAdc(void) {
+    random_state = (random_state * 1664525UL) + 1013904223UL;
+    return (uint16_t)(random_state >> 22);
+}
+
+// Function CheckAverages: Asserts that the running sum average equals the mean of the whole buffer
+static void CheckAverages(RingBuffer *p_ring) {
+    uint16_t moving = AverageAdcBuffer(p_ring, MOVING);
+    TEST_ASSERT_EQUAL_UINT16(AverageAdcBuffer(p_ring, MEAN), moving);
+    TEST_ASSERT_EQUAL_UINT16(AverageAdc(p_ring->data, BUFFER_LENGTH, p_ring->ix, MEAN), moving);
+}
+
+void setUp(void) {
+    random_state = 1;
+}
+
+void tearDown(void) {
+}
+
+// A cleared buffer averages zero
+void test_cleared_buffer(void) {
+    AdcBuffers buffers;
+    InitAdcBuffers(&buffers, BUFFER_LENGTH);
+    CheckAverages(&buffers.dhw_temp_adc_buffer);
+    TEST_ASSERT_EQUAL_UINT16(0, AverageAdcBuffer(&buffers.dhw_temp_adc_buffer, MOVING));
+}
+
+// Random readouts: the running sum stays equal to the sum of the buffer after each push, across many wraparounds
+void test_random_readouts(void) {
+    AdcBuffers buffers;
+    InitAdcBuffers(&buffers, BUFFER_LENGTH);
+    RingBuffer *p_ring = &buffers.ch_temp_adc_buffer;
+    for (uint32_t push = 0; push < RANDOM_PUSHES; push++) {
+        PushAdcBuffer(p_ring, RandomAdc());
+        CheckAverages(p_ring);
+    }
+}
+
+// Full scale readouts: BUFFER_LENGTH * ADC_MAX must fit in the 16-bit running sum
+void test_full_scale(void) {
+    AdcBuffers buffers;
+    InitAdcBuffers(&buffers, BUFFER_LENGTH);
+    RingBuffer *p_ring = &buffers.sys_mod_adc_buffer;
+    for (uint8_t push = 0; push < (2 * BUFFER_LENGTH); push++) {
+        PushAdcBuffer(p_ring, ADC_MAX);
+        CheckAverages(p_ring);
+    }
+    TEST_ASSERT_EQUAL_UINT16(ADC_MAX, AverageAdcBuffer(p_ring, MOVING));
+    for (uint8_t push = 0; push < BUFFER_LENGTH; push++) {
+        PushAdcBuffer(p_ring, ADC_MIN);
+        CheckAverages(p_ring);
+    }
+    TEST_ASSERT_EQUAL_UINT16(ADC_MIN, AverageAdcBuffer(p_ring, MOVING));
+}
+
+// Step input: the average follows a step as the old readouts are overwritten, one slot per push
+void test_step_readouts(void) {
+    AdcBuffers buffers;
+    InitAdcBuffers(&buffers, BUFFER_LENGTH);
+    RingBuffer *p_ring = &buffers.dhw_set_adc_buffer;
+    for (uint8_t push = 0; push < BUFFER_LENGTH; push++) {
+        PushAdcBuffer(p_ring, 100);
+    }
+    for (uint8_t push = 1; push <= BUFFER_LENGTH; push++) {
+        PushAdcBuffer(p_ring, 900);
+        CheckAverages(p_ring);
+        TEST_ASSERT_EQUAL_UINT16(((100 * (BUFFER_LENGTH - push)) + (900 * push)) / BUFFER_LENGTH, AverageAdcBuffer(p_ring, MOVING));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cleared_buffer);
+    RUN_TEST(test_random_readouts);
+    RUN_TEST(test_full_scale);
+    RUN_TEST(test_step_readouts);
+    return UNITY_END();
+}
@@ -0,0 +1,331 @@
+#
+#  Open-Boiler Control - Victoria 20-20 T/F boiler control
+#  Author: Gustavo Casanova
+#  ........................................................
+#  File: bench-run.py (hot path cycle benchmark runner)
+#  ........................................................
+#  Version: 0.8 "Easter Quarantine" / 2020-05-24
+#  gustavo.casanova@nicebots.com
+#  ........................................................
+#
+#  Builds the bench environment (bench/bench-main.c), runs the ELF on
+#  simavr and reads the BENCH result lines it sends on the USART:
+#    BENCH <name> <calls> <min cycles> <avg cycles> <max cycles> <stack bytes>
+#  Prints a per-function table of cycles, microseconds and stack
+#  high-water marks, writes it as JSON and compares it against
+#  bench/thresholds.txt. Exits with 1 when a function goes over its
+#  maximum cycles or stack bytes, is missing from the run or has no
+#  measured limit yet ("-" in the thresholds, --update fills it in).
+#
+#  With --size it builds the firmware instead and reports its flash and
+#  RAM use (avr-size) and any printf family code linked in (avr-nm),
+#  failing when there is some. --size-ref builds a git revision of the
+#  project in a temporary worktree for a before/after comparison.
+#
+#  --bench-ref runs the serial output benchmarks (serial_tx_num,
+#  serial_tx_num_4, serial_tx_temp) against the firmware modules of a
+#  git revision too, for a before/after table of their cycles. The bench
+#  folder and environment of this tree are copied into the worktree and
+#  built with BENCH_SERIAL_ONLY, which needs nothing but the serial UI.
+#
+#  Needs PlatformIO (pio) and simavr on the path (avr-size and avr-nm
+#  come with the PlatformIO AVR toolchain):
+#    python tools/bench-run.py
+#    python tools/bench-run.py --no-build --elf .pio/build/bench/firmware.elf
+#    python tools/bench-run.py --update    (rewrites the thresholds from this run)
+#    python tools/bench-run.py --size --size-ref HEAD~1
+#    python tools/bench-run.py --bench-ref HEAD~1
+#
+
+import argparse
+import contextlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+F_CPU = 16000000
+MCU = "atmega328p"
+UPDATE_MARGIN = 1.10  # Headroom over the measured values when rewriting the thresholds
+UNMEASURED = "-"      # Thresholds field of a limit that hasn't been measured on simavr yet
+
+SIZE_ENV = "atmega328p"  # Firmware environment measured by --size
+PRINTF_SYMBOL = re.compile(r"\b\w*printf\w*\b")
+SIZE_SECTIONS = (".text", ".data", ".bss")
+BENCH_LINE = re.compile(r"BENCH (\w+) (\d+) (\d+) (\d+) (\d+) (\d+)")
+BENCH_END = "BENCH_END"
+BENCH_ENV = "[env:bench]"
+SERIAL_BENCHES = ("serial_tx_num", "serial_tx_num_4", "serial_tx_temp")  # Run by --bench-ref
+SERIAL_ONLY_FLAGS = "-DBENCH_SERIAL_ONLY=true"
+ANSI_ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def build(project_dir, build_flags=None):
+    env = dict(os.environ, PLATFORMIO_BUILD_FLAGS=build_flags) if build_flags else None
+    subprocess.run(["pio", "run", "-e", "bench", "-d", project_dir], check=True, env=env)
+
+
+def simulate(elf, timeout):
+    # simavr logs each USART line on stderr (in color), capture both streams
+    try:
+        run = subprocess.run(["simavr", "-m", MCU, "-f", str(F_CPU), elf],
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT, timeout=timeout)
+        output = run.stdout
+    except subprocess.TimeoutExpired as expired:
+        output = expired.stdout or b""
+    return ANSI_ESCAPE.sub("", output.decode("ascii", "replace"))
+
+
+def parse(output):
+    results = {}
+    for match in BENCH_LINE.finditer(output):
+        name = match.group(1)
+        calls, min_cycles, avg_cycles, max_cycles, stack = (int(x) for x in match.groups()[1:])
+        results[name] = {
+            "calls": calls,
+            "min_cycles": min_cycles,
+            "avg_cycles": avg_cycles,
+            "max_cycles": max_cycles,
+            "max_us": round(max_cycles * 1e6 / F_CPU, 1),
+            "stack": stack,
+        }
+    return results, BENCH_END in output
+
+
+def read_thresholds(path):
+    thresholds = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                fields = line.split("#")[0].split()
+                if len(fields) == 3:
+                    # "-" marks a function that has no measured limit yet
+                    thresholds[fields[0]] = {"max_cycles": None if fields[1] == UNMEASURED else int(fields[1]),
+                                             "stack": None if fields[2] == UNMEASURED else int(fields[2])}
+    return thresholds
+
+
+def write_thresholds(path, results):
+    lines = [
+        "# Hot path benchmark limits, checked by tools/bench-run.py",
+        "# <function> <max cycles> <max stack bytes>",
+        "#",
+        "# Written by --update from a simavr run, {:.0f}% over the measured values:".format((UPDATE_MARGIN - 1) * 100),
+    ]
+    lines += ["# " + row for row in table(results, {}, limits=False).splitlines()]
+    for name, result in results.items():
+        if name != "empty":
+            lines.append("{} {} {}".format(name, int(result["max_cycles"] * UPDATE_MARGIN) + 1,
+                                           int(result["stack"] * UPDATE_MARGIN) + 1))
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def compare(results, thresholds):
+    failures = []
+    for name, limit in thresholds.items():
+        result = results.get(name)
+        if result is None:
+            failures.append("{}: missing from the run".format(name))
+            continue
+        if (limit["max_cycles"] is None) or (limit["stack"] is None):
+            failures.append("{}: no measured limit, run --update".format(name))
+            continue
+        if result["max_cycles"] > limit["max_cycles"]:
+            failures.append("{}: {} cycles, limit {}".format(name, result["max_cycles"], limit["max_cycles"]))
+        if result["stack"] > limit["stack"]:
+            failures.append("{}: {} stack bytes, limit {}".format(name, result["stack"], limit["stack"]))
+    return failures
+
+
+def limit_text(limit):
+    if limit is None:
+        return "-"
+    return "{} / {}".format(*(UNMEASURED if value is None else value for value in (limit["max_cycles"], limit["stack"])))
+
+
+def table(results, thresholds, limits=True):
+    header = ("function", "calls", "min", "avg", "max", "max us", "stack", "limit")[:8 if limits else 7]
+    rows = [header]
+    for name, r in results.items():
+        row = (name, r["calls"], r["min_cycles"], r["avg_cycles"], r["max_cycles"], r["max_us"], r["stack"])
+        rows.append(row + (limit_text(thresholds.get(name)),) if limits else row)
+    widths = [max(len(str(row[i])) for row in rows) for i in range(len(header))]
+    return "\n".join("  ".join(str(cell).ljust(widths[i]) if i == 0 else str(cell).rjust(widths[i])
+                               for i, cell in enumerate(row)) for row in rows)
+
+
+def tool(name):
+    # The PlatformIO AVR toolchain isn't on the path by default
+    path = shutil.which(name)
+    if path is None:
+        packages = os.path.join(os.path.expanduser("~"), ".platformio", "packages", "toolchain-atmelavr", "bin")
+        path = os.path.join(packages, name)
+    return path
+
+
+def parse_size(output):
+    sections = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in SIZE_SECTIONS and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+    return {
+        "flash": sections.get(".text", 0) + sections.get(".data", 0),
+        "ram": sections.get(".data", 0) + sections.get(".bss", 0),
+    }
+
+
+def parse_printf(output):
+    return sorted(set(PRINTF_SYMBOL.findall(output)))
+
+
+def firmware_size(project_dir, env):
+    subprocess.run(["pio", "run", "-e", env, "-d", project_dir], check=True)
+    elf = os.path.join(project_dir, ".pio", "build", env, "firmware.elf")
+    size = subprocess.run([tool("avr-size"), "-A", elf], stdout=subprocess.PIPE, check=True)
+    symbols = subprocess.run([tool("avr-nm"), elf], stdout=subprocess.PIPE, check=True)
+    result = parse_size(size.stdout.decode())
+    result["printf"] = parse_printf(symbols.stdout.decode())
+    return result
+
+
+@contextlib.contextmanager
+def revision_tree(project_dir, ref):
+    # Checks another revision out in a temporary git worktree, yields the same project folder inside it
+    top = subprocess.run(["git", "-C", project_dir, "rev-parse", "--show-toplevel"],
+                         stdout=subprocess.PIPE, check=True).stdout.decode().strip()
+    worktree = tempfile.mkdtemp(prefix="bench-ref-")
+    subprocess.run(["git", "-C", top, "worktree", "add", "--detach", worktree, ref], check=True)
+    try:
+        yield os.path.join(worktree, os.path.relpath(os.path.abspath(project_dir), top))
+    finally:
+        subprocess.run(["git", "-C", top, "worktree", "remove", "--force", worktree], check=True)
+
+
+def revision_size(project_dir, env, ref):
+    with revision_tree(project_dir, ref) as ref_dir:
+        return firmware_size(ref_dir, env)
+
+
+def bench_env(project_dir):
+    # The bench environment section of this tree's platformio.ini, up to the next section
+    with open(os.path.join(project_dir, "platformio.ini")) as f:
+        text = f.read()
+    start = text.index(BENCH_ENV)
+    end = text.find("\n[", start)
+    return text[start:] if end < 0 else text[start:end + 1]
+
+
+def revision_bench(project_dir, ref, timeout):
+    # Builds this tree's benchmarks, serial output only, against the firmware modules of another revision
+    with revision_tree(project_dir, ref) as ref_dir:
+        shutil.rmtree(os.path.join(ref_dir, "bench"), ignore_errors=True)
+        shutil.copytree(os.path.join(project_dir, "bench"), os.path.join(ref_dir, "bench"))
+        ini = os.path.join(ref_dir, "platformio.ini")
+        with open(ini) as f:
+            has_bench = BENCH_ENV in f.read()
+        if not has_bench:
+            with open(ini, "a") as f:
+                f.write("\n" + bench_env(project_dir))
+        build(ref_dir, SERIAL_ONLY_FLAGS)
+        return parse(simulate(os.path.join(ref_dir, ".pio", "build", "bench", "firmware.elf"), timeout))
+
+
+def ref_table(ref, ref_results, results):
+    header = ("function", ref + " min", "avg", "max", "this tree min", "avg", "max", "max change")
+    rows = [header]
+    for name in SERIAL_BENCHES:
+        before = ref_results.get(name)
+        after = results.get(name)
+        if before is None or after is None:
+            rows.append((name,) + ("-",) * (len(header) - 1))
+            continue
+        change = "{:+.1f}%".format((after["max_cycles"] - before["max_cycles"]) * 100.0 / before["max_cycles"]) \
+            if before["max_cycles"] else "-"
+        rows.append((name, before["min_cycles"], before["avg_cycles"], before["max_cycles"],
+                     after["min_cycles"], after["avg_cycles"], after["max_cycles"], change))
+    widths = [max(len(str(row[i])) for row in rows) for i in range(len(header))]
+    return "\n".join("  ".join(str(cell).ljust(widths[i]) if i == 0 else str(cell).rjust(widths[i])
+                               for i, cell in enumerate(row)) for row in rows)
+
+
+def size_table(sizes):
+    rows = [("firmware", "flash", "ram", "printf code")]
+    for name, size in sizes.items():
+        rows.append((name, size["flash"], size["ram"], " ".join(size["printf"]) or "-"))
+    widths = [max(len(str(row[i])) for row in rows) for i in range(len(rows[0]))]
+    return "\n".join("  ".join(str(cell).ljust(widths[i]) if i in (0, 3) else str(cell).rjust(widths[i])
+                               for i, cell in enumerate(row)) for row in rows)
+
+
+def size_report(args):
+    sizes = {}
+    if args.size_ref:
+        sizes[args.size_ref] = revision_size(args.project_dir, args.size_env, args.size_ref)
+    sizes["this tree"] = firmware_size(args.project_dir, args.size_env)
+    print(size_table(sizes))
+    if sizes["this tree"]["printf"]:
+        print("bench-run: printf code linked in: " + " ".join(sizes["this tree"]["printf"]))
+        return 1
+    return 0
+
+
+def main(argv):
+    project_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    parser = argparse.ArgumentParser(description="Run the hot path cycle benchmarks on simavr")
+    parser.add_argument("--project-dir", default=project_dir)
+    parser.add_argument("--elf", default=None)
+    parser.add_argument("--json", default=None)
+    parser.add_argument("--thresholds", default=None)
+    parser.add_argument("--timeout", type=float, default=120.0)
+    parser.add_argument("--no-build", action="store_true")
+    parser.add_argument("--update", action="store_true")
+    parser.add_argument("--size", action="store_true")
+    parser.add_argument("--size-env", default=SIZE_ENV)
+    parser.add_argument("--size-ref", default=None)
+    parser.add_argument("--bench-ref", default=None)
+    args = parser.parse_args(argv)
+
+    if args.size:
+        return size_report(args)
+
+    build_dir = os.path.join(args.project_dir, ".pio", "build", "bench")
+    elf = args.elf or os.path.join(build_dir, "firmware.elf")
+    json_path = args.json or os.path.join(build_dir, "bench.json")
+    thresholds_path = args.thresholds or os.path.join(args.project_dir, "bench", "thresholds.txt")
+
+    if not args.no_build:
+        build(args.project_dir)
+    results, finished = parse(simulate(elf, args.timeout))
+    if not finished:
+        print("bench-run: the simulation ended before {}".format(BENCH_END))
+        return 1
+
+    if args.update:
+        write_thresholds(thresholds_path, results)
+        print("bench-run: {} updated".format(thresholds_path))
+    thresholds = read_thresholds(thresholds_path)
+    print(table(results, thresholds))
+    os.makedirs(os.path.dirname(os.path.abspath(json_path)), exist_ok=True)
+    with open(json_path, "w") as f:
+        json.dump(results, f, indent=2)
+
+    if args.bench_ref:
+        ref_results, ref_finished = revision_bench(args.project_dir, args.bench_ref, args.timeout)
+        if not ref_finished:
+            print("bench-run: the {} simulation ended before {}".format(args.bench_ref, BENCH_END))
+            return 1
+        print(ref_table(args.bench_ref, ref_results, results))
+
+    failures = compare(results, thresholds)
+    for failure in failures:
+        print("bench-run: over the limit: " + failure)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,227 @@
+#
+#  Open-Boiler Control - Victoria 20-20 T/F boiler control
+#  Author: Gustavo Casanova
+#  ........................................................
+#  File: heat-table-gen.py (heat level table generator)
+#  ........................................................
+#  Version: 0.8 "Easter Quarantine" / 2020-05-24
+#  gustavo.casanova@nicebots.com
+#  ........................................................
+#
+#  Generates lib/hal/heat-table.h, the flash table of heat levels that
+#  ModulateHeat runs: how long each heat valve stays open on every DHW
+#  and CH heat cycle (milliseconds), the heat output (kcal/h) and the
+#  G20 gas usage (litres/h) of each level.
+#
+#  A heat cycle is split in `resolution` equal slots shared among the
+#  valves. Every split gives a candidate level; levels with the same
+#  heat output keep the split that opens fewer valves. With --levels,
+#  the levels closest to evenly spaced heat outputs are kept.
+#
+#  The cycle times are read from include/sys-settings.h, hal.h stops
+#  the build if the table was generated for other cycle times.
+#
+#  Standalone:
+#    python tools/heat-table-gen.py --kcal 7000 12000 20000 --gas 0.87 1.46 2.39 --resolution 6
+#  PlatformIO (extra_scripts = pre:tools/heat-table-gen.py) reads the
+#  custom_heat_* options of the environment being built.
+#
+
+import argparse
+import itertools
+import os
+import re
+import sys
+
+U16_MAX = 65535
+
+DEFAULTS = {
+    "kcal": [7000, 12000, 20000],  # Heat output of each valve (kcal/h)
+    "gas": [0.870, 1.460, 2.390],  # G20 gas usage of each valve (m3/h)
+    "resolution": 6,               # Heat cycle slots shared among the valves
+    "levels": 0,                   # Heat levels to keep, 0: all distinct levels
+}
+
+HEADER = """/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: heat-table.h (heat modulator level table)
+ *  ........................................................
+ *  GENERATED BY tools/heat-table-gen.py - DO NOT EDIT
+ *  ........................................................
+ */
+
+#ifndef HEAT_TABLE_H
+#define HEAT_TABLE_H
+
+#include <avr/io.h>
+
+// Parameters used to build the table
+{parameters}
+// Heat valve ratings: heat output (kcal/h) and G20 gas usage (litres/h)
+{ratings}
+#define HEAT_LEVELS {levels}  // Heat levels, from lower to higher
+
+// ..........................................................................
+// {{ {{ DHW cycle valve ms }}, {{ CH cycle valve ms }} }}, Kcal/h, G20 l/h
+// ..........................................................................
+static const HeatLevel __flash heat_level[HEAT_LEVELS] = {{
+"""
+
+FOOTER = """}};
+
+#endif  // HEAT_TABLE_H
+"""
+
+
+def read_cycle_times(project_dir):
+    path = os.path.join(project_dir, "include", "sys-settings.h")
+    with open(path) as f:
+        text = f.read()
+    cycles = {}
+    for name in ("DHW_HEAT_CYCLE_TIME", "CH_HEAT_CYCLE_TIME"):
+        match = re.search(r"^#define\s+" + name + r"\s+(\d+)", text, re.MULTILINE)
+        if match is None:
+            raise ValueError("{} not found in {}".format(name, path))
+        cycles[name] = int(match.group(1))
+    return cycles["DHW_HEAT_CYCLE_TIME"], cycles["CH_HEAT_CYCLE_TIME"]
+
+
+def split_times(slots, resolution, cycle):
+    # Valve open times that add up to the cycle time exactly, the rounding goes to the last open valve
+    times = [cycle * s // resolution for s in slots]
+    last = max(i for i, s in enumerate(slots) if s)
+    times[last] += cycle - sum(times)
+    return times
+
+
+def build_levels(p):
+    kcal, gas, resolution = p["kcal"], p["gas"], p["resolution"]
+    if len(kcal) != len(gas):
+        raise ValueError("--kcal and --gas need one figure per valve")
+    candidates = {}
+    for slots in itertools.product(range(resolution + 1), repeat=len(kcal)):
+        if sum(slots) != resolution:
+            continue
+        level_kcal = int(round(sum(s * k for s, k in zip(slots, kcal)) / resolution))
+        level_gas = int(round(sum(s * g * 1000 for s, g in zip(slots, gas)) / resolution))
+        valves_open = sum(1 for s in slots if s)
+        best = candidates.get(level_kcal)
+        if best is None or (valves_open, level_gas) < (best[2], best[1]):
+            candidates[level_kcal] = (slots, level_gas, valves_open)
+    levels = [(k, v[0], v[1]) for k, v in sorted(candidates.items())]
+    if p["levels"]:
+        levels = pick_levels(levels, p["levels"])
+    return levels
+
+
+def pick_levels(levels, count):
+    # Keeps the levels closest to evenly spaced heat outputs, always including the lowest and the highest
+    if count >= len(levels):
+        return levels
+    if count < 2:
+        raise ValueError("--levels must be 0 or at least 2")
+    low, high = levels[0][0], levels[-1][0]
+    picked = []
+    free = list(levels)
+    for i in range(count):
+        target = low + (high - low) * i / (count - 1)
+        best = min(free, key=lambda level: abs(level[0] - target))
+        free.remove(best)
+        picked.append(best)
+    return sorted(picked)
+
+
+def validate(levels, p, dhw_cycle, ch_cycle):
+    for cycle in (dhw_cycle, ch_cycle):
+        if not 0 < cycle <= U16_MAX:
+            raise ValueError("Heat cycle times must fit in 16 bits")
+    if not 2 <= len(levels) <= 255:
+        raise ValueError("The table needs 2 to 255 heat levels")
+    outputs = [level[0] for level in levels]
+    if any(a >= b for a, b in zip(outputs, outputs[1:])):
+        raise ValueError("Heat levels must be strictly increasing")
+    if max(p["kcal"]) > U16_MAX or max(level[2] for level in levels) > U16_MAX:
+        raise ValueError("Heat and gas figures must fit in 16 bits")
+    for _, slots, _ in levels:
+        for cycle in (dhw_cycle, ch_cycle):
+            if sum(split_times(slots, p["resolution"], cycle)) != cycle:
+                raise ValueError("Valve times don't add up to the heat cycle time")
+
+
+def aligned(lines):
+    # Lines of (code, comment) with the comments in one column
+    width = max(len(code) for code, _ in lines) + 2
+    return "".join("{}// {}\n".format(code.ljust(width), comment) for code, comment in lines)
+
+
+def render(p, dhw_cycle, ch_cycle):
+    levels = build_levels(p)
+    validate(levels, p, dhw_cycle, ch_cycle)
+    parameters = aligned([
+        ("#define HEAT_TABLE_VALVES {}".format(len(p["kcal"])), "Heat modulator valves"),
+        ("#define HEAT_TABLE_RESOLUTION {}".format(p["resolution"]), "Heat cycle slots shared among the valves"),
+        ("#define HEAT_TABLE_DHW_CYCLE {}".format(dhw_cycle), "DHW heat cycle time (milliseconds)"),
+        ("#define HEAT_TABLE_CH_CYCLE {}".format(ch_cycle), "CH heat cycle time (milliseconds)")])
+    ratings = []
+    for valve, (kcal, gas) in enumerate(zip(p["kcal"], p["gas"])):
+        ratings.append(("#define VALVE_{}_KCAL_H {}".format(valve + 1, int(kcal)), "Valve {} heat output".format(valve + 1)))
+        ratings.append(("#define VALVE_{}_GAS_LH {}".format(valve + 1, int(round(gas * 1000))), "Valve {} gas usage".format(valve + 1)))
+    rows = []
+    for ix, (kcal, slots, gas) in enumerate(levels):
+        dhw = ", ".join(str(t) for t in split_times(slots, p["resolution"], dhw_cycle))
+        ch = ", ".join(str(t) for t in split_times(slots, p["resolution"], ch_cycle))
+        sep = "," if ix + 1 < len(levels) else ""
+        rows.append(("    {{{{{{{}}}, {{{}}}}}, {}, {}}}{}".format(dhw, ch, kcal, gas, sep),
+                     "Heat level {} = {} Kcal/h ({} slots)".format(ix, kcal, "/".join(str(s) for s in slots))))
+    out = HEADER.format(parameters=parameters, ratings=aligned(ratings), levels=len(levels))
+    return out + aligned(rows) + FOOTER.format()
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return False
+    with open(path, "w") as f:
+        f.write(text)
+    return True
+
+
+def generate(project_dir, p):
+    dhw_cycle, ch_cycle = read_cycle_times(project_dir)
+    path = os.path.join(project_dir, "lib", "hal", "heat-table.h")
+    if write_if_changed(path, render(p, dhw_cycle, ch_cycle)):
+        print("heat-table-gen: {} updated".format(path))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Generate the heat modulator level table")
+    parser.add_argument("--kcal", type=float, nargs="+", default=DEFAULTS["kcal"])
+    parser.add_argument("--gas", type=float, nargs="+", default=DEFAULTS["gas"])
+    parser.add_argument("--resolution", type=int, default=DEFAULTS["resolution"])
+    parser.add_argument("--levels", type=int, default=DEFAULTS["levels"])
+    parser.add_argument("--project-dir", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    args = parser.parse_args(argv)
+    generate(args.project_dir, {key: getattr(args, key) for key in DEFAULTS})
+
+
+try:
+    Import("env")  # PlatformIO (SCons) pre-build script
+except NameError:
+    env = None
+
+if env is None:
+    main(sys.argv[1:])
+else:
+    options = {}
+    for key, value in DEFAULTS.items():
+        option = env.GetProjectOption("custom_heat_" + key, None)
+        if option is None:
+            options[key] = value
+        elif isinstance(value, list):
+            options[key] = [float(x) for x in option.split()]
+        else:
+            options[key] = int(option)
+    generate(env.subst("$PROJECT_DIR"), options)
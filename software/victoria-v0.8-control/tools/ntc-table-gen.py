@@ -0,0 +1,140 @@
+#
+#  Open-Boiler Control - Victoria 20-20 T/F boiler control
+#  Author: Gustavo Casanova
+#  ........................................................
+#  File: ntc-table-gen.py (NTC lookup table generator)
+#  ........................................................
+#  Version: 0.8 "Easter Quarantine" / 2020-05-24
+#  gustavo.casanova@nicebots.com
+#  ........................................................
+#
+#  Generates lib/temp-calc/ntc-table.h, a flash table that maps every
+#  10-bit ADC code to a temperature in tenths of a degree Celsius.
+#
+#  Circuit: AVCC -- series resistor -- ADC pin -- NTC -- GND
+#  Model:   1/T = 1/T25 + ln(R/R25)/beta
+#
+#  Standalone:
+#    python tools/ntc-table-gen.py --beta 3950 --r25 10200 --series 10000
+#  PlatformIO (extra_scripts = pre:tools/ntc-table-gen.py) reads the
+#  custom_ntc_* options of the environment being built.
+#
+
+import argparse
+import math
+import os
+import sys
+
+ADC_CODES = 1024
+T0_KELVIN = 273.15
+T25_KELVIN = T0_KELVIN + 25.0
+INVALID = "INVALID_TEMP_D"
+
+DEFAULTS = {
+    "beta": 3950.0,     # NTC beta coefficient (K)
+    "r25": 10200.0,     # NTC resistance at 25 C (ohm)
+    "series": 10000.0,  # Divider series resistor (ohm)
+    "tmin": -20.0,      # Lowest valid temperature (C)
+    "tmax": 90.0,       # Highest valid temperature (C)
+}
+
+HEADER = """/*
+ *  Open-Boiler Control - Victoria 20-20 T/F boiler control
+ *  Author: Gustavo Casanova
+ *  ........................................................
+ *  File: ntc-table.h (NTC ADC-to-temperature lookup table)
+ *  ........................................................
+ *  GENERATED BY tools/ntc-table-gen.py - DO NOT EDIT
+ *  ........................................................
+ */
+
+#ifndef NTC_TABLE_H
+#define NTC_TABLE_H
+
+#include <avr/io.h>
+
+// NTC parameters used to build the table
+#define NTC_BETA {beta:.0f}      // Beta coefficient (K)
+#define NTC_R25 {r25:.0f}      // Resistance at 25 C (ohm)
+#define NTC_SERIES {series:.0f}  // Divider series resistor (ohm)
+
+#define NTC_TABLE_LEN {codes}  // One entry per ADC code
+
+// ADC code -> temperature (tenths of a degree Celsius), {INVALID} out of [{tmin:.1f}, {tmax:.1f}] C
+static const int16_t __flash ntc_temp_table[NTC_TABLE_LEN] = {{
+"""
+
+FOOTER = """}};
+
+#endif  // NTC_TABLE_H
+"""
+
+
+def adc_to_tenths(code, p):
+    # Center of the ADC code, avoids the 0 and 1024 singularities
+    x = code + 0.5
+    r_ntc = p["series"] * x / (ADC_CODES - x)
+    t_kelvin = 1.0 / (1.0 / T25_KELVIN + math.log(r_ntc / p["r25"]) / p["beta"])
+    t_celsius = t_kelvin - T0_KELVIN
+    if t_celsius < p["tmin"] or t_celsius > p["tmax"]:
+        return None
+    return int(round(t_celsius * 10))
+
+
+def build_table(p):
+    entries = []
+    for code in range(ADC_CODES):
+        tenths = adc_to_tenths(code, p)
+        entries.append(INVALID if tenths is None else str(tenths))
+    # Sanity check: temperature must fall as the ADC code rises
+    valid = [int(e) for e in entries if e != INVALID]
+    if any(a < b for a, b in zip(valid, valid[1:])):
+        raise ValueError("NTC table is not monotonic, check the parameters")
+    return entries
+
+
+def render(p):
+    entries = build_table(p)
+    out = HEADER.format(codes=ADC_CODES, INVALID=INVALID, **p)
+    for i in range(0, ADC_CODES, 16):
+        row = ", ".join(entries[i:i + 16])
+        sep = "," if i + 16 < ADC_CODES else ""
+        out += "    {}{}  // {}-{}\n".format(row, sep, i, i + 15)
+    return out + FOOTER.format()
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return False
+    with open(path, "w") as f:
+        f.write(text)
+    return True
+
+
+def generate(project_dir, p):
+    path = os.path.join(project_dir, "lib", "temp-calc", "ntc-table.h")
+    if write_if_changed(path, render(p)):
+        print("ntc-table-gen: {} updated".format(path))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Generate the NTC ADC lookup table")
+    for key, value in DEFAULTS.items():
+        parser.add_argument("--" + key, type=float, default=value)
+    parser.add_argument("--project-dir", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    args = parser.parse_args(argv)
+    generate(args.project_dir, {key: getattr(args, key) for key in DEFAULTS})
+
+
+try:
+    Import("env")  # PlatformIO (SCons) pre-build script
+except NameError:
+    env = None
+
+if env is None:
+    main(sys.argv[1:])
+else:
+    generate(env.subst("$PROJECT_DIR"),
+             {key: float(env.GetProjectOption("custom_ntc_" + key, value)) for key, value in DEFAULTS.items()})
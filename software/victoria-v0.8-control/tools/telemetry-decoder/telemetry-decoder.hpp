@@ -0,0 +1,147 @@
+//
+//  Open-Boiler Control - Victoria 20-20 T/F boiler control
+//  Author: Gustavo Casanova
+//  ........................................................
+//  File: telemetry-decoder.hpp (host-side binary telemetry decoder)
+//  ........................................................
+//  Version: 0.8 "Easter Quarantine" / 2020-04-09
+//  gustavo.casanova@nicebots.com
+//  ........................................................
+//
+//  Header-only, C++17. Decodes the COBS-framed, CRC-16 packets sent by
+//  lib/telemetry (SERIAL_TELEMETRY). Frames are decoded in place in the
+//  caller's buffer and exposed through TelemetryView, which reads the
+//  fields straight from that buffer: no copies, no allocations.
+//
+
+#ifndef OPEN_BOILER_TELEMETRY_DECODER_HPP
+#define OPEN_BOILER_TELEMETRY_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace open_boiler {
+
+constexpr std::uint8_t kTelemetryVersion = 3;     // TELEMETRY_VERSION
+constexpr std::size_t kTelemetryDataLength = 66;  // TELEMETRY_DATA_LENGTH
+constexpr std::size_t kProfilerBuckets = 8;       // PROFILER_BUCKETS
+constexpr std::size_t kTelemetryPacketLength = kTelemetryDataLength + 2;
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), same as avr-libc _crc_xmodem_update from 0xFFFF
+inline std::uint16_t Crc16CcittFalse(const std::uint8_t *data, std::size_t length) {
+    std::uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < length; i++) {
+        crc ^= static_cast<std::uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? static_cast<std::uint16_t>((crc << 1) ^ 0x1021) : static_cast<std::uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Decodes a COBS block (without its 0x00 delimiter) in place, returns the decoded length or 0 if the block is malformed
+inline std::size_t CobsDecodeInPlace(std::uint8_t *data, std::size_t length) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < length) {
+        std::uint8_t code = data[in++];
+        if ((code == 0) || (in + code - 1 > length)) {
+            return 0;
+        }
+        for (std::uint8_t i = 1; i < code; i++) {
+            data[out++] = data[in++];
+        }
+        if ((code < 0xFF) && (in < length)) {
+            data[out++] = 0;
+        }
+    }
+    return out;
+}
+
+// Read-only view over a decoded, CRC-checked telemetry packet
+class TelemetryView {
+  public:
+    explicit TelemetryView(const std::uint8_t *packet) : p_(packet) {}
+
+    std::uint8_t version() const { return p_[0]; }
+    std::uint8_t sequence() const { return p_[1]; }
+    std::uint32_t uptime_ms() const { return Long(2); }
+    std::uint8_t system_state() const { return p_[6]; }
+    std::uint8_t inner_step() const { return p_[7]; }
+    std::uint8_t input_flags() const { return p_[8]; }
+    std::uint8_t output_flags() const { return p_[9]; }
+    std::uint16_t dhw_temperature_adc() const { return Word(10); }
+    std::uint16_t ch_temperature_adc() const { return Word(12); }
+    std::uint16_t dhw_setting_adc() const { return Word(14); }
+    std::uint16_t ch_setting_adc() const { return Word(16); }
+    std::uint16_t system_mode_adc() const { return Word(18); }
+    std::uint8_t heat_level() const { return p_[20]; }
+    std::uint8_t current_valve() const { return p_[21]; }
+    std::uint8_t error() const { return p_[22]; }
+    std::uint8_t ignition_tries() const { return p_[23]; }
+    std::uint32_t flame_seconds() const { return Long(24); }
+    std::uint32_t kcal() const { return Long(28); }
+    std::uint32_t gas_litres() const { return Long(32); }
+    std::uint32_t ignitions() const { return Long(36); }
+    std::uint16_t ignition_failures() const { return Word(40); }
+    std::uint16_t short_cycles() const { return Word(42); }
+    std::uint16_t pass_min_us() const { return Word(44); }  // Task loop profile, 0 without LOOP_PROFILER
+    std::uint16_t pass_avg_us() const { return Word(46); }
+    std::uint16_t pass_max_us() const { return Word(48); }
+    std::uint16_t pass_bucket(std::size_t bucket) const { return (bucket < kProfilerBuckets) ? Word(50 + (bucket * 2)) : 0; }
+
+  private:
+    std::uint16_t Word(std::size_t at) const { return static_cast<std::uint16_t>(p_[at] | (p_[at + 1] << 8)); }
+    std::uint32_t Long(std::size_t at) const { return Word(at) | (static_cast<std::uint32_t>(Word(at + 2)) << 16); }
+    const std::uint8_t *p_;
+};
+
+// Receive counters
+struct TelemetryStats {
+    std::uint32_t frames = 0;        // Valid packets
+    std::uint32_t bad_frames = 0;    // Malformed COBS, wrong length, CRC or version
+    std::uint32_t lost_frames = 0;   // Gaps in the sequence counter
+    bool have_sequence = false;
+    std::uint8_t last_sequence = 0;
+};
+
+// Decodes every complete frame in [data, data + size) in place and calls on_frame(TelemetryView) for each valid one.
+// Returns the bytes consumed; the rest is the start of an incomplete frame, keep it in front of the next read.
+template <typename OnFrame>
+std::size_t DecodeTelemetry(std::uint8_t *data, std::size_t size, OnFrame &&on_frame, TelemetryStats *stats = nullptr) {
+    std::size_t frame_start = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            continue;
+        }
+        if (i == frame_start) {
+            frame_start = i + 1;
+            continue;  // Empty block between delimiters
+        }
+        std::size_t length = CobsDecodeInPlace(data + frame_start, i - frame_start);
+        const std::uint8_t *packet = data + frame_start;
+        frame_start = i + 1;
+        bool valid = (length == kTelemetryPacketLength) && (packet[0] == kTelemetryVersion) &&
+                     (Crc16CcittFalse(packet, kTelemetryDataLength) ==
+                      static_cast<std::uint16_t>(packet[kTelemetryDataLength] | (packet[kTelemetryDataLength + 1] << 8)));
+        if (!valid) {
+            if (stats) stats->bad_frames++;
+            continue;
+        }
+        TelemetryView view(packet);
+        if (stats) {
+            if (stats->have_sequence) {
+                stats->lost_frames += static_cast<std::uint8_t>(view.sequence() - stats->last_sequence - 1);
+            }
+            stats->have_sequence = true;
+            stats->last_sequence = view.sequence();
+            stats->frames++;
+        }
+        on_frame(view);
+    }
+    return frame_start;
+}
+
+}  // namespace open_boiler
+
+#endif  // OPEN_BOILER_TELEMETRY_DECODER_HPP
@@ -0,0 +1,55 @@
+//
+//  Open-Boiler Control - Victoria 20-20 T/F boiler control
+//  Author: Gustavo Casanova
+//  ........................................................
+//  File: telemetry-dump.cpp (telemetry stream to CSV)
+//  ........................................................
+//  Version: 0.8 "Easter Quarantine" / 2020-04-09
+//  gustavo.casanova@nicebots.com
+//  ........................................................
+//
+//  Build: g++ -std=c++17 -O2 -o telemetry-dump telemetry-dump.cpp
+//  Usage: stty -F /dev/ttyUSB0 57600 raw && ./telemetry-dump < /dev/ttyUSB0
+//
+
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry-decoder.hpp"
+
+int main() {
+    static std::uint8_t buffer[4096];
+    std::size_t pending = 0;
+    open_boiler::TelemetryStats stats;
+
+    std::printf("uptime_ms,seq,state,step,iflags,oflags,dhw_temp_adc,ch_temp_adc,dhw_set_adc,ch_set_adc,mode_adc,heat_level,valve,error,tries,flame_s,kcal,gas_l,ignitions,ign_failures,short_cycles,pass_min_us,pass_avg_us,pass_max_us,pass_hist\n");
+    for (;;) {
+        std::size_t got = std::fread(buffer + pending, 1, sizeof(buffer) - pending, stdin);
+        if (got == 0) {
+            break;
+        }
+        std::size_t size = pending + got;
+        std::size_t used = open_boiler::DecodeTelemetry(
+            buffer, size,
+            [](const open_boiler::TelemetryView &t) {
+                std::printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,",
+                            t.uptime_ms(), t.sequence(), t.system_state(), t.inner_step(), t.input_flags(), t.output_flags(),
+                            t.dhw_temperature_adc(), t.ch_temperature_adc(), t.dhw_setting_adc(), t.ch_setting_adc(),
+                            t.system_mode_adc(), t.heat_level(), t.current_valve(), t.error(), t.ignition_tries(),
+                            t.flame_seconds(), t.kcal(), t.gas_litres(), t.ignitions(), t.ignition_failures(), t.short_cycles(),
+                            t.pass_min_us(), t.pass_avg_us(), t.pass_max_us());
+                for (std::size_t bucket = 0; bucket < open_boiler::kProfilerBuckets; bucket++) {
+                    std::printf((bucket == 0) ? "%u" : " %u", t.pass_bucket(bucket));
+                }
+                std::printf("\n");
+            },
+            &stats);
+        pending = size - used;
+        if (pending == sizeof(buffer)) {
+            pending = 0;  // No delimiter in a whole buffer, drop it and resync
+        }
+        std::memmove(buffer, buffer + used, pending);
+    }
+    std::fprintf(stderr, "frames: %u, bad: %u, lost: %u\n", stats.frames, stats.bad_frames, stats.lost_frames);
+    return 0;
+}